@@ -0,0 +1,26 @@
+/*
+    CRC-16/CCITT (polynomial 0x1021, start 0xFFFF) of a block of bytes, as used to check
+    the records kept in NVS.  Bit at a time, the records are a few dozen bytes and only
+    read at boot or written at a checkpoint.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef CRC16_H
+#define CRC16_H
+
+static inline uint16_t crc16(const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+}
+
+#endif  // CRC16_H
@@ -0,0 +1,45 @@
+/*
+    Draw command queue from any task to the display task.
+
+    Only the display task draws, it owns the TFT and the SPI bus for a whole frame.  Any
+    other task that wants something on the screen posts a small command with
+    drawQueuePost(), which copies it into a fixed ring and returns straight away, it
+    never waits for the display or for another producer.  The display task takes the
+    commands in batches with drawQueueTake() between frames and carries them out in the
+    order they were posted.  When the ring is full the command is dropped and counted.
+
+    Live values don't go through here, they are coalesced by the telemetry channel
+    (telemetry.h) so a slow frame only ever sees the latest of each.  Commands are for
+    things that must not be coalesced away, a log line or a page change.
+
+    The first post after a take calls the notify function given to drawQueueBegin(), so
+    a burst of posts wakes the display task once.
+*/
+
+#include <Arduino.h>
+
+#ifndef DRAW_QUEUE_H
+#define DRAW_QUEUE_H
+
+#define DRAW_QUEUE_LENGTH 16            // Commands, a power of 2
+#define DRAW_TEXT_LENGTH 44             // As a log entry, with the null
+
+typedef enum {
+    DRAW_LOG,                           // Add text to the log
+    DRAW_PAGE                           // Show page value, PAGE_xxx
+} drawCommandType_t;
+
+typedef struct {
+    uint8_t type;                       // drawCommandType_t
+    uint8_t source;                     // Free for the poster, e.g. which task
+    int32_t value;
+    char text[DRAW_TEXT_LENGTH];
+} drawCommand_t;
+
+void drawQueueBegin(void (*notify)(void));
+bool drawQueuePost(const drawCommand_t *command);
+bool drawQueueLog(const char *text);
+uint32_t drawQueueTake(drawCommand_t *commands, uint32_t max);
+void drawQueueReport(Print &out);
+
+#endif  // DRAW_QUEUE_H
@@ -0,0 +1,73 @@
+/*
+    Energy integration for the daily and running kWh totals.
+
+    Timestamped power samples are integrated with the trapezoid rule into 64 bit fixed
+    point accumulators in mJ (W x ms), so no floating point is used and a year of 4 kW
+    doesn't come close to overflowing.  The totals are read back in whole Wh, ready for
+    telemetry_t.
+
+    Gaps between samples longer than ENERGY_MAX_GAP are not integrated, nothing is known
+    about the power over them.  A sample interval that spans local midnight is split at
+    midnight, the power there interpolated, and the daily totals start again.  The totals
+    are checkpointed to NVS every ENERGY_CHECKPOINT_PERIOD and at midnight rather than on
+    every sample to spare the flash, so a reset loses at most one period.
+
+    Time is the wall clock in ms since 1970 (gettimeofday()).  Until it has been set, e.g.
+    by SNTP, days run from boot and the daily totals aren't restored after a reset.
+*/
+
+#include <Arduino.h>
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#define ENERGY_CHANNELS 4
+#define ENERGY_SOLAR 0                  // Generated
+#define ENERGY_WATER 1                  // Into the immersion heater
+#define ENERGY_IMPORT 2                 // From the grid
+#define ENERGY_EXPORT 3                 // To the grid
+
+#define ENERGY_MAX_GAP 60000            // ms, longer gaps between samples are not integrated
+#define ENERGY_CHECKPOINT_PERIOD (15 * 60 * 1000)   // ms between NVS checkpoints
+#define ENERGY_CLOCK_SET 1704067200000LL    // 2024-01-01, earlier wall clock times are time since boot
+#define ENERGY_MJ_PER_WH 3600000ULL
+
+#define ENERGY_NAMESPACE "energy"       // NVS namespace and key of the real totals
+#define ENERGY_KEY "totals"
+#define ENERGY_VERSION 1                // Bump if the record layout changes
+
+typedef struct {
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t day;                       // Local date of today[], yyyymmdd
+    uint64_t today[ENERGY_CHANNELS];    // mJ since midnight
+    uint64_t total[ENERGY_CHANNELS];    // mJ since the first boot
+    uint16_t crc;                       // CRC-16/CCITT of everything before it
+} energyRecord_t;
+
+class EnergyMeter {
+    energyRecord_t totals;
+    int64_t lastTime;                   // Time of the last sample, 0 before the first
+    int32_t lastPower[ENERGY_CHANNELS];
+    int64_t midnight;                   // Next local midnight
+    int64_t lastCheckpoint;
+    bool dirty;                         // Changed since the last checkpoint
+    uint32_t gaps;                      // Intervals not integrated
+    const char *nvsNamespace;           // Where the checkpoints go
+public:
+    EnergyMeter();
+    void begin(int64_t now, const char *nvsNamespace = ENERGY_NAMESPACE);
+    bool addSample(int64_t time, const int32_t power[ENERGY_CHANNELS]);
+    bool checkpoint(int64_t now, bool force = false);
+    uint32_t todayWh(uint8_t channel) { return totals.today[channel] / ENERGY_MJ_PER_WH; };
+    uint32_t totalKWh(uint8_t channel) { return totals.total[channel] / (ENERGY_MJ_PER_WH * 1000); };
+    uint32_t getGaps(void) { return gaps; };
+    void report(Print &out);
+private:
+    void integrate(int64_t duration, const int32_t from[ENERGY_CHANNELS], const int32_t to[ENERGY_CHANNELS]);
+    void startDay(int64_t time);
+};
+
+int64_t energyClock(void);
+
+#endif  // ENERGY_H
@@ -0,0 +1,64 @@
+/*
+    Small, fast pseudo random numbers for the screen effects.
+
+    A 32 bit xorshift generator, three shifts and three XORs a number, where Arduino's
+    random() goes through the C library with a division for every value.  Each effect
+    keeps its own generator, seeded from esp_random() on the ESP32 and from a fixed seed
+    on the host, so a host run draws exactly the same frames every time.
+
+    Numbers in a range are scaled by multiplying, not with %, so there is no division.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef FAST_RANDOM_H
+#define FAST_RANDOM_H
+
+#define FAST_RANDOM_DEFAULT_SEED 2463534242UL   // xorshift can't start from 0
+
+class FastRandom {
+    uint32_t state;
+public:
+    FastRandom(uint32_t seed = FAST_RANDOM_DEFAULT_SEED) { this->seed(seed); };
+
+    void seed(uint32_t seed) { state = seed ? seed : FAST_RANDOM_DEFAULT_SEED; };
+
+    uint32_t next(void) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    // 0 to range - 1, range up to 65536
+    uint32_t below(uint32_t range) { return ((next() >> 16) * range) >> 16; };
+
+    // min to max - 1, as Arduino's random(min, max)
+    int32_t between(int32_t min, int32_t max) { return min + (int32_t)below(max - min); };
+
+    // A byte from fill() scaled to 0 to range - 1, range up to 256
+    static uint8_t scale(uint8_t byte, uint16_t range) { return (byte * range) >> 8; };
+
+    // Fill a batch of random bytes, four from each number
+    void fill(uint8_t *bytes, size_t count) {
+        while (count >= 4) {
+            uint32_t r = next();
+            bytes[0] = r >> 24;
+            bytes[1] = r >> 16;
+            bytes[2] = r >> 8;
+            bytes[3] = r;
+            bytes += 4;
+            count -= 4;
+        }
+        if (count > 0) {
+            uint32_t r = next();
+            while (count-- > 0) {
+                *bytes++ = r >> 24;
+                r <<= 8;
+            }
+        }
+    };
+};
+
+#endif  // FAST_RANDOM_H
@@ -0,0 +1,59 @@
+/*
+    Smooth (anti-aliased) font support.
+
+    The .vlw fonts live in their own "fonts" data partition (see partitions.csv) and are
+    memory mapped, so TFT_eSPI reads the glyph bitmaps straight out of flash through the
+    cache instead of copying them into RAM.  Use tools/mkfontpart.py to build the
+    partition image from one or more .vlw files and flash it with esptool.
+
+    Partition layout (little endian):
+        FontPartitionHeader
+        FontPartitionEntry[count]
+        font data...
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+
+#ifndef FONT_PARTITION_H
+#define FONT_PARTITION_H
+
+#define FONT_PARTITION_NAME     "fonts"
+#define FONT_PARTITION_SUBTYPE  0x40        // Custom data partition subtype
+#define FONT_PARTITION_MAGIC    0x50574C56  // "VLWP"
+#define FONT_PARTITION_VERSION  1
+#define FONT_NAME_LENGTH        16
+
+struct FontPartitionHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;         // Number of FontPartitionEntry records following the header
+};
+
+struct FontPartitionEntry {
+    char name[FONT_NAME_LENGTH];    // Null terminated font name, e.g. "value"
+    uint32_t offset;                // Offset of the .vlw data from the start of the partition
+    uint32_t size;                  // Size of the .vlw data in bytes
+};
+
+bool fontPartitionBegin(void);
+const uint8_t *fontPartitionFind(const char *name);
+
+/*
+    Cache of the glyph advances used by the live values (digits, '.', ' ', 'k', 'W', 'h').
+    TFT_eSPI looks every glyph up with a linear search of the font's unicode table, the
+    cache lets us size a value before drawing it without paying for that search twice.
+*/
+#define HOT_GLYPH_FIRST 0x20
+#define HOT_GLYPH_LAST  0x7E
+
+class HotGlyphCache {
+    uint8_t advance[HOT_GLYPH_LAST - HOT_GLYPH_FIRST + 1];  // 0 = not cached
+    TFT_eSPI *gfx;                                          // Object with the font loaded
+public:
+    HotGlyphCache() : gfx(NULL) { memset(advance, 0, sizeof(advance)); };
+    void build(TFT_eSPI *fontOwner, const char *glyphs);
+    int16_t textWidth(const char *text);
+};
+
+#endif  // FONT_PARTITION_H
@@ -0,0 +1,37 @@
+/*
+    Memory and stack telemetry.
+
+    A low priority sampler task records the free heap, the minimum free heap since boot,
+    the largest free block and the free stack of every task into a fixed ring, so the
+    last MEM_TELEMETRY_SAMPLES samples can be dumped at any time with memTelemetryDump().
+    Free heap falling while the largest block falls faster is fragmentation, sprites need
+    one contiguous block and createSprite() fails once there isn't one big enough.
+
+    A warning is printed when the largest free block first drops below the size given to
+    memTelemetryBegin().
+*/
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "taskConfig.h"
+
+#ifndef MEM_TELEMETRY_H
+#define MEM_TELEMETRY_H
+
+#define MEM_TELEMETRY_SAMPLES 32        // Ring size
+#define MEM_TELEMETRY_TASKS 12          // Tasks tracked, the first seen
+#define MEM_TELEMETRY_TASK_STACK 2560   // Core and priority in taskConfig.h
+
+typedef struct {
+    uint32_t time;                      // Seconds since boot
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;               // Lowest free heap since boot
+    uint32_t largestBlock;              // Largest block that can be allocated
+    uint16_t stackFree[MEM_TELEMETRY_TASKS];    // Least free stack (bytes), 0 if the task wasn't running
+} memSample_t;
+
+bool memTelemetryBegin(uint32_t period, uint32_t warnBlock);
+void memTelemetryDump(Print &out);
+
+#endif  // MEM_TELEMETRY_H
@@ -0,0 +1,76 @@
+/*
+    Cache of the static layer of each page of the UI.
+
+    A page's static layer (background, tabs, drawings and fixed labels) is drawn once at
+    boot, a band of rows at a time into a small sprite, and kept run length encoded by
+    row, in PSRAM if the board has it.  Switching page then restores the new page's static
+    layer from the cache instead of drawing it again from primitives, and only sends the
+    pixels that differ from the page being left plus the areas that page drew over its own
+    static layer (its live values, chart etc.).  The new page then draws its live content.
+    Spans up to PAGE_CACHE_GAP pixels apart are sent in one address window, the pixels
+    between them are already the new page's colour and cost less to resend than another
+    window.  Each span is expanded from its runs into a line buffer and sent with one
+    pushPixels(), and a window is set running to the bottom of the screen so the same
+    span on the rows below (a rectangle of live content) carries on without another.
+
+    The panel takes ~90 ms to fill at 27 MHz, sending only the difference is what keeps a
+    page switch well under that.
+
+    PAGE_CACHE_GAP weighs a window, 11 bytes on the bus plus the CPU time of setting it
+    and starting another push, against resending 2 bytes a pixel.  16 is an estimate of
+    that CPU time.  The host counts only bus bytes, so there a gap of 16 costs 0.8 ms more
+    bus time than 5 when switching to the History page, and saves 392 of its 993 windows.
+    Check it on the board with -DSPI_PROFILER, comparing showPage's time across gaps.
+
+    The four pages take ~86 KB.  Without PSRAM that comes out of internal RAM, so a page
+    is only kept if the largest free internal block is still PAGE_CACHE_RESERVE after it,
+    for the sprites, WiFi and the radio.  Pages are captured in order, so the dashboard is
+    the last to go, and a page that isn't kept is drawn from primitives when shown.
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+#include "spiProfiler.h"
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#define PAGE_CACHE_PAGES 4
+#define PAGE_CACHE_BAND 16              // Rows drawn at a time when capturing a page
+#define PAGE_NONE 0xFF                  // Screen contents unknown, restore everything
+#define PAGE_DIRTY_MAX 24               // Areas of live content a page can have
+#define PAGE_CACHE_GAP 16               // Pixels between spans cheaper to resend than a new window, see above
+#define PAGE_CACHE_LINE 480             // Widest row, the panel's long side
+#define PAGE_CACHE_RESERVE 65536        // Largest internal RAM block to leave free without PSRAM
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+} pageRect_t;
+
+typedef struct {
+    uint16_t colour;
+    uint16_t length;
+} pageRun_t;
+
+// Draw the static layer of a page in screen coordinates
+typedef void (*pageDraw_t)(TFT_eSPI *gfx);
+
+class PageCache {
+    SpiProfiledTFT *tft;
+    pageRun_t *runs[PAGE_CACHE_PAGES];      // Runs of each page, row by row
+    uint32_t *rowStart[PAGE_CACHE_PAGES];   // Index of the first run of each row, and the end
+    uint32_t runCount[PAGE_CACHE_PAGES];
+public:
+    PageCache(SpiProfiledTFT *tft);
+    bool capture(uint8_t page, pageDraw_t draw);
+    bool cached(uint8_t page) { return page < PAGE_CACHE_PAGES && runs[page] != NULL; };
+    uint32_t restore(uint8_t page, uint8_t from, const pageRect_t *dirty, uint8_t dirtyCount);
+    size_t size(uint8_t page);
+private:
+    bool addRun(uint8_t page, uint32_t *capacity, uint32_t caps, uint16_t colour, uint16_t length);
+};
+
+#endif  // PAGE_CACHE_H
@@ -0,0 +1,64 @@
+/*
+    Scrolling power history chart for solar, grid and water heating power.
+
+    Samples are folded into min/max columns, samplesPerColumn samples to a screen column,
+    kept in a ring of CHART_WIDTH columns.  The chart sprite holds the rendered columns in
+    the same ring order, so a new sample only renders the one column it lands in and the
+    chart scrolls by pushing the sprite in two parts, oldest column first.  pushLatest()
+    sends only that column, CHART_HEIGHT pixels, unless the sample started a new column
+    and the chart has to scroll.  Memory and the work per sample stay the same however
+    long the history is; only a change of range redraws every column.  The range grows to
+    fit a bigger sample and shrinks again when the column that needed it scrolls off.
+
+    The panel can't be read back (no MISO) or scroll a window, hence the sprite.
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+#include "spiProfiler.h"
+
+#ifndef POWER_CHART_H
+#define POWER_CHART_H
+
+#define CHART_WIDTH 190                 // Columns, one per pixel
+#define CHART_HEIGHT 80
+#define CHART_ZERO_Y (CHART_HEIGHT * 3 / 4)     // 0 W row, export (negative) below it
+#define CHART_RANGE_STEP 1000           // W, the top of the chart is a whole number of these
+#define CHART_SERIES 3
+#define CHART_SOLAR 0
+#define CHART_GRID 1
+#define CHART_WATER 2
+
+#define CHART_BACKGROUND TFT_BLACK
+#define CHART_LINE_COLOUR TFT_DARKGREY  // 0 W and every CHART_RANGE_STEP
+
+typedef struct {
+    int16_t min[CHART_SERIES];          // W
+    int16_t max[CHART_SERIES];
+} chartColumn_t;
+
+class PowerChart {
+    SpiProfiledSprite sprite;           // Rendered columns, in the same ring order as columns[]
+    chartColumn_t columns[CHART_WIDTH]; // Ring of finished columns
+    chartColumn_t current;              // Column being filled, drawn at head
+    uint16_t head;                      // Ring index of the column being filled
+    uint16_t count;                     // Finished columns in the ring
+    uint16_t samples;                   // Samples in current
+    uint16_t samplesPerColumn;
+    int32_t range;                      // W at the top of the chart
+    bool scrolled;                      // Last sample moved the chart on or redrew it all
+public:
+    PowerChart(TFT_eSPI *tft);
+    bool begin(uint16_t samplesPerColumn);
+    bool addSample(int32_t solar, int32_t grid, int32_t water);
+    void push(int32_t x, int32_t y);
+    void pushLatest(int32_t x, int32_t y);
+    int32_t getRange(void) { return range; };
+private:
+    void render(void);
+    uint16_t rightColumn(void);
+    void renderColumn(uint16_t index, const chartColumn_t *column);
+    int16_t toY(int32_t watts);
+};
+
+#endif  // POWER_CHART_H
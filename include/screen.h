@@ -0,0 +1,86 @@
+/*
+    Drawing for the monitor screen: the pages (dashboard, history, log and settings) with
+    their cached static layers, flow animations, live values, log area and the two screen
+    savers, matrix and pixel shift.
+
+    Kept apart from main.cpp (tasks, touch, SPI bus and boot) so it only depends on
+    TFT_eSPI, cLog and the font partition, which lets the same file be built for the
+    host framebuffer emulator (env:native, see lib/HostSim).
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+#include "spiProfiler.h"
+#include "telemetry.h"
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#define TFT_GREY    0x5AEB
+#define TFT_TEAL    0x028A      // RGB 00 80 80
+#define TFT_GREEN_ENERGY    0x1d85  // RGB 3 44 5
+
+#define TFT_BACKGROUND 0x3189 // 0x2969 // 0x4a31 // TFT_BLACK
+#define TFT_FOREGROUND TFT_WHITE
+#define TFT_WATERTANK_HOT TFT_RED
+#define TFT_WATERTANK_COLD TFT_BLUE
+#define TFT_WATERTANK_WARM TFT_PURPLE
+
+#define CHART_SAMPLE_PERIOD 2000        // ms between power chart samples
+#define CHART_SAMPLES_PER_COLUMN 15     // 30 seconds a column, 95 minutes across the chart
+
+// Pages, switched with the tabs along the top or by swiping
+#define PAGE_DASHBOARD 0
+#define PAGE_HISTORY 1
+#define PAGE_LOG 2
+#define PAGE_SETTINGS 3
+#define PAGE_COUNT 4
+#define PAGE_TAB_WIDTH 120
+#define PAGE_TAB_HEIGHT 22
+#define PAGE_SWITCH_TARGET 50           // ms
+#define FRAME_PERIOD 50                 // ms between animation frames, what a frame may draw in
+
+// Pixel shift screen saver, the dashboard stays up and moves side to side
+#define PIXEL_SHIFT_RANGE 4             // Pixels either side at most
+#define PIXEL_SHIFT_PERIOD 30000        // ms between moves of a pixel
+
+// Live values, font/textSize are the built-in font fallback if there are no smooth fonts
+typedef struct {
+    int x;
+    int y;
+    int font;
+    int textSize;
+    bool total;             // Use the larger total font
+    int16_t lastWidth;      // Width pushed last time so a shorter value clears the old one
+} valueField_t;
+
+extern SpiProfiledTFT tft;
+
+extern bool smoothFonts;            // true when the font partition fonts are loaded
+extern bool screenSaverActive;      // Is the screen saver active or not
+
+void createSprites(void);
+bool loadSmoothFonts(void);
+bool createPages(void);
+void initialiseScreen(void);
+uint32_t showPage(uint8_t newPage);
+uint8_t currentPage(void);
+void drawValue(valueField_t *field, const char *text);
+void timeValues(uint32_t *smoothTime, uint32_t *builtInTime);
+void showTelemetry(const telemetry_t *values, uint32_t changed);
+void chartSample(void);
+void showMessage(String msg, int x, int y, int textSize, int font);
+void updateLog(const char *msg);
+bool animation(void);
+bool animationStep(void);
+bool animationDraw(void);
+bool animationActive(void);
+void startScreenSaver(void);
+void matrix(void);
+void matrixSeed(uint32_t seed);
+void startPixelShift(void);
+void pixelShift(void);
+void stopPixelShift(void);
+bool pixelShifting(void);
+
+#endif  // SCREEN_H
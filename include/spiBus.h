@@ -0,0 +1,49 @@
+/*
+    SPI bus arbitration for the display and touch controller, which share VSPI.
+
+    Each client acquires the bus before using it and releases it afterwards.  A client's
+    begin/end hooks run while it holds the bus, the display uses them to wrap everything it
+    draws in one startWrite()/endWrite() so the bus stays configured and CS asserted for
+    back-to-back display transactions instead of per draw call.
+
+    A client can reserve the bus for a future time (the display's next frame).  A client
+    with a gapTime, the touch reader, is only given the bus if it can finish before the
+    next reservation, otherwise it waits until the reserving client has had its turn.  This
+    schedules touch reads into the gaps between frames.
+
+    The time each client held the bus and waited for it are kept and printed by
+    spiBusReport().  Hold time is from acquire to release, so it includes the CPU work a
+    client does while it holds the bus (the display holds it for a whole frame), it is
+    an upper bound on the time the bus was busy, not the time spent transferring.
+*/
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+#define SPI_BUS_MAX_DEFER 50000     // Never defer a gap client for longer than 50ms (µs)
+
+typedef enum {
+    SPI_CLIENT_DISPLAY,
+    SPI_CLIENT_TOUCH,
+    SPI_CLIENT_COUNT
+} spiClient_t;
+
+typedef struct {
+    const char *name;
+    void (*begin)(void);        // Called once the bus is acquired, may be NULL
+    void (*end)(void);          // Called before the bus is released, may be NULL
+    uint32_t gapTime;           // µs needed on the bus, 0 to not wait for gaps
+} spiClientConfig_t;
+
+bool spiBusBegin(const spiClientConfig_t *clients);
+void spiBusAcquire(spiClient_t client);
+void spiBusRelease(spiClient_t client);
+void spiBusReserve(spiClient_t client, int64_t at);
+void spiBusReport(Print &out);
+
+#endif  // SPI_BUS_H
@@ -0,0 +1,180 @@
+/*
+    Per-frame SPI profiler for the screen code, built in with -DSPI_PROFILER.
+
+    Drawing code marks its call sites with SPI_PROFILE("site"), which charges everything
+    drawn until the end of the enclosing block to that site (nested sites are charged
+    separately, a site's figures exclude the sites it calls).  SPI_PROFILE_FRAME() closes
+    a frame, normally once per pass of the display loop.  Only drawing inside a site is
+    counted.
+
+    For each site and frame the profiler keeps the calls, time taken, the address windows,
+    pixels and bytes sent and the estimated bus time at SPI_FREQUENCY.  Windows rather than
+    transactions are counted because the display task holds one transaction for the whole
+    frame with startWrite(), so a site inside it never starts one.
+
+    The host emulator (lib/HostSim) counts exactly what it sends.  On the ESP32 TFT_eSPI
+    has no hooks for it, so the screen code draws on the panel through SpiProfiledTFT and
+    SpiProfiledSprite, which count the windows and pixels of the calls it makes
+    (setAddrWindow(), pushColor(), pushPixels(), pushSprite(), the rectangles, lines and
+    characters) as TFT_eSPI would send them.  Lines, characters and transparent sprites
+    are estimates, e.g. a character counts as one window of its whole cell.  Without
+    SPI_PROFILER, and on the host, they are plain TFT_eSPI and TFT_eSprite.
+
+    Not thread safe, only the display task may draw.  Without SPI_PROFILER the macros are
+    empty and there is no cost.
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+
+#ifndef SPI_PROFILER_H
+#define SPI_PROFILER_H
+
+#define SPI_PROFILE_SITES 16        // Distinct call sites
+#define SPI_PROFILE_HISTORY 32      // Frames kept for the report
+#define SPI_PROFILE_WINDOW_BYTES 11 // CASET + 4 bytes, PASET + 4 bytes, RAMWR, as the host
+#define SPI_PROFILE_PIXEL_BYTES 2   // 16 bit colour
+
+typedef struct {
+    uint32_t windows;               // Address windows set
+    uint64_t pixels;
+    uint64_t bytes;
+    int64_t time;                   // µs
+} spiProfileCounters_t;
+
+typedef struct {
+    const char *name;
+    uint32_t calls;
+    spiProfileCounters_t total;
+} spiProfileSite_t;
+
+typedef struct {
+    uint32_t number;                // Frame number since the last reset
+    spiProfileCounters_t total;
+} spiProfileFrame_t;
+
+void spiProfilerBegin(TFT_eSPI *tft);
+void spiProfileEnter(const char *site);
+void spiProfileLeave(void);
+void spiProfileFrameEnd(void);
+void spiProfileReport(Print &out, bool listFrames);
+void spiProfileReset(void);
+void spiProfileCount(uint32_t windows, uint32_t pixels);
+
+class SpiProfileScope {
+public:
+    SpiProfileScope(const char *site) { spiProfileEnter(site); }
+    ~SpiProfileScope() { spiProfileLeave(); }
+};
+
+#if defined(SPI_PROFILER) && !defined(HOST_SIM)
+/*
+    Panel counting what the screen code sends.  TFT_eSPI's drawing primitives are virtual
+    so they are counted wherever they are called from, e.g. a fillCircle() as its lines,
+    only the outermost call is counted so a primitive built from others isn't counted
+    twice.  The pixel pushing calls aren't virtual and are only counted when made on
+    this class.
+*/
+class SpiProfiledTFT : public TFT_eSPI {
+    uint8_t depth = 0;              // Primitives in progress
+public:
+    using TFT_eSPI::TFT_eSPI;
+    using TFT_eSPI::drawChar;
+    using TFT_eSPI::pushColor;
+
+    void drawPixel(int32_t x, int32_t y, uint32_t color) override {
+        count(1, 1);
+        TFT_eSPI::drawPixel(x, y, color);
+        depth--;
+    }
+    void drawLine(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint32_t color) override {
+        uint32_t dx = abs(xe - xs), dy = abs(ye - ys);
+        count(min(dx, dy) + 1, max(dx, dy) + 1);   // a run per step of the shorter side
+        TFT_eSPI::drawLine(xs, ys, xe, ye, color);
+        depth--;
+    }
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) override {
+        count(1, max(w, (int32_t)0));
+        TFT_eSPI::drawFastHLine(x, y, w, color);
+        depth--;
+    }
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) override {
+        count(1, max(h, (int32_t)0));
+        TFT_eSPI::drawFastVLine(x, y, h, color);
+        depth--;
+    }
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override {
+        count(1, w > 0 && h > 0 ? (uint32_t)w * h : 0);
+        TFT_eSPI::fillRect(x, y, w, h, color);
+        depth--;
+    }
+    void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size) override {
+        count(1, 6 * 8 * size * size);
+        TFT_eSPI::drawChar(x, y, c, color, bg, size);
+        depth--;
+    }
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font) override {
+        bool outer = depth++ == 0;
+        int16_t width = TFT_eSPI::drawChar(uniCode, x, y, font);
+        depth--;
+        if (outer)
+            spiProfileCount(1, max(width, (int16_t)0) * fontHeight(font));
+        return width;
+    }
+
+    void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h) {
+        spiProfileCount(1, 0);
+        TFT_eSPI::setAddrWindow(x, y, w, h);
+    }
+    void pushColor(uint16_t color, uint32_t len) {
+        spiProfileCount(0, len);
+        TFT_eSPI::pushColor(color, len);
+    }
+    void pushPixels(const void *data, uint32_t len) {
+        spiProfileCount(0, len);
+        TFT_eSPI::pushPixels(data, len);
+    }
+
+private:
+    // Count a primitive if it is the outermost, the caller decrements depth when done
+    void count(uint32_t windows, uint32_t pixels) {
+        if (depth++ == 0)
+            spiProfileCount(windows, pixels);
+    }
+};
+
+/*
+    Sprite counting what it pushes to the panel, drawing into the sprite costs nothing.
+    A transparent push counts a window per row.
+*/
+class SpiProfiledSprite : public TFT_eSprite {
+public:
+    using TFT_eSprite::TFT_eSprite;
+
+    void pushSprite(int32_t x, int32_t y) {
+        spiProfileCount(1, (uint32_t)width() * height());
+        TFT_eSprite::pushSprite(x, y);
+    }
+    void pushSprite(int32_t x, int32_t y, uint16_t transparent) {
+        spiProfileCount(height(), (uint32_t)width() * height());
+        TFT_eSprite::pushSprite(x, y, transparent);
+    }
+    bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh) {
+        spiProfileCount(1, sw > 0 && sh > 0 ? (uint32_t)sw * sh : 0);
+        return TFT_eSprite::pushSprite(tx, ty, sx, sy, sw, sh);
+    }
+};
+#else
+typedef TFT_eSPI SpiProfiledTFT;
+typedef TFT_eSprite SpiProfiledSprite;
+#endif
+
+#ifdef SPI_PROFILER
+#define SPI_PROFILE(site) SpiProfileScope spiProfileScope(site)
+#define SPI_PROFILE_FRAME() spiProfileFrameEnd()
+#else
+#define SPI_PROFILE(site)
+#define SPI_PROFILE_FRAME()
+#endif
+
+#endif  // SPI_PROFILER_H
@@ -0,0 +1,58 @@
+/*
+    Task topology, the core and priority of every task in one place.
+
+    The ESP32's WiFi and Bluetooth stacks run on the PRO core (0) at priorities of 18 and
+    up, and the radio will too, so anything talking to the outside world goes on IO_CORE.
+    Drawing and the touch reader that feeds it go on RENDER_CORE (1), where the only
+    other work is the Arduino loop() at priority 1, so network traffic can't hold up a
+    frame.  Within each core the short, latency sensitive task gets the higher priority.
+
+        RENDER_CORE     touch reader (3), display (2), loop() (1)
+        IO_CORE         WiFi/BT (18+), demo sender/radio (2), energy meter (1),
+                        memory telemetry (1)
+
+    Any of the cores can be overridden with -D, e.g. -DDISPLAY_TASK_CORE=tskNO_AFFINITY to
+    let the scheduler choose.  Build with -DTASK_JITTER_BENCH to time the animation frames
+    at boot with a simulated network load on each core in turn.
+*/
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#define IO_CORE 0                   // PRO core, WiFi, BT and the radio
+#define RENDER_CORE 1               // APP core, drawing and touch
+
+#ifndef DISPLAY_TASK_CORE
+#define DISPLAY_TASK_CORE RENDER_CORE
+#endif
+#define DISPLAY_TASK_PRIORITY (tskIDLE_PRIORITY + 2)    // Above loop()
+
+#ifndef TOUCH_TASK_CORE
+#define TOUCH_TASK_CORE RENDER_CORE
+#endif
+#define TOUCH_TASK_PRIORITY (tskIDLE_PRIORITY + 3)      // A read is ~200us, take it on time
+
+#ifndef SENDER_TASK_CORE
+#define SENDER_TASK_CORE IO_CORE
+#endif
+#define SENDER_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+#ifndef ENERGY_TASK_CORE
+#define ENERGY_TASK_CORE IO_CORE
+#endif
+#define ENERGY_TASK_PRIORITY (tskIDLE_PRIORITY + 1)     // NVS writes, nothing waits on it
+
+#ifndef MEM_TELEMETRY_TASK_CORE
+#define MEM_TELEMETRY_TASK_CORE IO_CORE
+#endif
+#define MEM_TELEMETRY_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+// Simulated network load for -DTASK_JITTER_BENCH, bursts of CPU at WiFi's priority
+#define NET_LOAD_PRIORITY 19
+#define NET_LOAD_BURST 3000         // us busy
+#define NET_LOAD_PERIOD 10          // ms between bursts, 30% of a core
+
+#endif  // TASK_CONFIG_H
@@ -0,0 +1,33 @@
+/*
+    FreeRTOS run time statistics, printed on demand by taskStatsReport(): CPU use of each
+    task, the load on each core and each task's stack high water mark.
+
+    CPU use is for the period since the previous report (since boot for the first one).  The
+    load of a core is the time its idle task did not run.
+
+    Per task CPU use needs configGENERATE_RUN_TIME_STATS, which the prebuilt arduino-esp32
+    sdkconfig leaves off, it takes an ESP-IDF build (framework = arduino, espidf) with
+    CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS set.  Without it the cpu column shows "-" and
+    the load of each core is measured here instead: taskStatsBegin() adds an idle hook on
+    each core that adds up the time between its calls.  The hook keeps the idle task
+    spinning rather than waiting for an interrupt, so a gap longer than TASK_STATS_IDLE_GAP
+    is another task running.
+
+    The task list is read into a static buffer so a report allocates nothing, it can be
+    asked for while the heap is in trouble.
+*/
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#define TASK_STATS_MAX 24           // Most tasks that can be reported
+#define TASK_STATS_IDLE_GAP 20      // Longest idle loop, a longer gap was another task (us)
+
+bool taskStatsBegin(void);
+void taskStatsReport(Print &out);
+
+#endif  // TASK_STATS_H
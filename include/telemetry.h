@@ -0,0 +1,50 @@
+/*
+    Telemetry channel from the producer tasks (radio, network) to the display.
+
+    Producers publish readings with telemetryPublish() whenever they arrive, at any rate and
+    without blocking: each call overwrites the fields it carries, so only the latest value of
+    each field is kept and readings the display never got round to are coalesced away.  The
+    display task takes at most one snapshot per frame with telemetryTake(), a copy of every
+    field taken in one go together with the fields changed since the last snapshot, so a
+    frame never mixes readings from two publishes.  Other tasks can read the latest values
+    with telemetryRead() without taking them from the display.  Readers never block a
+    producer, see telemetry.cpp.
+
+    The first publish after a snapshot calls the notify function given to telemetryBegin(),
+    so a burst of publishes wakes the display task once.
+*/
+
+#include <Arduino.h>
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Fields of telemetry_t, used in the publish and changed masks
+#define TELEMETRY_SOLAR_POWER   (1 << 0)
+#define TELEMETRY_GRID_POWER    (1 << 1)
+#define TELEMETRY_WATER_POWER   (1 << 2)
+#define TELEMETRY_SOLAR_ENERGY  (1 << 3)
+#define TELEMETRY_WATER_ENERGY  (1 << 4)
+#define TELEMETRY_LQI           (1 << 5)
+#define TELEMETRY_BATTERY       (1 << 6)
+#define TELEMETRY_POWER (TELEMETRY_SOLAR_POWER | TELEMETRY_GRID_POWER | TELEMETRY_WATER_POWER)
+#define TELEMETRY_ENERGY (TELEMETRY_SOLAR_ENERGY | TELEMETRY_WATER_ENERGY)
+#define TELEMETRY_ALL   0x7F
+
+typedef struct {
+    int32_t solarPower;     // W generated now
+    int32_t gridPower;      // W, positive importing, negative exporting
+    int32_t waterPower;     // W into the immersion heater
+    uint32_t solarEnergy;   // Wh generated today
+    uint32_t waterEnergy;   // Wh used to heat water today
+    uint8_t lqi;            // Link quality of the sender
+    bool batteryOk;         // Sender battery
+} telemetry_t;
+
+void telemetryBegin(void (*notify)(void));
+void telemetryPublish(const telemetry_t *values, uint32_t fields);
+uint32_t telemetryTake(telemetry_t *snapshot);
+void telemetryRead(telemetry_t *values);
+void telemetryReport(Print &out);
+
+#endif  // TELEMETRY_H
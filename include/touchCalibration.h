@@ -0,0 +1,40 @@
+/*
+    Touch screen calibration store.
+
+    Calibration data (the 5 values used by TFT_eSPI::setTouch()) is kept in NVS with a
+    version and CRC so a corrupt or old record is never used.  It can also be compiled into
+    the firmware: tools/cal2header.py turns a captured "Touch calibration:" line into
+    include/touchCalBaked.h, which is picked up automatically if it exists.
+
+    At boot NVS is tried first, then the baked in data, and only if neither is valid does
+    the (blocking) on-screen calibration run.
+*/
+
+#include <Arduino.h>
+#include "TFT_eSPI.h"
+
+#ifndef TOUCH_CALIBRATION_H
+#define TOUCH_CALIBRATION_H
+
+#define TOUCH_CAL_NAMESPACE "touchcal"      // NVS namespace and key
+#define TOUCH_CAL_KEY "cal"
+#define TOUCH_CAL_VERSION 1                 // Bump if the record layout changes
+#define TOUCH_CAL_VALUES 5
+#define TOUCH_CAL_SAMPLES 8                 // Raw samples averaged per corner
+#define TOUCH_CAL_MARKER 15                 // Size of the corner markers
+
+typedef struct {
+    uint16_t version;
+    uint16_t data[TOUCH_CAL_VALUES];
+    uint16_t crc;                           // CRC-16/CCITT of version and data
+} touchCalRecord_t;
+
+// Read the raw touch position, true if touched with at least the given pressure
+typedef bool (*touchCalReadRaw_t)(uint16_t *x, uint16_t *y, uint16_t threshold);
+
+bool touchCalLoad(uint16_t data[TOUCH_CAL_VALUES]);
+bool touchCalSave(const uint16_t data[TOUCH_CAL_VALUES]);
+bool touchCalBaked(uint16_t data[TOUCH_CAL_VALUES]);
+void touchCalRun(TFT_eSPI *gfx, touchCalReadRaw_t readRaw, uint16_t threshold, uint16_t data[TOUCH_CAL_VALUES]);
+
+#endif  // TOUCH_CALIBRATION_H
@@ -0,0 +1,65 @@
+/*
+    Touch sample filtering and gesture recognition.
+
+    Raw touch samples are median filtered (3 samples) to remove the odd wild reading the
+    XPT2046 produces, then smoothed with a light IIR filter.  Gestures are recognised as
+    the samples arrive, nothing blocks or waits:
+
+        tap         pen down and up again without moving much
+        long press  pen held still for TOUCH_LONG_PRESS_TIME, reported while still held
+        swipe       pen moved at least TOUCH_SWIPE_DISTANCE before being lifted
+
+    Each gesture carries the time of the first sample of the touch and the time of the
+    sample that completed it, so latency from first sample to event can be measured.
+*/
+
+#include <stdint.h>
+
+#ifndef TOUCH_GESTURE_H
+#define TOUCH_GESTURE_H
+
+#define TOUCH_DEBOUNCE_TIME 20          // Touches shorter than this (ms, first to last pen down sample) are ignored
+#define TOUCH_TAP_MOVE 12               // Max movement (pixels) for a tap or long press
+#define TOUCH_LONG_PRESS_TIME 800       // ms
+#define TOUCH_SWIPE_DISTANCE 60         // Min movement (pixels) along the main axis for a swipe
+#define TOUCH_IIR_SHIFT 1               // IIR filter weight, new = old + (sample - old) / 2^n
+
+typedef enum {
+    TOUCH_TAP,
+    TOUCH_LONG_PRESS,
+    TOUCH_SWIPE_LEFT,
+    TOUCH_SWIPE_RIGHT,
+    TOUCH_SWIPE_UP,
+    TOUCH_SWIPE_DOWN
+} touchGestureType_t;
+
+typedef struct {
+    touchGestureType_t type;
+    uint16_t x;             // Filtered position where the touch started
+    uint16_t y;
+    uint32_t start;         // Time of the first sample of the touch
+    uint32_t time;          // Time of the sample that completed the gesture
+} touchGesture_t;
+
+class TouchGestureEngine {
+    uint16_t rawX[3];       // Last three samples for the median filter
+    uint16_t rawY[3];
+    uint8_t rawCount;
+    int32_t filteredX;      // IIR filter output, fixed point with TOUCH_IIR_SHIFT fraction bits
+    int32_t filteredY;
+    uint16_t startX;        // First filtered position of the touch
+    uint16_t startY;
+    uint32_t startTime;
+    uint32_t lastDownTime;  // Time of the latest pen down sample, the pen up one comes later
+    bool down;              // A touch is in progress
+    bool longPressSent;     // Long press already reported for this touch, nothing else will be
+    bool moved;             // Moved too far for a tap or long press
+public:
+    TouchGestureEngine();
+    bool update(uint16_t x, uint16_t y, uint32_t time, bool penDown, touchGesture_t *gesture);
+    bool touching(void) { return down; };
+private:
+    void filter(uint16_t x, uint16_t y, uint16_t *outX, uint16_t *outY);
+};
+
+#endif  // TOUCH_GESTURE_H
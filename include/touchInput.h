@@ -0,0 +1,52 @@
+/*
+    Touch input pipeline.
+
+    The pen IRQ (T_IRQ) wakes a reader task which samples the touch controller while the
+    screen is being touched and queues the samples for the display task, so the render
+    loop never polls the touch controller.  Without T_IRQ the reader task polls instead.
+
+    The touch controller is reached through a touchSource_t, the pipeline itself only uses
+    FreeRTOS.  A simulated source calling touchInputIrq() can drive it without hardware,
+    the host build does with the FreeRTOS stand-ins in lib/HostSim.
+*/
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "taskConfig.h"
+
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#define TOUCH_QUEUE_LENGTH 16           // Samples waiting for the display task
+#define TOUCH_SAMPLE_INTERVAL 10        // Sample every 10ms while the pen is down
+#define TOUCH_POLL_INTERVAL 30          // Poll every 30ms for a touch without T_IRQ
+#define TOUCH_RELEASE_SAMPLES 2         // Missed samples in a row before the pen is up
+#define TOUCH_TASK_STACK 2048           // Core and priority in taskConfig.h
+
+typedef struct {
+    uint16_t x;             // Screen coordinates, only valid when down
+    uint16_t y;
+    uint32_t time;          // millis() the sample was taken
+    bool down;              // false for the single pen up sample ending a touch
+} touchSample_t;
+
+typedef struct {
+    // Read the touch controller, true with the sample filled in if the pen is down.
+    // Responsible for any bus locking it needs.
+    bool (*read)(touchSample_t *sample);
+    // Called after samples have been queued, e.g. to wake the display task. May be NULL.
+    void (*notify)(void);
+    // Time source for the pen up sample, normally millis().
+    uint32_t (*now)(void);
+} touchSource_t;
+
+bool touchInputBegin(const touchSource_t *source, bool irqDriven);
+void touchInputEnd(void);
+void touchInputIrq(void);
+void touchInputIrqFromISR(void);
+bool touchInputRead(touchSample_t *sample);
+uint32_t touchInputOverruns(void);
+
+#endif  // TOUCH_INPUT_H
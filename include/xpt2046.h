@@ -0,0 +1,26 @@
+/*
+    Minimal XPT2046 touch controller driver for when the touch controller has its own SPI
+    host (TOUCH_SEPARATE_SPI) and can't go through TFT_eSPI's touch functions, which always
+    use the display's bus.  Raw values match TFT_eSPI's getTouchRaw()/getTouchRawZ() so
+    its calibration and convertRawXY() still apply.
+*/
+
+#include <Arduino.h>
+#include <SPI.h>
+
+#ifndef XPT2046_H
+#define XPT2046_H
+
+#define XPT2046_FREQUENCY 2500000   // Same as TFT_eSPI's SPI_TOUCH_FREQUENCY
+
+class XPT2046 {
+    SPIClass spi;
+    int8_t sclkPin, misoPin, mosiPin, csPin;
+public:
+    XPT2046(uint8_t spiHost, int8_t sclk, int8_t miso, int8_t mosi, int8_t cs);
+    void begin(void);
+    uint16_t readZ(void);
+    void readXY(uint16_t *x, uint16_t *y);
+};
+
+#endif  // XPT2046_H
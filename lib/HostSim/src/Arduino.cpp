@@ -0,0 +1,179 @@
+/*
+    Host stand-in for the Arduino core, see Arduino.h.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+static int64_t hostClock = 0;           // Simulated time in microseconds
+static uint32_t randomState = 1;
+
+// Real time mode, the clock is hostClock when it was switched on plus the time since
+static std::atomic<bool> realTime(false);
+static std::chrono::steady_clock::time_point realStart;
+static thread_local int64_t busyUntil = 0;     // When this thread's bus time is spent
+
+uint32_t millis(void) {
+    return (uint32_t)(hostClockTime() / 1000);
+}
+
+uint32_t micros(void) {
+    return (uint32_t)hostClockTime();
+}
+
+void delay(uint32_t ms) {
+    if (realTime) {
+        hostClockSettle();
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        return;
+    }
+    hostClock += (int64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+    hostClockAdvance(us);
+}
+
+/**
+ * @brief Move the simulated clock on, e.g. by a frame period between animation ticks.
+ * In real time mode the calling thread spends the time instead.
+ *
+ * @param us Microseconds to advance
+ */
+void hostClockAdvance(int64_t us) {
+    if (!realTime) {
+        hostClock += us;
+        return;
+    }
+
+    int64_t now = hostClockTime();
+    busyUntil = max(busyUntil, now) + us;
+    if (busyUntil - now >= HOSTSIM_REAL_SLEEP_MIN)
+        std::this_thread::sleep_for(std::chrono::microseconds(busyUntil - now));
+}
+
+int64_t hostClockTime(void) {
+    if (realTime) {
+        return hostClock + std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - realStart).count();
+    }
+    return hostClock;
+}
+
+/**
+ * @brief Make the clock follow the wall clock from now on, or go back to simulated time
+ * carrying on from where the wall clock got to. Switch with no other threads running.
+ *
+ * @param on true for real time
+ */
+void hostClockRealTime(bool on) {
+    if (on == realTime)
+        return;
+
+    if (on) {
+        realStart = std::chrono::steady_clock::now();
+        busyUntil = 0;
+        realTime = true;
+    } else {
+        hostClock = hostClockTime();
+        realTime = false;
+    }
+}
+
+bool hostClockRealTimeOn(void) {
+    return realTime;
+}
+
+/**
+ * @brief Real time mode, spend any bus time this thread still owes, e.g. before it
+ * blocks.
+ */
+void hostClockSettle(void) {
+    if (!realTime)
+        return;
+
+    int64_t now = hostClockTime();
+    if (busyUntil > now)
+        std::this_thread::sleep_for(std::chrono::microseconds(busyUntil - now));
+}
+
+void randomSeed(uint32_t seed) {
+    randomState = seed ? seed : 1;
+}
+
+long random(long max) {
+    if (max <= 0)
+        return 0;
+
+    randomState = randomState * 1103515245 + 12345;
+    return (long)((randomState >> 8) % (uint32_t)max);
+}
+
+long random(long min, long max) {
+    if (min >= max)
+        return min;
+
+    return min + random(max - min);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+
+    while (size--)
+        n += write(*buffer++);
+
+    return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+    char buf[256];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+
+    if (len < 0)
+        return 0;
+    if ((size_t)len < sizeof(buf))
+        return write((const uint8_t *)buf, len);
+
+    std::string big(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&big[0], big.size(), format, args);
+    va_end(args);
+
+    return write((const uint8_t *)big.c_str(), len);
+}
+
+size_t Print::print(long value, int base) {
+    if (base == 10)
+        return printf("%ld", value);
+
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+
+    if (base < 2)
+        base = 10;
+
+    *p = '\0';
+    do {
+        unsigned digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value);
+
+    return write(p);
+}
+
+size_t Print::print(double value, int digits) {
+    return printf("%.*f", digits, value);
+}
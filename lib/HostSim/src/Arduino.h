@@ -0,0 +1,123 @@
+/*
+    Host stand-in for the parts of the Arduino core used by the screen code, so it can be
+    built and run on a workstation (env:native).
+
+    Time is simulated: millis(), micros() and esp_timer_get_time() return a clock that
+    only moves on delay(), hostClockAdvance() or by the bus time of what is sent to the
+    panel, so a scenario draws the same frames every run.  random() is a fixed LCG seeded by randomSeed() for the same reason.
+
+    hostClockRealTime(true) switches the clock to follow the wall clock instead, for code
+    run on several threads with the FreeRTOS task stand-ins (freertos/task.h).  The bus
+    time is then really spent, by the thread sending, as it is on the ESP32 where the CPU
+    waits for the SPI transfer.  A thread's bus time is slept off in blocks of at least
+    HOSTSIM_REAL_SLEEP_MIN, or before it blocks (hostClockSettle()).
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "esp_attr.h"
+
+#ifndef HOSTSIM_ARDUINO_H
+#define HOSTSIM_ARDUINO_H
+
+#define HOST_SIM 1
+#define HOSTSIM_REAL_SLEEP_MIN 500      // us, shortest sleep for bus time in real time mode
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#define HIGH 1
+#define LOW  0
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Simulated clock
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void hostClockAdvance(int64_t us);
+int64_t hostClockTime(void);
+void hostClockRealTime(bool on);
+bool hostClockRealTimeOn(void);
+void hostClockSettle(void);
+
+// Deterministic random()
+void randomSeed(uint32_t seed);
+long random(long max);
+long random(long min, long max);
+
+class String {
+    std::string s;
+public:
+    String() {}
+    String(const char *str) : s(str ? str : "") {}
+    String(const std::string &str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+    String(double value, unsigned int decimals = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+        s = buf;
+    }
+
+    const char *c_str(void) const { return s.c_str(); }
+    unsigned int length(void) const { return s.length(); }
+    char operator[](unsigned int index) const { return index < s.length() ? s[index] : 0; }
+    String &operator+=(const String &rhs) { s += rhs.s; return *this; }
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs.s + rhs.s); }
+    bool operator==(const String &rhs) const { return s == rhs.s; }
+    bool operator!=(const String &rhs) const { return s != rhs.s; }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(const String &str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value, int base = 10) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(double value, int digits = 2);
+
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+    void flush(void) { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
+
+#endif  // HOSTSIM_ARDUINO_H
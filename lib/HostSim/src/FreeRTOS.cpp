@@ -0,0 +1,468 @@
+/*
+    Host stand-ins for FreeRTOS tasks, notifications, queues, semaphores and event groups,
+    see freertos/task.h, queue.h, semphr.h and event_groups.h.
+*/
+
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arduino.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+struct hostTask {
+    const char *name;
+    std::thread thread;
+    int64_t started;
+    std::atomic<int64_t> ended;     // 0 while running
+    std::atomic<int64_t> blocked;   // us spent waiting
+    std::atomic<bool> deleted;      // By another task, ends at its next wait
+    std::mutex notifyLock;
+    std::condition_variable notified;
+    uint32_t notifyCount;
+};
+
+struct hostQueue {
+    std::mutex lock;
+    std::condition_variable sent;
+    std::condition_variable received;
+    std::vector<uint8_t> items;     // Ring of length items
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t first;
+    UBaseType_t waiting;
+};
+
+struct hostSemaphore {
+    std::mutex lock;
+    std::condition_variable given;
+    UBaseType_t count;
+};
+
+struct hostEventGroup {
+    std::mutex lock;
+    std::condition_variable set;
+    EventBits_t bits;
+};
+
+class HostTaskExit {};              // Thrown by vTaskDelete() to end the thread
+
+static std::mutex tasksLock;
+static std::vector<std::unique_ptr<hostTask>> tasks;    // Kept so handles stay valid
+static thread_local hostTask *currentTask = NULL;
+
+static void taskRun(hostTask *task, TaskFunction_t function, void *parameter);
+static void taskDeletedCheck(void);
+
+
+static void taskRun(hostTask *task, TaskFunction_t function, void *parameter) {
+    currentTask = task;
+    try {
+        function(parameter);
+    } catch (const HostTaskExit &) {
+    }
+    hostClockSettle();
+    task->ended = hostClockTime();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter,
+    UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, handle, tskNO_AFFINITY);
+}
+
+/**
+ * @brief Start a thread for the task, the stack depth, priority and core are ignored.
+ *
+ * @return BaseType_t pdPASS
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth,
+    void *parameter, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+    hostTask *task = new hostTask;
+
+    task->name = name;
+    task->started = hostClockTime();
+    task->ended = 0;
+    task->blocked = 0;
+    task->deleted = false;
+    task->notifyCount = 0;
+    {
+        std::lock_guard<std::mutex> guard(tasksLock);
+        tasks.emplace_back(task);
+        task->thread = std::thread(taskRun, task, function, parameter);
+    }
+
+    if (handle != NULL)
+        *handle = task;
+    return pdPASS;
+}
+
+/**
+ * @brief End a task. The calling task ends straight away, another task ends at its next
+ * wait, as a thread can't be stopped from outside. hostTasksJoin() waits for it.
+ *
+ * @param task NULL for the calling task
+ */
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == currentTask)
+        throw HostTaskExit();
+
+    std::lock_guard<std::mutex> guard(task->notifyLock);
+    task->deleted = true;
+    task->notified.notify_all();
+}
+
+/**
+ * @brief End the calling task if another task has deleted it.
+ */
+static void taskDeletedCheck(void) {
+    if (currentTask != NULL && currentTask->deleted)
+        throw HostTaskExit();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    hostClockSettle();
+    int64_t start = hostClockTime();
+    delay(ticks * portTICK_PERIOD_MS);
+    hostTaskBlocked(hostClockTime() - start);
+    taskDeletedCheck();
+}
+
+/**
+ * @brief Wait until increment ticks after the last wake, for a fixed period whatever the
+ * time spent working.
+ *
+ * @param previousWake Last wake, moved on by increment
+ * @param increment Period in ticks
+ */
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t increment) {
+    *previousWake += increment;
+    int32_t wait = (int32_t)(*previousWake - xTaskGetTickCount());
+    if (wait > 0)
+        vTaskDelay(wait);
+}
+
+/**
+ * @brief Give the task a notification, as a counting semaphore.
+ *
+ * @param task Task to notify
+ * @return BaseType_t pdPASS
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> guard(task->notifyLock);
+    task->notifyCount++;
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken) {
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken != NULL)
+        *higherPriorityTaskWoken = pdFALSE;
+}
+
+/**
+ * @brief Wait up to ticks for a notification to the calling task, in real time mode.
+ *
+ * @param clearOnExit pdTRUE to take every notification, pdFALSE for one
+ * @param ticks Longest wait, portMAX_DELAY for ever
+ * @return uint32_t Notifications before taking, 0 if timed out
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    hostTask *task = currentTask;
+    uint32_t count;
+
+    if (task == NULL)
+        return 0;
+
+    hostClockSettle();
+    std::unique_lock<std::mutex> guard(task->notifyLock);
+    if (task->notifyCount == 0 && ticks > 0 && hostClockRealTimeOn()) {
+        auto ready = [task] { return task->notifyCount > 0 || task->deleted; };
+        int64_t start = hostClockTime();
+
+        if (ticks == portMAX_DELAY)
+            task->notified.wait(guard, ready);
+        else
+            task->notified.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+        hostTaskBlocked(hostClockTime() - start);
+    }
+    if (task->deleted)
+        throw HostTaskExit();
+
+    count = task->notifyCount;
+    if (count > 0)
+        task->notifyCount = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(hostClockTime() / (1000 * portTICK_PERIOD_MS));
+}
+
+/**
+ * @brief Time the task has spent not blocked, running or spending bus time, since it was
+ * created and until it ended.
+ *
+ * @param task Handle from xTaskCreate()
+ * @return int64_t Microseconds
+ */
+int64_t hostTaskBusyTime(TaskHandle_t task) {
+    int64_t end = task->ended ? task->ended.load() : hostClockTime();
+    return end - task->started - task->blocked;
+}
+
+/**
+ * @brief Count time the calling task spent waiting, for waits outside the stand-ins.
+ *
+ * @param us Microseconds
+ */
+void hostTaskBlocked(int64_t us) {
+    if (currentTask != NULL)
+        currentTask->blocked += us;
+}
+
+/**
+ * @brief Wait for every task created so far to end. Their handles stay valid.
+ */
+void hostTasksJoin(void) {
+    std::lock_guard<std::mutex> guard(tasksLock);
+
+    for (auto &task : tasks) {
+        if (task->thread.joinable())
+            task->thread.join();
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    hostQueue *queue = new hostQueue;
+
+    queue->items.resize((size_t)length * itemSize);
+    queue->length = length;
+    queue->itemSize = itemSize;
+    queue->first = queue->waiting = 0;
+    return queue;
+}
+
+/**
+ * @brief Copy an item to the back of the queue, waiting up to ticks for space in real time
+ * mode.
+ *
+ * @param queue Queue
+ * @param item Copied in, the queue's item size
+ * @param ticks Longest wait, portMAX_DELAY for ever
+ * @return BaseType_t pdTRUE queued, errQUEUE_FULL if there was no space
+ */
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+
+    if (queue->waiting == queue->length && ticks > 0 && hostClockRealTimeOn()) {
+        auto space = [queue] { return queue->waiting < queue->length; };
+        int64_t start = hostClockTime();
+
+        if (ticks == portMAX_DELAY)
+            queue->received.wait(guard, space);
+        else
+            queue->received.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), space);
+        hostTaskBlocked(hostClockTime() - start);
+    }
+
+    if (queue->waiting == queue->length)
+        return errQUEUE_FULL;
+
+    UBaseType_t back = (queue->first + queue->waiting) % queue->length;
+    memcpy(&queue->items[(size_t)back * queue->itemSize], item, queue->itemSize);
+    queue->waiting++;
+    queue->sent.notify_one();
+    return pdTRUE;
+}
+
+/**
+ * @brief Copy out the item at the front of the queue, waiting up to ticks for one in real
+ * time mode.
+ *
+ * @param queue Queue
+ * @param item Filled in, the queue's item size
+ * @param ticks Longest wait, portMAX_DELAY for ever
+ * @return BaseType_t pdTRUE received, pdFALSE the queue was empty
+ */
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(queue->lock);
+
+    if (queue->waiting == 0 && ticks > 0 && hostClockRealTimeOn()) {
+        auto ready = [queue] { return queue->waiting > 0; };
+        int64_t start = hostClockTime();
+
+        if (ticks == portMAX_DELAY)
+            queue->sent.wait(guard, ready);
+        else
+            queue->sent.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+        hostTaskBlocked(hostClockTime() - start);
+    }
+
+    if (queue->waiting == 0)
+        return pdFALSE;
+
+    memcpy(item, &queue->items[(size_t)queue->first * queue->itemSize], queue->itemSize);
+    queue->first = (queue->first + 1) % queue->length;
+    queue->waiting--;
+    queue->received.notify_one();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return queue->waiting;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->first = queue->waiting = 0;
+    queue->received.notify_all();
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    hostSemaphore *semaphore = new hostSemaphore;
+    semaphore->count = 0;           // Created empty, as FreeRTOS
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    hostSemaphore *semaphore = new hostSemaphore;
+    semaphore->count = 1;
+    return semaphore;
+}
+
+/**
+ * @brief Take the semaphore, waiting up to ticks for it in real time mode.
+ *
+ * @param semaphore Semaphore
+ * @param ticks Longest wait, portMAX_DELAY for ever
+ * @return BaseType_t pdTRUE taken, pdFALSE timed out
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+
+    if (semaphore->count == 0 && ticks > 0 && hostClockRealTimeOn()) {
+        guard.unlock();
+        hostClockSettle();
+        guard.lock();
+
+        int64_t start = hostClockTime();
+        if (ticks == portMAX_DELAY) {
+            semaphore->given.wait(guard, [semaphore] { return semaphore->count > 0; });
+        } else {
+            semaphore->given.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS),
+                [semaphore] { return semaphore->count > 0; });
+        }
+        hostTaskBlocked(hostClockTime() - start);
+    }
+
+    if (semaphore->count == 0)
+        return pdFALSE;
+
+    semaphore->count--;
+    return pdTRUE;
+}
+
+/**
+ * @brief Give the semaphore, waking a task waiting for it.
+ *
+ * @return BaseType_t pdFALSE if it was already given
+ */
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> guard(semaphore->lock);
+
+    if (semaphore->count > 0)
+        return pdFALSE;
+
+    semaphore->count++;
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    hostEventGroup *group = new hostEventGroup;
+    group->bits = 0;
+    return group;
+}
+
+/**
+ * @brief Set bits, waking the tasks waiting for them.
+ *
+ * @return EventBits_t The bits once set
+ */
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    group->bits |= bits;
+    group->set.notify_all();
+    return group->bits;
+}
+
+/**
+ * @brief Clear bits.
+ *
+ * @return EventBits_t The bits before they were cleared
+ */
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> guard(group->lock);
+    return group->bits;
+}
+
+/**
+ * @brief Wait up to ticks for any or all of the bits to be set, in real time mode.
+ *
+ * @param bits Bits to wait for
+ * @param clearOnExit pdTRUE to clear the bits waited for if the wait succeeded
+ * @param waitForAll pdTRUE to wait for all the bits, pdFALSE for any of them
+ * @param ticks Longest wait, portMAX_DELAY for ever
+ * @return EventBits_t The bits when the wait ended, before any were cleared
+ */
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+    BaseType_t waitForAll, TickType_t ticks) {
+    auto ready = [group, bits, waitForAll] {
+        return waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+
+    hostClockSettle();
+    std::unique_lock<std::mutex> guard(group->lock);
+    if (!ready() && ticks > 0 && hostClockRealTimeOn()) {
+        int64_t start = hostClockTime();
+
+        if (ticks == portMAX_DELAY)
+            group->set.wait(guard, ready);
+        else
+            group->set.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+        hostTaskBlocked(hostClockTime() - start);
+    }
+
+    EventBits_t result = group->bits;
+    if (ready() && clearOnExit)
+        group->bits &= ~bits;
+    return result;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
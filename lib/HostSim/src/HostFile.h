@@ -0,0 +1,24 @@
+/*
+    Print to a file on the host, so reports written for Serial can be saved as well.
+*/
+
+#include <Arduino.h>
+
+#ifndef HOSTSIM_HOST_FILE_H
+#define HOSTSIM_HOST_FILE_H
+
+class HostFile : public Print {
+    FILE *file;
+public:
+    HostFile() : file(NULL) {}
+    ~HostFile() { close(); }
+
+    bool open(const char *path, const char *mode = "w") { close(); file = fopen(path, mode); return file != NULL; }
+    void close(void) { if (file != NULL) fclose(file); file = NULL; }
+    void flush(void) { if (file != NULL) fflush(file); }
+    size_t write(uint8_t c) override { return file != NULL && fputc(c, file) != EOF ? 1 : 0; }
+    size_t write(const uint8_t *buffer, size_t size) override { return file != NULL ? fwrite(buffer, 1, size, file) : 0; }
+    using Print::write;
+};
+
+#endif  // HOSTSIM_HOST_FILE_H
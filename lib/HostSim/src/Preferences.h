@@ -0,0 +1,57 @@
+/*
+    Host stand-in for the ESP32 Preferences (NVS) library.  Namespaces live in memory for
+    the life of the program, enough to check that what is saved loads again.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef HOSTSIM_PREFERENCES_H
+#define HOSTSIM_PREFERENCES_H
+
+class Preferences {
+    typedef std::map<std::string, std::vector<uint8_t>> keys_t;
+    keys_t *keys = NULL;
+    bool readOnly = true;
+
+    static std::map<std::string, keys_t> &store(void) {
+        static std::map<std::string, keys_t> namespaces;
+        return namespaces;
+    }
+
+public:
+    bool begin(const char *name, bool readOnly = false) {
+        if (readOnly && store().count(name) == 0)
+            return false;   // as NVS, a read only namespace must already exist
+        keys = &store()[name];
+        this->readOnly = readOnly;
+        return true;
+    }
+
+    void end(void) { keys = NULL; }
+
+    size_t getBytes(const char *key, void *buf, size_t maxLen) {
+        if (keys == NULL || keys->count(key) == 0)
+            return 0;
+        const std::vector<uint8_t> &value = (*keys)[key];
+        if (value.size() > maxLen)
+            return 0;
+        memcpy(buf, value.data(), value.size());
+        return value.size();
+    }
+
+    size_t putBytes(const char *key, const void *value, size_t len) {
+        if (keys == NULL || readOnly)
+            return 0;
+        (*keys)[key].assign((const uint8_t *)value, (const uint8_t *)value + len);
+        return len;
+    }
+
+    bool remove(const char *key) { return keys != NULL && !readOnly && keys->erase(key) > 0; }
+};
+
+#endif  // HOSTSIM_PREFERENCES_H
@@ -0,0 +1,1046 @@
+/*
+    Host stand-in for TFT_eSPI, see TFT_eSPI.h for what is modelled.
+
+    The primitive implementations follow TFT_eSPI 2.4 so that a line, circle or string
+    produces the same number of address windows and pixel writes as on the ESP32.
+*/
+
+#include "TFT_eSPI.h"
+
+typedef struct {
+    uint8_t width;          // Advance, every glyph is the same width
+    uint8_t height;
+    uint8_t inkWidth;       // Area of the cell the placeholder glyph is drawn in
+    uint8_t inkHeight;
+} hostFont_t;
+
+static uint64_t busBytes = 0;          // Everything sent to any panel
+static int64_t busTimeCharged = 0;      // µs of it added to the simulated clock
+
+static const hostFont_t glcdFont = {6, 8, 5, 7};
+static const hostFont_t font2 = {8, 16, 7, 12};
+static const hostFont_t font4 = {14, 26, 12, 20};
+
+/*
+    Counts the SPI work done by the outermost public call on the panel, nested calls
+    (drawLine -> drawFastHLine -> fillRect) are charged to the call the sketch made.
+*/
+class HostCallScope {
+    TFT_eSPI *owner;
+public:
+    HostCallScope(TFT_eSPI *tft, const char *name) : owner(tft->onBus ? tft : NULL) {
+        if (owner != NULL && owner->callDepth++ == 0) {
+            owner->callName = name;
+            owner->callStart = owner->bus;
+        }
+    }
+
+    ~HostCallScope() {
+        if (owner == NULL || --owner->callDepth != 0)
+            return;
+
+        hostSpiStats_t *stats = &owner->calls[owner->callName];
+        stats->calls++;
+        stats->transactions += owner->bus.transactions - owner->callStart.transactions;
+        stats->windows += owner->bus.windows - owner->callStart.windows;
+        stats->pixels += owner->bus.pixels - owner->callStart.pixels;
+        stats->bytes += owner->bus.bytes - owner->callStart.bytes;
+        owner->bus.calls++;
+    }
+};
+
+static const hostFont_t *fontInfo(uint8_t font) {
+    if (font == 1)
+        return &glcdFont;
+    if (font == 4)
+        return &font4;
+
+    return &font2;
+}
+
+/**
+ * @brief Placeholder glyph, a block pattern that differs per character. Column 0 is
+ * always lit so every printable character leaves some ink.
+ *
+ * @return true Pixel (col, row) of the ink area is lit
+ */
+static bool glyphBit(uint16_t c, int32_t col, int32_t row, const hostFont_t *font) {
+    uint64_t hash;
+    int32_t gx, gy;
+
+    if (c <= ' ' || col >= font->inkWidth || row >= font->inkHeight)
+        return false;
+
+    gx = col * 5 / font->inkWidth;
+    gy = row * 7 / font->inkHeight;
+    if (gx == 0)
+        return true;
+
+    hash = (uint64_t)c * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+
+    return (hash >> (gy * 5 + gx)) & 1;
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _width(w), _height(h), onBus(true), initWidth(w), initHeight(h) {
+    vpW = w;
+    vpH = h;
+}
+
+/**
+ * @brief Allocate the framebuffer, cleared to black.
+ */
+void TFT_eSPI::init(void) {
+    pixels.assign((size_t)initWidth * initHeight, TFT_BLACK);
+    scrollLine = 0;
+    resetViewport();
+}
+
+/**
+ * @brief Landscape rotations swap width and height. The framebuffer is addressed in the
+ * current rotation, so anything already drawn is not remapped.
+ */
+void TFT_eSPI::setRotation(uint8_t r) {
+    rotation = r & 3;
+    if (rotation & 1) {
+        _width = initHeight;
+        _height = initWidth;
+    } else {
+        _width = initWidth;
+        _height = initHeight;
+    }
+
+    resetViewport();
+}
+
+void TFT_eSPI::startWrite(void) {
+    beginTftWrite();
+    lockTransaction = true;
+    inTransaction = true;
+}
+
+void TFT_eSPI::endWrite(void) {
+    lockTransaction = false;
+    inTransaction = false;
+    endTftWrite();
+}
+
+void TFT_eSPI::beginTftWrite(void) {
+    if (onBus && locked) {
+        locked = false;
+        bus.transactions++;
+    }
+}
+
+void TFT_eSPI::endTftWrite(void) {
+    if (!inTransaction && !locked)
+        locked = true;
+}
+
+/**
+ * @brief Send a command byte, the data bytes that follow go with it.
+ */
+void TFT_eSPI::writecommand(uint8_t c) {
+    HostCallScope scope(this, "writecommand");
+
+    command = c;
+    commandLength = 0;
+
+    beginTftWrite();
+    countBytes(1);
+    endTftWrite();
+}
+
+/**
+ * @brief Send a data byte for the last command. VSCRSADD takes effect with its second
+ * byte, VSCRDEF is only accepted for the whole panel so it changes nothing.
+ */
+void TFT_eSPI::writedata(uint8_t d) {
+    HostCallScope scope(this, "writedata");
+
+    if (commandLength < sizeof(commandData))
+        commandData[commandLength++] = d;
+    if (command == 0x37 && commandLength == 2)
+        scrollLine = ((commandData[0] << 8) | commandData[1]) % (rotation & 1 ? _width : _height);
+
+    beginTftWrite();
+    countBytes(1);
+    endTftWrite();
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum) {
+    xDatum = vpDatum ? x : 0;
+    yDatum = vpDatum ? y : 0;
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > _width) w = _width - x;
+    if (y + h > _height) h = _height - y;
+
+    vpX = x;
+    vpY = y;
+    vpW = max(w, (int32_t)0);
+    vpH = max(h, (int32_t)0);
+}
+
+void TFT_eSPI::resetViewport(void) {
+    vpX = vpY = 0;
+    vpW = _width;
+    vpH = _height;
+    xDatum = yDatum = 0;
+}
+
+/**
+ * @brief Move a rectangle to the viewport datum and clip it to the viewport.
+ */
+void TFT_eSPI::clipRect(int32_t *x, int32_t *y, int32_t *w, int32_t *h) {
+    *x += xDatum;
+    *y += yDatum;
+
+    if (*x < vpX) { *w -= vpX - *x; *x = vpX; }
+    if (*y < vpY) { *h -= vpY - *y; *y = vpY; }
+    if (*x + *w > vpX + vpW) *w = vpX + vpW - *x;
+    if (*y + *h > vpY + vpH) *h = vpY + vpH - *y;
+}
+
+void TFT_eSPI::countWindow(uint32_t count) {
+    if (!onBus)
+        return;
+
+    bus.windows++;
+    countBytes(HOSTSIM_WINDOW_BYTES);
+    countPixels(count);
+}
+
+/**
+ * @brief Count pixels streamed into the current address window.
+ */
+void TFT_eSPI::countPixels(uint32_t count) {
+    if (!onBus)
+        return;
+
+    bus.pixels += count;
+    countBytes((uint64_t)count * HOSTSIM_PIXEL_BYTES);
+}
+
+/**
+ * @brief Count bytes sent and move the simulated clock on by their time on the bus.
+ */
+void TFT_eSPI::countBytes(uint64_t bytes) {
+    if (!onBus)
+        return;
+
+    bus.bytes += bytes;
+
+    // Bus time, kept as a running total so the rounding doesn't add up
+    busBytes += bytes;
+    int64_t busTime = (int64_t)(busBytes * 8 * 1000000 / SPI_FREQUENCY);
+    hostClockAdvance(busTime - busTimeCharged);
+    busTimeCharged = busTime;
+}
+
+/**
+ * @brief Fill an already clipped rectangle, one address window.
+ */
+void TFT_eSPI::writeRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    if (w <= 0 || h <= 0)
+        return;
+
+    countWindow(w * h);
+    for (int32_t row = y; row < y + h; row++)
+        std::fill_n(&pixels[(size_t)row * _width + x], w, (uint16_t)color);
+}
+
+/**
+ * @brief Write an already clipped image, one address window.
+ */
+void TFT_eSPI::writeImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride, bool swap) {
+    if (w <= 0 || h <= 0)
+        return;
+
+    countWindow(w * h);
+    for (int32_t row = 0; row < h; row++, data += stride) {
+        uint16_t *out = &pixels[(size_t)(y + row) * _width + x];
+        for (int32_t col = 0; col < w; col++)
+            out[col] = swap ? (uint16_t)((data[col] << 8) | (data[col] >> 8)) : data[col];
+    }
+}
+
+/**
+ * @brief Write an already clipped image skipping the transparent colour, one address
+ * window per run of visible pixels as TFT_eSPI does.
+ */
+void TFT_eSPI::writeImageTransparent(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride, uint16_t transparent) {
+    for (int32_t row = 0; row < h; row++, data += stride) {
+        int32_t col = 0;
+        while (col < w) {
+            while (col < w && data[col] == transparent)
+                col++;
+
+            int32_t start = col;
+            while (col < w && data[col] != transparent)
+                col++;
+
+            writeImage(x + start, y + row, col - start, 1, data + start, stride, false);
+        }
+    }
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    HostCallScope scope(this, "drawPixel");
+    fillRect(x, y, 1, 1, color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+    HostCallScope scope(this, "drawFastHLine");
+    fillRect(x, y, w, 1, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+    HostCallScope scope(this, "drawFastVLine");
+    fillRect(x, y, 1, h, color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    HostCallScope scope(this, "fillRect");
+
+    clipRect(&x, &y, &w, &h);
+    if (w <= 0 || h <= 0)
+        return;
+
+    beginTftWrite();
+    writeRect(x, y, w, h, color);
+    endTftWrite();
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+    HostCallScope scope(this, "fillScreen");
+    fillRect(0, 0, _width, _height, color);
+}
+
+/**
+ * @brief Bresenham line drawn as horizontal or vertical runs, as TFT_eSPI does.
+ */
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+    HostCallScope scope(this, "drawLine");
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+    if (steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+
+    int32_t dx = x1 - x0, dy = abs(y1 - y0);
+    int32_t err = dx >> 1, ystep = -1, xs = x0, dlen = 0;
+
+    if (y0 < y1)
+        ystep = 1;
+
+    beginTftWrite();
+    inTransaction = true;
+
+    for (; x0 <= x1; x0++) {
+        dlen++;
+        err -= dy;
+        if (err < 0) {
+            if (steep)
+                drawFastVLine(y0, xs, dlen, color);
+            else
+                drawFastHLine(xs, y0, dlen, color);
+            dlen = 0;
+            y0 += ystep;
+            xs = x0 + 1;
+            err += dx;
+        }
+    }
+    if (dlen) {
+        if (steep)
+            drawFastVLine(y0, xs, dlen, color);
+        else
+            drawFastHLine(xs, y0, dlen, color);
+    }
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    HostCallScope scope(this, "drawRect");
+
+    beginTftWrite();
+    inTransaction = true;
+
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y + 1, h - 2, color);
+    drawFastVLine(x + w - 1, y + 1, h - 2, color);
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::drawCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornerName, uint32_t color) {
+    if (r <= 0)
+        return;
+
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -2 * r;
+    int32_t x = 0;
+
+    while (x < r) {
+        if (f >= 0) {
+            r--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+        if (cornerName & 0x4) {
+            drawPixel(x0 + x, y0 + r, color);
+            drawPixel(x0 + r, y0 + x, color);
+        }
+        if (cornerName & 0x2) {
+            drawPixel(x0 + x, y0 - r, color);
+            drawPixel(x0 + r, y0 - x, color);
+        }
+        if (cornerName & 0x8) {
+            drawPixel(x0 - r, y0 + x, color);
+            drawPixel(x0 - x, y0 + r, color);
+        }
+        if (cornerName & 0x1) {
+            drawPixel(x0 - r, y0 - x, color);
+            drawPixel(x0 - x, y0 - r, color);
+        }
+    }
+}
+
+void TFT_eSPI::fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornerName, int32_t delta, uint32_t color) {
+    int32_t f = 1 - r;
+    int32_t ddF_x = 1;
+    int32_t ddF_y = -r - r;
+    int32_t y = 0;
+
+    delta++;
+
+    while (y < r) {
+        if (f >= 0) {
+            if (cornerName & 0x1)
+                drawFastHLine(x0 - y, y0 + r, y + y + delta, color);
+            if (cornerName & 0x2)
+                drawFastHLine(x0 - y, y0 - r, y + y + delta, color);
+            r--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+
+        y++;
+        ddF_x += 2;
+        f += ddF_x;
+
+        if (cornerName & 0x1)
+            drawFastHLine(x0 - r, y0 + y, r + r + delta, color);
+        if (cornerName & 0x2)
+            drawFastHLine(x0 - r, y0 - y, r + r + delta, color);
+    }
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+    HostCallScope scope(this, "drawRoundRect");
+
+    beginTftWrite();
+    inTransaction = true;
+
+    drawFastHLine(x + r, y, w - r - r, color);
+    drawFastHLine(x + r, y + h - 1, w - r - r, color);
+    drawFastVLine(x, y + r, h - r - r, color);
+    drawFastVLine(x + w - 1, y + r, h - r - r, color);
+    drawCircleHelper(x + r, y + r, r, 1, color);
+    drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+    drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+    HostCallScope scope(this, "fillRoundRect");
+
+    beginTftWrite();
+    inTransaction = true;
+
+    fillRect(x, y + r, w, h - r - r, color);
+    fillCircleHelper(x + r, y + h - r - 1, r, 1, w - r - r - 1, color);
+    fillCircleHelper(x + r, y + r, r, 2, w - r - r - 1, color);
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    HostCallScope scope(this, "drawCircle");
+    int32_t f = 1 - r;
+    int32_t ddF_y = -2 * r;
+    int32_t ddF_x = 1;
+    int32_t xs = -1;
+    int32_t xe = 0;
+    int32_t len = 0;
+    bool first = true;
+
+    beginTftWrite();
+    inTransaction = true;
+
+    do {
+        while (f < 0) {
+            ++xe;
+            f += (ddF_x += 2);
+        }
+        f += (ddF_y += 2);
+
+        if (xe - xs > 1) {
+            if (first) {
+                len = 2 * (xe - xs) - 1;
+                drawFastHLine(x0 - xe, y0 + r, len, color);
+                drawFastHLine(x0 - xe, y0 - r, len, color);
+                drawFastVLine(x0 + r, y0 - xe, len, color);
+                drawFastVLine(x0 - r, y0 - xe, len, color);
+                first = false;
+            } else {
+                len = xe - xs++;
+                drawFastHLine(x0 - xe, y0 + r, len, color);
+                drawFastHLine(x0 - xe, y0 - r, len, color);
+                drawFastHLine(x0 + xs, y0 - r, len, color);
+                drawFastHLine(x0 + xs, y0 + r, len, color);
+
+                drawFastVLine(x0 + r, y0 + xs, len, color);
+                drawFastVLine(x0 + r, y0 - xe, len, color);
+                drawFastVLine(x0 - r, y0 - xe, len, color);
+                drawFastVLine(x0 - r, y0 + xs, len, color);
+            }
+        } else {
+            ++xs;
+            drawPixel(x0 - xe, y0 + r, color);
+            drawPixel(x0 - xe, y0 - r, color);
+            drawPixel(x0 + xs, y0 - r, color);
+            drawPixel(x0 + xs, y0 + r, color);
+
+            drawPixel(x0 + r, y0 + xs, color);
+            drawPixel(x0 + r, y0 - xe, color);
+            drawPixel(x0 - r, y0 - xe, color);
+            drawPixel(x0 - r, y0 + xs, color);
+        }
+        xs = xe;
+    } while (xe < --r);
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    HostCallScope scope(this, "fillCircle");
+    int32_t x = 0;
+    int32_t dx = 1;
+    int32_t dy = r + r;
+    int32_t p = -(r >> 1);
+
+    beginTftWrite();
+    inTransaction = true;
+
+    drawFastHLine(x0 - r, y0, dy + 1, color);
+
+    while (x < r) {
+        if (p >= 0) {
+            drawFastHLine(x0 - x, y0 + r, dx, color);
+            drawFastHLine(x0 - x, y0 - r, dx, color);
+            dy -= 2;
+            p -= dy;
+            r--;
+        }
+
+        dx += 2;
+        p += dx;
+        x++;
+
+        drawFastHLine(x0 - r, y0 + x, dy + 1, color);
+        drawFastHLine(x0 - r, y0 - x, dy + 1, color);
+    }
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+    HostCallScope scope(this, "drawTriangle");
+
+    beginTftWrite();
+    inTransaction = true;
+
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+/**
+ * @brief Filled triangle as horizontal lines, top to bottom.
+ */
+void TFT_eSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+    HostCallScope scope(this, "fillTriangle");
+    int32_t a, b, y, last;
+
+    // Sort coordinates by y order (y2 >= y1 >= y0)
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+
+    if (y0 == y2) {     // All on the same line
+        a = b = x0;
+        if (x1 < a) a = x1;
+        else if (x1 > b) b = x1;
+        if (x2 < a) a = x2;
+        else if (x2 > b) b = x2;
+        drawFastHLine(a, y0, b - a + 1, color);
+        return;
+    }
+
+    beginTftWrite();
+    inTransaction = true;
+
+    int32_t dx01 = x1 - x0, dy01 = y1 - y0, dx02 = x2 - x0, dy02 = y2 - y0, dx12 = x2 - x1, dy12 = y2 - y1;
+    int32_t sa = 0, sb = 0;
+
+    // Upper part, include scanline y1 only if the bottom is flat
+    last = y1 == y2 ? y1 : y1 - 1;
+
+    for (y = y0; y <= last; y++) {
+        a = x0 + sa / dy01;
+        b = x0 + sb / dy02;
+        sa += dx01;
+        sb += dx02;
+        if (a > b)
+            std::swap(a, b);
+        drawFastHLine(a, y, b - a + 1, color);
+    }
+
+    // Lower part
+    sa = dx12 * (y - y1);
+    sb = dx02 * (y - y0);
+    for (; y <= y2; y++) {
+        a = x1 + sa / dy12;
+        b = x0 + sb / dy02;
+        sa += dx12;
+        sb += dx02;
+        if (a > b)
+            std::swap(a, b);
+        drawFastHLine(a, y, b - a + 1, color);
+    }
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+    HostCallScope scope(this, "pushImage");
+    int32_t dx = x + xDatum, dy = y + yDatum, stride = w;
+
+    clipRect(&x, &y, &w, &h);
+    if (w <= 0 || h <= 0)
+        return;
+
+    // TFT_eSPI sends the array bytes as they are unless swapBytes is set
+    beginTftWrite();
+    writeImage(x, y, w, h, data + (y - dy) * stride + (x - dx), stride, !swapBytes);
+    endTftWrite();
+}
+
+/**
+ * @brief Set the address window for pushColor() and pushPixels(). As TFT_eSPI, in screen coordinates
+ * without the viewport, the window should be on the screen.
+ */
+void TFT_eSPI::setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h) {
+    HostCallScope scope(this, "setAddrWindow");
+
+    addrX = x;
+    addrY = y;
+    addrW = max(w, (int32_t)0);
+    addrH = max(h, (int32_t)0);
+    addrNext = 0;
+
+    beginTftWrite();
+    countWindow(0);
+    endTftWrite();
+}
+
+/**
+ * @brief Stream len pixels of one colour into the address window, wrapping at its right
+ * edge as the panel does.
+ */
+void TFT_eSPI::pushColor(uint16_t color, uint32_t len) {
+    HostCallScope scope(this, "pushColor");
+    uint32_t area = (uint32_t)addrW * addrH;
+
+    beginTftWrite();
+    countPixels(len);
+    for (uint32_t i = 0; i < len && area > 0; i++, addrNext = (addrNext + 1) % area) {
+        int32_t x = addrX + addrNext % addrW, y = addrY + addrNext / addrW;
+        if (x >= 0 && y >= 0 && x < _width && y < _height)
+            pixels[(size_t)y * _width + x] = color;
+    }
+    endTftWrite();
+}
+
+/**
+ * @brief Stream len pixels from a buffer into the address window, wrapping at its right
+ * edge. As pushImage(), the buffer's bytes go out as they are unless swapBytes is set.
+ */
+void TFT_eSPI::pushPixels(const void *data, uint32_t len) {
+    HostCallScope scope(this, "pushPixels");
+    const uint16_t *colours = (const uint16_t *)data;
+    uint32_t area = (uint32_t)addrW * addrH;
+
+    beginTftWrite();
+    countPixels(len);
+    for (uint32_t i = 0; i < len && area > 0; i++, addrNext = (addrNext + 1) % area) {
+        int32_t x = addrX + addrNext % addrW, y = addrY + addrNext / addrW;
+        uint16_t colour = swapBytes ? colours[i] : (uint16_t)((colours[i] << 8) | (colours[i] >> 8));
+        if (x >= 0 && y >= 0 && x < _width && y < _height)
+            pixels[(size_t)y * _width + x] = colour;
+    }
+    endTftWrite();
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+    x += xDatum;
+    y += yDatum;
+    if (x < vpX || y < vpY || x >= vpX + vpW || y >= vpY + vpH || pixels.empty())
+        return 0;
+
+    return pixels[(size_t)y * _width + x];
+}
+
+int16_t TFT_eSPI::textWidth(const char *text, uint8_t font) {
+    const hostFont_t *info = fontInfo(font);
+
+    return strlen(text) * info->width * textSize;
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font) {
+    return fontInfo(font)->height * textSize;
+}
+
+/**
+ * @brief Draw a character from the built-in 6x8 font. An opaque character at size 1 is
+ * one address window, otherwise every pixel (or size x size block) is written on its own.
+ */
+void TFT_eSPI::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size) {
+    HostCallScope scope(this, "drawChar");
+    bool fillBg = bg != color;
+    int32_t cx = x, cy = y, cw = glcdFont.width, ch = glcdFont.height;
+
+    clipRect(&cx, &cy, &cw, &ch);
+    if (cw <= 0 || ch <= 0)
+        return;
+
+    if (size == 1 && fillBg && cw == glcdFont.width && ch == glcdFont.height) {
+        uint16_t cell[6 * 8];
+        for (int32_t row = 0; row < glcdFont.height; row++)
+            for (int32_t col = 0; col < glcdFont.width; col++)
+                cell[row * glcdFont.width + col] = glyphBit(c, col, row, &glcdFont) ? color : bg;
+
+        beginTftWrite();
+        writeImage(cx, cy, cw, ch, cell, glcdFont.width, false);
+        endTftWrite();
+        return;
+    }
+
+    inTransaction = true;
+    for (int32_t col = 0; col < glcdFont.width; col++) {
+        for (int32_t row = 0; row < glcdFont.height; row++) {
+            bool lit = glyphBit(c, col, row, &glcdFont);
+            if (!lit && !fillBg)
+                continue;
+            if (size == 1)
+                drawPixel(x + col, y + row, lit ? color : bg);
+            else
+                fillRect(x + col * size, y + row * size, size, size, lit ? color : bg);
+        }
+    }
+    inTransaction = lockTransaction;
+    endTftWrite();
+}
+
+/**
+ * @brief Draw a character in one of the numbered fonts at the given position.
+ *
+ * @return int16_t Width of the character in pixels, 0 if it isn't in the font
+ */
+int16_t TFT_eSPI::drawChar(uint16_t c, int32_t x, int32_t y, uint8_t font) {
+    HostCallScope scope(this, "drawChar");
+    const hostFont_t *info = fontInfo(font);
+
+    if (font == 1) {
+        drawChar(x, y, c, textColor, textBgColor, textSize);
+        return info->width * textSize;
+    }
+
+    if (c < 32 || c > 127)
+        return 0;
+
+    int32_t width = info->width, height = info->height;
+    int32_t inkTop = (height - info->inkHeight) / 2;
+    bool fillBg = textBgColor != textColor;
+
+    if (textSize == 1 && fillBg) {
+        int32_t cx = x, cy = y, cw = width, ch = height;
+        clipRect(&cx, &cy, &cw, &ch);
+        if (cw == width && ch == height) {
+            std::vector<uint16_t> cell(width * height);
+            for (int32_t row = 0; row < height; row++)
+                for (int32_t col = 0; col < width; col++)
+                    cell[row * width + col] = glyphBit(c, col, row - inkTop, info) ? textColor : textBgColor;
+
+            beginTftWrite();
+            writeImage(cx, cy, cw, ch, cell.data(), width, false);
+            endTftWrite();
+            return width;
+        }
+    }
+
+    beginTftWrite();
+    inTransaction = true;
+
+    if (fillBg)
+        fillRect(x, y, width * textSize, height * textSize, textBgColor);
+
+    for (int32_t row = 0; row < info->inkHeight; row++) {
+        int32_t col = 0;
+        while (col < info->inkWidth) {
+            while (col < info->inkWidth && !glyphBit(c, col, row, info))
+                col++;
+
+            int32_t start = col;
+            while (col < info->inkWidth && glyphBit(c, col, row, info))
+                col++;
+
+            if (col == start)
+                continue;
+            if (textSize == 1)
+                drawFastHLine(x + start, y + inkTop + row, col - start, textColor);
+            else
+                fillRect(x + start * textSize, y + (inkTop + row) * textSize, (col - start) * textSize, textSize, textColor);
+        }
+    }
+
+    inTransaction = lockTransaction;
+    endTftWrite();
+
+    return width * textSize;
+}
+
+/**
+ * @brief Print a character at the cursor, wrapping at the right hand edge.
+ */
+size_t TFT_eSPI::write(uint8_t c) {
+    HostCallScope scope(this, "write");
+    const hostFont_t *info = fontInfo(textFont);
+    int32_t width = info->width * textSize;
+    int32_t height = info->height * textSize;
+
+    if (c == '\r')
+        return 1;
+
+    if (c == '\n') {
+        cursorY += height;
+        cursorX = 0;
+        return 1;
+    }
+
+    if (textWrapX && cursorX + width > _width) {
+        cursorY += height;
+        cursorX = 0;
+    }
+
+    cursorX += drawChar(c, cursorX, cursorY, textFont);
+
+    return 1;
+}
+
+size_t TFT_eSPI::write(const uint8_t *buffer, size_t size) {
+    HostCallScope scope(this, "print");
+
+    for (size_t i = 0; i < size; i++)
+        write(buffer[i]);
+
+    return size;
+}
+
+/**
+ * @brief Save the framebuffer as a binary PPM (P6) image.
+ *
+ * @param path File to write
+ * @return true Written
+ */
+bool TFT_eSPI::writePPM(const char *path) {
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+        return false;
+
+    // The panel shows its lines from scrollLine on, across the screen in landscape
+    fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+    for (size_t i = 0; i < (size_t)_width * _height; i++) {
+        size_t x = i % _width, y = i / _width;
+        if (rotation & 1)
+            x = (x + scrollLine) % _width;
+        else
+            y = (y + scrollLine) % _height;
+
+        size_t at = y * _width + x;
+        uint16_t c = at < pixels.size() ? pixels[at] : 0;
+        uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        uint8_t rgb[3] = {(uint8_t)((r << 3) | (r >> 2)), (uint8_t)((g << 2) | (g >> 4)), (uint8_t)((b << 3) | (b >> 2))};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+
+    return fclose(file) == 0;
+}
+
+void TFT_eSPI::resetStats(void) {
+    bus = {0, 0, 0, 0, 0};
+    calls.clear();
+}
+
+/**
+ * @brief Print the SPI counts per call, biggest first, then the totals.
+ *
+ * @param out Where to print, e.g. Serial
+ */
+void TFT_eSPI::printStats(Print &out) {
+    std::vector<std::pair<std::string, hostSpiStats_t>> sorted(calls.begin(), calls.end());
+
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, hostSpiStats_t> &a, const std::pair<std::string, hostSpiStats_t> &b) {
+        return a.second.bytes > b.second.bytes;
+    });
+
+    out.printf("%-16s %8s %8s %8s %10s %10s\n", "call", "calls", "trans", "windows", "pixels", "bytes");
+    for (const auto &entry : sorted) {
+        const hostSpiStats_t &s = entry.second;
+        out.printf("%-16s %8u %8u %8u %10llu %10llu\n", entry.first.c_str(), (unsigned)s.calls, (unsigned)s.transactions,
+                   (unsigned)s.windows, (unsigned long long)s.pixels, (unsigned long long)s.bytes);
+    }
+    out.printf("%-16s %8u %8u %8u %10llu %10llu\n", "total", (unsigned)bus.calls, (unsigned)bus.transactions,
+               (unsigned)bus.windows, (unsigned long long)bus.pixels, (unsigned long long)bus.bytes);
+}
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), tft(tft) {
+    onBus = false;
+}
+
+/**
+ * @brief Allocate the sprite buffer, 16 bit colour only.
+ *
+ * @return void* Buffer, NULL if the size is invalid
+ */
+void *TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames) {
+    (void)frames;
+
+    if (isCreated)
+        return pixels.data();
+    if (w <= 0 || h <= 0)
+        return NULL;
+
+    _width = w;
+    _height = h;
+    pixels.assign((size_t)w * h, TFT_BLACK);
+    resetViewport();
+    isCreated = true;
+
+    return pixels.data();
+}
+
+void TFT_eSprite::deleteSprite(void) {
+    pixels.clear();
+    pixels.shrink_to_fit();
+    _width = _height = 0;
+    resetViewport();
+    isCreated = false;
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+    HostCallScope scope(tft, "pushSprite");
+    int32_t w = _width, h = _height, dx = x, dy = y;
+
+    if (!isCreated)
+        return;
+
+    tft->clipRect(&x, &y, &w, &h);
+    if (w <= 0 || h <= 0)
+        return;
+
+    int32_t sx = x - dx - tft->xDatum, sy = y - dy - tft->yDatum;
+    tft->beginTftWrite();
+    tft->writeImage(x, y, w, h, &pixels[(size_t)sy * _width + sx], _width, false);
+    tft->endTftWrite();
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y, uint16_t transparent) {
+    HostCallScope scope(tft, "pushSprite");
+    int32_t w = _width, h = _height, dx = x, dy = y;
+
+    if (!isCreated)
+        return;
+
+    tft->clipRect(&x, &y, &w, &h);
+    if (w <= 0 || h <= 0)
+        return;
+
+    int32_t sx = x - dx - tft->xDatum, sy = y - dy - tft->yDatum;
+    tft->beginTftWrite();
+    tft->inTransaction = true;
+    tft->writeImageTransparent(x, y, w, h, &pixels[(size_t)sy * _width + sx], _width, transparent);
+    tft->inTransaction = tft->lockTransaction;
+    tft->endTftWrite();
+}
+
+/**
+ * @brief Push the sprite area (sx, sy, sw, sh) to the screen at (tx, ty).
+ *
+ * @return true Something was pushed
+ */
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh) {
+    HostCallScope scope(tft, "pushSprite");
+
+    if (!isCreated)
+        return false;
+
+    // Clip to the sprite first, then to the screen
+    if (sx < 0) { sw += sx; tx -= sx; sx = 0; }
+    if (sy < 0) { sh += sy; ty -= sy; sy = 0; }
+    if (sx + sw > _width) sw = _width - sx;
+    if (sy + sh > _height) sh = _height - sy;
+    if (sw <= 0 || sh <= 0)
+        return false;
+
+    int32_t x = tx, y = ty, w = sw, h = sh;
+    tft->clipRect(&x, &y, &w, &h);
+    if (w <= 0 || h <= 0)
+        return false;
+
+    sx += x - tx - tft->xDatum;
+    sy += y - ty - tft->yDatum;
+    tft->beginTftWrite();
+    tft->writeImage(x, y, w, h, &pixels[(size_t)sy * _width + sx], _width, false);
+    tft->endTftWrite();
+
+    return true;
+}
@@ -0,0 +1,252 @@
+/*
+    Host stand-in for the subset of TFT_eSPI / TFT_eSprite used by the monitor screen.
+
+    Drawing goes into an in-memory RGB565 framebuffer (480x320 after setRotation(3)) that
+    can be dumped as a PPM image with writePPM().  The panel object also models what the
+    real library would send over SPI and counts, per public call (fillRect, drawLine,
+    print, pushSprite...):
+        transactions    Bus transactions, one per primitive unless held by startWrite()
+        windows         Address window sets (CASET, PASET, RAMWR)
+        pixels          Pixels streamed after the window
+        bytes           windows * HOSTSIM_WINDOW_BYTES + pixels * HOSTSIM_PIXEL_BYTES
+
+    Of the panel commands sent with writecommand()/writedata() only vertical scrolling
+    (VSCRDEF 0x33, VSCRSADD 0x37) is emulated, over the whole panel.  It changes which line
+    of the framebuffer the panel shows first, not the framebuffer, and writePPM() saves
+    what the panel shows.  In landscape the panel's lines run across the screen, so the
+    picture moves along x.
+
+    Sending to the panel also moves the simulated clock on by the time the bytes take at
+    SPI_FREQUENCY, so code timing itself with esp_timer_get_time() sees the bus cost.
+
+    Primitives are broken down the way TFT_eSPI breaks them down (lines into horizontal
+    or vertical runs, circles and triangles into horizontal lines, text into one window
+    per character when the background is filled, or one run per lit row segment when it
+    isn't) so the counts track the real library.  Sprites draw into their own buffer and
+    cost nothing until pushed.
+
+    The built-in fonts are fixed pitch (font 1 6x8, font 2 8x16, font 4 14x26) and the
+    glyphs are placeholder block patterns, there is no font data on the host.  Smooth
+    fonts are not emulated, loadFont() does nothing and fontPartitionBegin() always fails
+    so the built-in font fallbacks are used.
+*/
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef HOSTSIM_TFT_ESPI_H
+#define HOSTSIM_TFT_ESPI_H
+
+#define TFT_WIDTH  320
+#define TFT_HEIGHT 480
+
+#ifndef HOSTSIM_WINDOW_BYTES
+#define HOSTSIM_WINDOW_BYTES 11     // CASET + 4 bytes, PASET + 4 bytes, RAMWR
+#endif
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 27000000      // As the TFT_eSPI user setup
+#endif
+#ifndef HOSTSIM_PIXEL_BYTES
+#define HOSTSIM_PIXEL_BYTES 2       // 16 bit colour, use 3 for panels driven in 18 bit mode
+#endif
+
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_DARKGREEN   0x03E0
+#define TFT_DARKCYAN    0x03EF
+#define TFT_MAROON      0x7800
+#define TFT_PURPLE      0x780F
+#define TFT_OLIVE       0x7BE0
+#define TFT_LIGHTGREY   0xD69A
+#define TFT_DARKGREY    0x7BEF
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_WHITE       0xFFFF
+#define TFT_ORANGE      0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK        0xFE19
+#define TFT_BROWN       0x9A60
+#define TFT_GOLD        0xFEA0
+#define TFT_SILVER      0xC618
+#define TFT_SKYBLUE     0x867D
+#define TFT_VIOLET      0x915C
+#define TFT_TRANSPARENT 0x0120
+
+typedef struct {
+    uint32_t calls;
+    uint32_t transactions;
+    uint32_t windows;
+    uint64_t pixels;
+    uint64_t bytes;
+} hostSpiStats_t;
+
+typedef struct {
+    uint16_t gCount;
+    uint16_t yAdvance;
+    uint16_t spaceWidth;
+    int16_t ascent;
+    int16_t descent;
+    uint16_t maxAscent;
+    uint16_t maxDescent;
+} fontMetrics;
+
+class TFT_eSPI : public Print {
+    friend class TFT_eSprite;
+    friend class HostCallScope;
+
+public:
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+    void init(void);
+    void begin(void) { init(); }
+    void setRotation(uint8_t r);
+    uint8_t getRotation(void) { return rotation; }
+    void invertDisplay(bool invert) { (void)invert; }
+    void setSwapBytes(bool swap) { swapBytes = swap; }
+    bool getSwapBytes(void) { return swapBytes; }
+    int16_t width(void) { return _width; }
+    int16_t height(void) { return _height; }
+
+    void startWrite(void);
+    void endWrite(void);
+    void writecommand(uint8_t c);
+    void writedata(uint8_t d);
+
+    void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+    void resetViewport(void);
+
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void fillScreen(uint32_t color);
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+    void drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color);
+    void fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color);
+    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h);
+    void pushColor(uint16_t color, uint32_t len);
+    void pushPixels(const void *data, uint32_t len);
+    uint16_t readPixel(int32_t x, int32_t y);
+    uint16_t color565(uint8_t r, uint8_t g, uint8_t b) { return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3); }
+
+    void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+    void setCursor(int16_t x, int16_t y, uint8_t font) { setTextFont(font); setCursor(x, y); }
+    int16_t getCursorX(void) { return cursorX; }
+    int16_t getCursorY(void) { return cursorY; }
+    void setTextColor(uint16_t color) { textColor = textBgColor = color; }
+    void setTextColor(uint16_t color, uint16_t bgColor, bool bgFill = false) { (void)bgFill; textColor = color; textBgColor = bgColor; }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextFont(uint8_t font) { textFont = font > 0 ? font : 1; }
+    void setTextWrap(bool wrapX, bool wrapY = false) { textWrapX = wrapX; (void)wrapY; }
+    int16_t textWidth(const char *text, uint8_t font);
+    int16_t textWidth(const char *text) { return textWidth(text, textFont); }
+    int16_t textWidth(const String &text) { return textWidth(text.c_str(), textFont); }
+    int16_t fontHeight(int16_t font);
+    int16_t fontHeight(void) { return fontHeight(textFont); }
+    int16_t drawChar(uint16_t c, int32_t x, int32_t y, uint8_t font);
+    void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    // Smooth fonts, not emulated
+    void loadFont(const uint8_t *array) { (void)array; }
+    void unloadFont(void) {}
+    bool getUnicodeIndex(uint16_t unicode, uint16_t *index) { (void)unicode; (void)index; return false; }
+    fontMetrics gFont = {0, 0, 0, 0, 0, 0, 0};
+    uint8_t *gxAdvance = NULL;
+
+    // Host only
+    const uint16_t *framebuffer(void) { return pixels.data(); }
+    bool writePPM(const char *path);
+    int16_t scrollStart(void) { return scrollLine; }
+    void resetStats(void);
+    const hostSpiStats_t &totalStats(void) { return bus; }
+    const std::map<std::string, hostSpiStats_t> &callStats(void) { return calls; }
+    void printStats(Print &out);
+
+protected:
+    int16_t _width;
+    int16_t _height;
+    std::vector<uint16_t> pixels;   // Panel framebuffer or sprite buffer
+    bool onBus;                     // true for the panel, sprites draw into memory
+
+private:
+    void clipRect(int32_t *x, int32_t *y, int32_t *w, int32_t *h);
+    void writeRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void writeImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride, bool swap);
+    void writeImageTransparent(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data, int32_t stride, uint16_t transparent);
+    void countWindow(uint32_t count);
+    void countPixels(uint32_t count);
+    void countBytes(uint64_t bytes);
+    void beginTftWrite(void);
+    void endTftWrite(void);
+    void drawCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornerName, uint32_t color);
+    void fillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t cornerName, int32_t delta, uint32_t color);
+
+    int16_t initWidth;
+    int16_t initHeight;
+    uint8_t rotation = 0;
+    bool swapBytes = false;
+
+    // Viewport, clip rectangle and drawing datum
+    int32_t vpX = 0, vpY = 0, vpW, vpH;
+    int32_t xDatum = 0, yDatum = 0;
+
+    // Commands sent with writecommand()/writedata(), only vertical scrolling is acted on
+    uint8_t command = 0;
+    uint8_t commandData[6];
+    uint8_t commandLength = 0;
+    int16_t scrollLine = 0;         // VSCRSADD, first line of frame memory on the display
+
+    // Address window set by setAddrWindow(), filled by pushColor() and pushPixels()
+    int32_t addrX = 0, addrY = 0, addrW = 0, addrH = 0;
+    uint32_t addrNext = 0;
+
+    int16_t cursorX = 0, cursorY = 0;
+    uint16_t textColor = TFT_WHITE, textBgColor = TFT_WHITE;
+    uint8_t textSize = 1;
+    uint8_t textFont = 1;
+    bool textWrapX = true;
+
+    // Bus model, mirrors TFT_eSPI's begin_tft_write()/end_tft_write()
+    bool locked = true;             // No transaction open
+    bool inTransaction = false;     // Primitive or startWrite() is holding the transaction
+    bool lockTransaction = false;   // startWrite() is holding the transaction
+    hostSpiStats_t bus = {0, 0, 0, 0, 0};
+    std::map<std::string, hostSpiStats_t> calls;
+    int callDepth = 0;
+    const char *callName = NULL;
+    hostSpiStats_t callStart;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI *tft);
+
+    void *createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+    void deleteSprite(void);
+    bool created(void) { return isCreated; }
+    void fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+    void pushSprite(int32_t x, int32_t y);
+    void pushSprite(int32_t x, int32_t y, uint16_t transparent);
+    bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw, int32_t sh);
+
+private:
+    TFT_eSPI *tft;
+    bool isCreated = false;
+};
+
+#endif  // HOSTSIM_TFT_ESPI_H
@@ -0,0 +1,12 @@
+/*
+    Host stand-in for esp_attr.h. There is no IRAM or flash cache on the host, the
+    placement attributes are empty.
+*/
+
+#ifndef HOSTSIM_ESP_ATTR_H
+#define HOSTSIM_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif  // HOSTSIM_ESP_ATTR_H
@@ -0,0 +1,34 @@
+/*
+    Host stand-in for esp_heap_caps.h, every capability comes from the C heap.  There is
+    no PSRAM, so MALLOC_CAP_SPIRAM allocations fail as they do on a board without it.
+    The largest free block is HOSTSIM_LARGEST_FREE_BLOCK, set it with -D to see how code
+    behaves short of memory.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef HOSTSIM_ESP_HEAP_CAPS_H
+#define HOSTSIM_ESP_HEAP_CAPS_H
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+
+#ifndef HOSTSIM_LARGEST_FREE_BLOCK
+#define HOSTSIM_LARGEST_FREE_BLOCK (4 * 1024 * 1024)
+#endif
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? NULL : malloc(size);
+}
+
+static inline void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? NULL : realloc(ptr, size);
+}
+
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? 0 : HOSTSIM_LARGEST_FREE_BLOCK;
+}
+
+#endif  // HOSTSIM_ESP_HEAP_CAPS_H
@@ -0,0 +1,53 @@
+/*
+    Host stand-in for esp_partition.h. There is no flash on the host so no partition is
+    ever found, code using it (fontPartition.cpp) takes its "not flashed" path.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HOSTSIM_ESP_PARTITION_H
+#define HOSTSIM_ESP_PARTITION_H
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+typedef uint32_t spi_flash_mmap_handle_t;
+
+typedef enum {
+    SPI_FLASH_MMAP_DATA,
+    SPI_FLASH_MMAP_INST,
+} spi_flash_mmap_memory_t;
+
+static inline const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+    (void)type; (void)subtype; (void)label;
+    return NULL;
+}
+
+static inline esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                                           spi_flash_mmap_memory_t memory, const void **out_ptr, spi_flash_mmap_handle_t *out_handle) {
+    (void)partition; (void)offset; (void)size; (void)memory; (void)out_ptr; (void)out_handle;
+    return ESP_FAIL;
+}
+
+static inline void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    (void)handle;
+}
+
+#endif  // HOSTSIM_ESP_PARTITION_H
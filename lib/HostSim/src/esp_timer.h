@@ -0,0 +1,16 @@
+/*
+    Host stand-in for esp_timer.h, backed by the simulated clock in Arduino.h.
+*/
+
+#include <stdint.h>
+
+#ifndef HOSTSIM_ESP_TIMER_H
+#define HOSTSIM_ESP_TIMER_H
+
+int64_t hostClockTime(void);
+
+static inline int64_t esp_timer_get_time(void) {
+    return hostClockTime();
+}
+
+#endif  // HOSTSIM_ESP_TIMER_H
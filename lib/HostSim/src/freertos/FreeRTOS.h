@@ -0,0 +1,48 @@
+/*
+    Host stand-in for the FreeRTOS critical sections used by code shared with the host
+    build.  A portMUX is a spinlock, as it is on the ESP32 where taskENTER_CRITICAL() spins
+    against the other core, so shared code can be exercised from several std::threads.
+
+    The basic types and tick macros are here too for the task and semaphore stand-ins
+    (task.h, semphr.h).  A tick is a millisecond, as configured on the ESP32.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifndef HOSTSIM_FREERTOS_H
+#define HOSTSIM_FREERTOS_H
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define portMAX_DELAY 0xffffffffUL
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) * configTICK_RATE_HZ / 1000)
+
+typedef struct {
+    std::atomic_flag locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {ATOMIC_FLAG_INIT}
+
+static inline void hostMuxLock(portMUX_TYPE *mux) {
+    while (mux->locked.test_and_set(std::memory_order_acquire))
+        ;
+}
+
+static inline void hostMuxUnlock(portMUX_TYPE *mux) {
+    mux->locked.clear(std::memory_order_release);
+}
+
+#define taskENTER_CRITICAL(mux) hostMuxLock(mux)
+#define taskEXIT_CRITICAL(mux) hostMuxUnlock(mux)
+
+#endif  // HOSTSIM_FREERTOS_H
@@ -0,0 +1,24 @@
+/*
+    Host stand-in for FreeRTOS event groups, the bits behind a std::mutex and a condition
+    variable.  A wait that has to block counts as blocked time for the calling task (see
+    task.h).  Only waits in real time mode, in simulated time a wait for bits that aren't
+    set returns straight away.
+*/
+
+#include "FreeRTOS.h"
+
+#ifndef HOSTSIM_EVENT_GROUPS_H
+#define HOSTSIM_EVENT_GROUPS_H
+
+typedef uint32_t EventBits_t;
+typedef struct hostEventGroup *EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+    BaseType_t waitForAll, TickType_t ticks);
+void vEventGroupDelete(EventGroupHandle_t group);
+
+#endif  // HOSTSIM_EVENT_GROUPS_H
@@ -0,0 +1,25 @@
+/*
+    Host stand-in for FreeRTOS queues, a ring of fixed size items behind a std::mutex,
+    copied in and out as FreeRTOS does.  A send or receive that has to wait counts as
+    blocked time for the calling task (see task.h).  Only waits in real time mode, in
+    simulated time a send to a full queue or a receive from an empty one fails straight
+    away.
+*/
+
+#include "FreeRTOS.h"
+
+#ifndef HOSTSIM_QUEUE_H
+#define HOSTSIM_QUEUE_H
+
+#define errQUEUE_FULL 0
+
+typedef struct hostQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+
+#endif  // HOSTSIM_QUEUE_H
@@ -0,0 +1,21 @@
+/*
+    Host stand-in for FreeRTOS binary semaphores and mutexes, a count behind a std::mutex
+    and a condition variable.  A take that has to wait counts as blocked time for the
+    calling task (see task.h).  Only waits in real time mode, in simulated time a take
+    that can't have the semaphore fails straight away.
+*/
+
+#include "FreeRTOS.h"
+
+#ifndef HOSTSIM_SEMPHR_H
+#define HOSTSIM_SEMPHR_H
+
+typedef struct hostSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif  // HOSTSIM_SEMPHR_H
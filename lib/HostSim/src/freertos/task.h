@@ -0,0 +1,45 @@
+/*
+    Host stand-in for FreeRTOS tasks, each task is a std::thread.
+
+    There is no scheduler, priorities and cores are accepted and ignored, every task runs
+    as soon as the host has a CPU for it.  Waiting only means anything with the clock in
+    real time mode (hostClockRealTime()), in simulated time vTaskDelay() just moves the
+    clock on, as delay() does.
+
+    Each task counts the time it spends blocked in vTaskDelay(), vTaskDelayUntil(),
+    ulTaskNotifyTake(), the queue calls, xSemaphoreTake() and xEventGroupWaitBits(), so hostTaskBusyTime() gives the time it was running, or spending its
+    bus time, the figure the ESP32's run time stats would give.  A task ends by returning
+    or with vTaskDelete(NULL).  Deleted by another task it ends at its next wait, in
+    vTaskDelay() or ulTaskNotifyTake().  hostTasksJoin() waits for every task to end.
+*/
+
+#include "FreeRTOS.h"
+
+#ifndef HOSTSIM_TASK_H
+#define HOSTSIM_TASK_H
+
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7fffffff
+#define portYIELD_FROM_ISR()            // Nothing to switch to, the woken thread just runs
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct hostTask *TaskHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameter,
+    UBaseType_t priority, TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth,
+    void *parameter, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+// Host only
+int64_t hostTaskBusyTime(TaskHandle_t task);
+void hostTaskBlocked(int64_t us);
+void hostTasksJoin(void);
+
+#endif  // HOSTSIM_TASK_H
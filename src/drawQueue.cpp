@@ -0,0 +1,145 @@
+/*
+    Draw command queue, see drawQueue.h.
+
+    A bounded ring with a sequence number in each slot.  A slot's sequence is its position
+    while it is free and its position + 1 once a command is in it.  A producer claims the
+    next position by moving head on with a compare and swap, copies the command into the
+    slot and then publishes it by storing the sequence.  The display task is the only
+    consumer, it takes slots in order while their sequence says they are full and frees
+    each one by setting its sequence a lap on.  Nothing ever holds a lock, a producer
+    only retries the compare and swap if another producer got that position first.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include "drawQueue.h"
+
+typedef struct {
+    std::atomic<uint32_t> sequence;
+    drawCommand_t command;
+} drawSlot_t;
+
+static drawSlot_t slots[DRAW_QUEUE_LENGTH];
+static std::atomic<uint32_t> head(0);       // Next position for a producer
+static uint32_t tail = 0;                   // Next position to take, display task only
+static std::atomic<bool> notified(false);   // Display notified since the last take
+static std::atomic<uint32_t> posted(0);     // Since the last report
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint32_t> collisions(0); // Claims retried because another producer was first
+static uint32_t taken = 0;                  // Since the last report, display task only
+static uint32_t batches = 0;
+static void (*notifyDisplay)(void) = NULL;
+
+
+/**
+ * @brief Empty the ring and set the function called when there is something to draw.
+ * Call before any task posts.
+ *
+ * @param notify e.g. wakes the display task, may be NULL to poll drawQueueTake()
+ */
+void drawQueueBegin(void (*notify)(void)) {
+    for (uint32_t i = 0; i < DRAW_QUEUE_LENGTH; i++)
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    head.store(0, std::memory_order_relaxed);
+    tail = 0;
+    notified.store(false);
+    notifyDisplay = notify;
+}
+
+/**
+ * @brief Post a command for the display task, safe to call from any task. Never waits.
+ *
+ * @param command Copied into the ring
+ * @return true Queued, false if the ring was full and the command was dropped
+ */
+bool drawQueuePost(const drawCommand_t *command) {
+    uint32_t position = head.load(std::memory_order_relaxed);
+    drawSlot_t *slot;
+
+    for ( ;; ) {
+        slot = &slots[position & (DRAW_QUEUE_LENGTH - 1)];
+        int32_t lap = (int32_t)(slot->sequence.load(std::memory_order_acquire) - position);
+
+        if (lap == 0) {
+            if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+            collisions++;       // position has been reloaded
+        } else if (lap < 0) {
+            dropped++;          // the display hasn't taken this slot from the last lap yet
+            return false;
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->command = *command;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    posted++;
+
+    if (!notified.exchange(true) && notifyDisplay != NULL)
+        notifyDisplay();
+
+    return true;
+}
+
+/**
+ * @brief Post a line for the log, cut to fit.
+ *
+ * @param text Log line
+ * @return true Queued
+ */
+bool drawQueueLog(const char *text) {
+    drawCommand_t command;
+
+    command.type = DRAW_LOG;
+    command.source = 0;
+    command.value = 0;
+    strncpy(command.text, text, sizeof(command.text) - 1);
+    command.text[sizeof(command.text) - 1] = '\0';
+
+    return drawQueuePost(&command);
+}
+
+/**
+ * @brief Take up to max commands in the order they were posted, display task only. A
+ * command still being copied in by its producer holds back the ones after it until the
+ * next take.
+ *
+ * @param commands Filled in with the commands
+ * @param max Size of commands
+ * @return uint32_t Commands taken, max if there may be more
+ */
+uint32_t drawQueueTake(drawCommand_t *commands, uint32_t max) {
+    uint32_t count = 0;
+
+    notified.store(false);      // before looking, so a post we miss notifies again
+
+    while (count < max) {
+        drawSlot_t *slot = &slots[tail & (DRAW_QUEUE_LENGTH - 1)];
+        if (slot->sequence.load(std::memory_order_acquire) != tail + 1)
+            break;
+
+        commands[count++] = slot->command;
+        slot->sequence.store(tail + DRAW_QUEUE_LENGTH, std::memory_order_release);
+        tail++;
+    }
+
+    taken += count;
+    if (count > 0)
+        batches++;
+
+    return count;
+}
+
+/**
+ * @brief Print the commands posted, taken and dropped since the last report, the batches
+ * they were taken in and how often producers collided. Call from the display task.
+ *
+ * @param out Where to print, e.g. Serial
+ */
+void drawQueueReport(Print &out) {
+    out.printf("Draw queue: %u posted, %u taken in %u batches, %u dropped, %u collisions\n",
+        (unsigned)posted.exchange(0), (unsigned)taken, (unsigned)batches, (unsigned)dropped.exchange(0),
+        (unsigned)collisions.exchange(0));
+    taken = batches = 0;
+}
@@ -0,0 +1,200 @@
+/*
+    Energy integration, see energy.h
+*/
+
+#include <Preferences.h>
+#include <sys/time.h>
+#include <time.h>
+#include "crc16.h"
+#include "energy.h"
+
+static const char *channelNames[ENERGY_CHANNELS] = {"solar", "water", "import", "export"};
+
+static uint32_t localDay(int64_t time, int64_t *nextMidnight);
+
+
+EnergyMeter::EnergyMeter() {
+    memset(&totals, 0, sizeof(totals));
+    memset(lastPower, 0, sizeof(lastPower));
+    lastTime = midnight = lastCheckpoint = 0;
+    dirty = false;
+    gaps = 0;
+    nvsNamespace = ENERGY_NAMESPACE;
+}
+
+/**
+ * @brief Restore the totals from the last checkpoint. The running totals always carry
+ * on, today's only if the checkpoint was taken today by a set clock.
+ * 
+ * @param now Wall clock (ms)
+ * @param nvsNamespace NVS namespace of the checkpoints, another keeps simulated totals
+ * away from the real ones
+ */
+void EnergyMeter::begin(int64_t now, const char *nvsNamespace) {
+    Preferences prefs;
+    energyRecord_t record;
+    size_t length = 0;
+
+    this->nvsNamespace = nvsNamespace;
+    startDay(now);
+    dirty = false;
+    lastCheckpoint = now;
+
+    if (prefs.begin(nvsNamespace, true)) {
+        length = prefs.getBytes(ENERGY_KEY, &record, sizeof(record));
+        prefs.end();
+    }
+    if (length != sizeof(record) || record.version != ENERGY_VERSION || record.crc != crc16(&record, offsetof(energyRecord_t, crc)))
+        return;     // first boot, or an old or corrupt record
+
+    memcpy(totals.total, record.total, sizeof(totals.total));
+    if (now >= ENERGY_CLOCK_SET && record.day == totals.day)
+        memcpy(totals.today, record.today, sizeof(totals.today));
+}
+
+/**
+ * @brief Integrate from the last sample to this one.
+ * 
+ * @param time Wall clock of the sample (ms)
+ * @param power W on each channel, ENERGY_xxx order
+ * @return true Midnight has passed and today's totals have started again
+ */
+bool EnergyMeter::addSample(int64_t time, const int32_t power[ENERGY_CHANNELS]) {
+    int64_t duration = time - lastTime;
+    bool newDay = false;
+
+    if (lastTime == 0 || duration <= 0 || duration > ENERGY_MAX_GAP) {
+        if (lastTime != 0)
+            gaps++;             // nothing known in between, or the clock has been set
+        if (time >= midnight) {
+            startDay(time);
+            newDay = true;
+        }
+    } else if (time >= midnight) {
+        // Split at midnight, the power there on the line between the two samples
+        int32_t atMidnight[ENERGY_CHANNELS];
+        int64_t dayEnd = midnight;
+        int64_t before = dayEnd - lastTime;
+
+        for (uint8_t c = 0; c < ENERGY_CHANNELS; c++)
+            atMidnight[c] = lastPower[c] + ((int64_t)power[c] - lastPower[c]) * before / duration;
+
+        integrate(before, lastPower, atMidnight);
+        startDay(dayEnd);
+        integrate(time - dayEnd, atMidnight, power);
+        newDay = true;
+    } else {
+        integrate(duration, lastPower, power);
+    }
+
+    lastTime = time;
+    memcpy(lastPower, power, sizeof(lastPower));
+
+    return newDay;
+}
+
+/**
+ * @brief Save the totals to NVS if ENERGY_CHECKPOINT_PERIOD has passed since the last
+ * time. A new day is checkpointed straight away.
+ * 
+ * @param now Wall clock (ms)
+ * @param force Save now if anything has changed, e.g. before a planned restart
+ * @return true Saved
+ */
+bool EnergyMeter::checkpoint(int64_t now, bool force) {
+    Preferences prefs;
+    size_t length;
+
+    if (!dirty || (!force && now - lastCheckpoint < ENERGY_CHECKPOINT_PERIOD))
+        return false;
+
+    totals.version = ENERGY_VERSION;
+    totals.crc = crc16(&totals, offsetof(energyRecord_t, crc));
+    lastCheckpoint = now;
+
+    if (!prefs.begin(nvsNamespace, false))
+        return false;
+    length = prefs.putBytes(ENERGY_KEY, &totals, sizeof(totals));
+    prefs.end();
+
+    dirty = length != sizeof(totals);   // try again next period
+    return !dirty;
+}
+
+/**
+ * @brief Print today's and the running totals.
+ * 
+ * @param out Where to print, e.g. Serial
+ */
+void EnergyMeter::report(Print &out) {
+    out.printf("Energy on %u, %u gaps:", (unsigned)totals.day, (unsigned)gaps);
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++) {
+        uint32_t today = todayWh(c);
+        out.printf(" %s %u.%02u kWh (%u kWh total)", channelNames[c], (unsigned)(today / 1000), (unsigned)(today % 1000 / 10),
+            (unsigned)totalKWh(c));
+    }
+    out.println();
+}
+
+/**
+ * @brief Add the energy of one interval, the power changing in a straight line.
+ * 
+ * @param duration ms
+ * @param from W at the start
+ * @param to W at the end
+ */
+void EnergyMeter::integrate(int64_t duration, const int32_t from[ENERGY_CHANNELS], const int32_t to[ENERGY_CHANNELS]) {
+    for (uint8_t c = 0; c < ENERGY_CHANNELS; c++) {
+        int64_t energy = ((int64_t)max(from[c], (int32_t)0) + max(to[c], (int32_t)0)) * duration / 2;
+
+        totals.today[c] += energy;
+        totals.total[c] += energy;
+    }
+    dirty = true;
+}
+
+/**
+ * @brief Start the daily totals again.
+ * 
+ * @param time Any time in the new day
+ */
+void EnergyMeter::startDay(int64_t time) {
+    memset(totals.today, 0, sizeof(totals.today));
+    totals.day = localDay(time, &midnight);
+    dirty = true;
+    lastCheckpoint = time - ENERGY_CHECKPOINT_PERIOD;   // checkpoint the new day straight away
+}
+
+/**
+ * @brief Wall clock for the samples.
+ * 
+ * @return int64_t ms since 1970
+ */
+int64_t energyClock(void) {
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+/**
+ * @brief Local date of a time and the midnight that ends it.
+ * 
+ * @param time ms since 1970
+ * @param nextMidnight Set to the following local midnight (ms)
+ * @return uint32_t yyyymmdd
+ */
+static uint32_t localDay(int64_t time, int64_t *nextMidnight) {
+    time_t seconds = time / 1000;
+    struct tm local;
+
+    localtime_r(&seconds, &local);
+    uint32_t day = (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_mday++;
+    local.tm_isdst = -1;
+    *nextMidnight = (int64_t)mktime(&local) * 1000;
+
+    return day;
+}
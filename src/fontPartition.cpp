@@ -0,0 +1,131 @@
+/*
+    Smooth font support, see fontPartition.h for the partition layout.
+*/
+
+#include <Arduino.h>
+#include "esp_partition.h"
+#include "fontPartition.h"
+
+static const uint8_t *fontBase = NULL;         // Start of the memory mapped partition
+static const FontPartitionHeader *fontHeader = NULL;
+static uint32_t fontSize = 0;                  // Bytes mapped
+static spi_flash_mmap_handle_t fontMapHandle;
+
+/**
+ * @brief Find and memory map the font partition. Only the header is validated here, each
+ * entry when it is looked up, the fonts themselves are parsed by TFT_eSPI when loaded.
+ *
+ * @return true Partition mapped and contains a valid font table
+ * @return false No font partition, or it has not been flashed yet
+ */
+bool fontPartitionBegin(void) {
+    const esp_partition_t *partition;
+    const void *mapped;
+
+    if (fontHeader != NULL)
+        return true;    // already mapped
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FONT_PARTITION_SUBTYPE, FONT_PARTITION_NAME);
+    if (partition == NULL) {
+        Serial.println("Font partition not found");
+        return false;
+    }
+
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &fontMapHandle) != ESP_OK) {
+        Serial.println("Font partition mmap failed");
+        return false;
+    }
+
+    const FontPartitionHeader *header = (const FontPartitionHeader *)mapped;
+    if (header->magic != FONT_PARTITION_MAGIC || header->version != FONT_PARTITION_VERSION ||
+        sizeof(FontPartitionHeader) + header->count * sizeof(FontPartitionEntry) > partition->size) {
+        Serial.println("Font partition is empty or invalid, flash it with tools/mkfontpart.py");
+        spi_flash_munmap(fontMapHandle);
+        return false;
+    }
+
+    fontBase = (const uint8_t *)mapped;
+    fontHeader = header;
+    fontSize = partition->size;
+    Serial.printf("Font partition mapped, %d font(s)\n", header->count);
+
+    return true;
+}
+
+/**
+ * @brief Look up a font by name in the mapped partition. An entry whose data isn't
+ * wholly after the font table and inside the partition, from a corrupt or truncated
+ * image, is treated as not found.
+ *
+ * @param name Font name as given to tools/mkfontpart.py
+ * @return const uint8_t* Pointer to the .vlw data suitable for loadFont(), NULL if not found
+ */
+const uint8_t *fontPartitionFind(const char *name) {
+    if (fontHeader == NULL)
+        return NULL;
+
+    const FontPartitionEntry *entry = (const FontPartitionEntry *)(fontHeader + 1);
+    uint32_t tableEnd = sizeof(FontPartitionHeader) + fontHeader->count * sizeof(FontPartitionEntry);
+    for (uint16_t i = 0; i < fontHeader->count; i++, entry++) {
+        if (strncmp(entry->name, name, FONT_NAME_LENGTH) != 0)
+            continue;
+
+        if (entry->offset < tableEnd || entry->size == 0 || (uint64_t)entry->offset + entry->size > fontSize) {
+            Serial.printf("Font %.*s is outside the font partition, flash it again with tools/mkfontpart.py\n",
+                FONT_NAME_LENGTH, name);
+            return NULL;
+        }
+        return fontBase + entry->offset;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Build the cache for the given glyphs. The font must already be loaded into
+ * fontOwner and stay loaded for as long as the cache is used.
+ *
+ * @param fontOwner TFT or sprite object the smooth font has been loaded into
+ * @param glyphs Characters to cache, e.g. "0123456789. kWh"
+ */
+void HotGlyphCache::build(TFT_eSPI *fontOwner, const char *glyphs) {
+    uint16_t index;
+
+    gfx = fontOwner;
+    memset(advance, 0, sizeof(advance));
+
+    for (; *glyphs; glyphs++) {
+        uint8_t c = *glyphs;
+        if (c < HOT_GLYPH_FIRST || c > HOT_GLYPH_LAST)
+            continue;
+
+        if (gfx->getUnicodeIndex(c, &index))
+            advance[c - HOT_GLYPH_FIRST] = gfx->gxAdvance[index];
+        else
+            advance[c - HOT_GLYPH_FIRST] = gfx->gFont.spaceWidth;    // TFT_eSPI draws missing glyphs as a space
+    }
+}
+
+/**
+ * @brief Width in pixels of text in the cached font, characters that are not in the
+ * cache fall back to TFT_eSPI's own (slower) measurement.
+ *
+ * @param text Text to measure
+ * @return int16_t Width in pixels
+ */
+int16_t HotGlyphCache::textWidth(const char *text) {
+    int16_t width = 0;
+    char single[2] = {0, 0};
+
+    for (; *text; text++) {
+        uint8_t c = *text;
+        if (c >= HOT_GLYPH_FIRST && c <= HOT_GLYPH_LAST && advance[c - HOT_GLYPH_FIRST] != 0) {
+            width += advance[c - HOT_GLYPH_FIRST];
+        } else if (gfx != NULL) {
+            single[0] = c;
+            width += gfx->textWidth(single);
+        }
+    }
+
+    return width;
+}
@@ -0,0 +1,367 @@
+/*
+    Architecture benchmark, v1 tasks and semaphores against the v3 single loop, see
+    archBench.h.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "TFT_eSPI.h"
+#include "fastRandom.h"
+#include "telemetry.h"
+#include "screen.h"
+#include "archBench.h"
+
+#define ARCH_RUN_TIME 10000         // ms each architecture runs for
+#define ARCH_SEND_PERIOD 500        // ms between telemetry publishes
+#define ARCH_TAP_SEED 1             // Same taps every run
+#define ARCH_TAP_GAP_MIN 300        // ms from one tap to the next
+#define ARCH_TAP_GAP_MAX 600
+#define ARCH_TAP_HOLD_MIN 60        // ms the pen is down, a quick tap
+#define ARCH_TAP_HOLD_MAX 150
+#define ARCH_TAP_END 1000           // ms before the end with no taps, so the last can be answered
+#define ARCH_TAPS 64                // Most taps in a run
+#define ARCH_FRAMES 512             // Most frames timed in a run
+#define ARCH_TOUCH_READ 200         // us of bus time for a touch read
+#define TOUCH_DEBOUNCE 10           // ms, both wait this long after a read sees the pen down
+
+#define V1_ANIMATION_DELAY 40       // ms the animation task waits after each frame
+#define V1_TOUCH_PERIOD 200         // ms between touch task reads
+#define V3_ANIMATION_PERIOD 50      // ms between frames
+#define V3_LOOP_DELAY 30            // ms the loop waits each time round
+
+typedef struct {
+    int64_t press;                  // us
+    int64_t release;
+    int64_t response;               // 0 if never answered
+} archTap_t;
+
+typedef struct {
+    bool down;                      // Last read saw the pen down
+    int tap;                        // Which tap it was
+} archKey_t;
+
+typedef struct {
+    uint32_t frames;
+    int64_t intervalMean;           // us
+    int64_t jitterMean;             // us from the mean interval
+    int64_t jitterMax;
+    uint32_t taps;
+    uint32_t missed;
+    int64_t responseMean;           // us from the pen going up
+    int64_t responseMax;
+    uint32_t cpu;                   // 1/100 % of a core
+} archResult_t;
+
+static archTap_t taps[ARCH_TAPS];
+static uint32_t tapCount = 0;
+static int64_t frameTimes[ARCH_FRAMES];
+static uint32_t frameCount = 0;     // Written only by the task drawing frames
+static std::atomic<bool> running(false);
+static telemetry_t shownValues;
+static SemaphoreHandle_t tftSemaphore;
+static SemaphoreHandle_t animationSemaphore;
+static TaskHandle_t displayTasks[2];
+static uint32_t displayTaskCount = 0;
+
+static void archRun(const char *name, void (*start)(void), archResult_t *result);
+static void archResults(const archResult_t *result);
+static void planTaps(int64_t start);
+static int readPen(void);
+static void touchPoll(archKey_t *key, SemaphoreHandle_t bus, SemaphoreHandle_t hold);
+static void frame(void);
+static void senderTask(void *parameter);
+static void v1Start(void);
+static void v1AnimationTask(void *parameter);
+static void v1TouchTask(void *parameter);
+static void v3Start(void);
+static void v3DisplayTask(void *parameter);
+
+
+/**
+ * @brief Run v1 and then v3 on the same workload and print what each measured.
+ */
+void archBenchmark(void) {
+    archResult_t v1, v3;
+
+    archRun("v1 tasks and semaphores", v1Start, &v1);
+    archRun("v3 single loop", v3Start, &v3);
+
+    Serial.printf("\n%-24s %12s %12s\n", "", "v1", "v3");
+    Serial.printf("%-24s %9u.%u ms %9u.%u ms\n", "Frame interval, mean",
+        (unsigned)(v1.intervalMean / 1000), (unsigned)(v1.intervalMean / 100) % 10,
+        (unsigned)(v3.intervalMean / 1000), (unsigned)(v3.intervalMean / 100) % 10);
+    Serial.printf("%-24s %9u.%u ms %9u.%u ms\n", "Jitter, mean",
+        (unsigned)(v1.jitterMean / 1000), (unsigned)(v1.jitterMean / 100) % 10,
+        (unsigned)(v3.jitterMean / 1000), (unsigned)(v3.jitterMean / 100) % 10);
+    Serial.printf("%-24s %9u.%u ms %9u.%u ms\n", "Jitter, max",
+        (unsigned)(v1.jitterMax / 1000), (unsigned)(v1.jitterMax / 100) % 10,
+        (unsigned)(v3.jitterMax / 1000), (unsigned)(v3.jitterMax / 100) % 10);
+    Serial.printf("%-24s %6u of %3u %6u of %3u\n", "Taps missed",
+        (unsigned)v1.missed, (unsigned)v1.taps, (unsigned)v3.missed, (unsigned)v3.taps);
+    Serial.printf("%-24s %9u.%u ms %9u.%u ms\n", "Touch response, mean",
+        (unsigned)(v1.responseMean / 1000), (unsigned)(v1.responseMean / 100) % 10,
+        (unsigned)(v3.responseMean / 1000), (unsigned)(v3.responseMean / 100) % 10);
+    Serial.printf("%-24s %9u.%u ms %9u.%u ms\n", "Touch response, max",
+        (unsigned)(v1.responseMax / 1000), (unsigned)(v1.responseMax / 100) % 10,
+        (unsigned)(v3.responseMax / 1000), (unsigned)(v3.responseMax / 100) % 10);
+    Serial.printf("%-24s %9u.%02u %% %9u.%02u %%\n", "CPU",
+        (unsigned)(v1.cpu / 100), (unsigned)(v1.cpu % 100), (unsigned)(v3.cpu / 100), (unsigned)(v3.cpu % 100));
+}
+
+/**
+ * @brief Run one architecture for ARCH_RUN_TIME from a freshly drawn dashboard.
+ *
+ * @param name Printed with the results
+ * @param start Creates the architecture's display side tasks
+ * @param result Filled in with what was measured
+ */
+static void archRun(const char *name, void (*start)(void), archResult_t *result) {
+    TaskHandle_t sender;
+    int64_t busy = 0;
+
+    Serial.printf("\n== arch: %s ==\n", name);
+
+    tft.startWrite();
+    screenSaverActive = false;
+    initialiseScreen();
+    tft.endWrite();
+    telemetryBegin(NULL);
+    shownValues = {};
+
+    frameCount = 0;
+    displayTaskCount = 0;
+    hostClockRealTime(true);
+    int64_t runStart = hostClockTime();
+    planTaps(runStart);
+
+    running = true;
+    xTaskCreate(senderTask, "sender", 2048, NULL, tskIDLE_PRIORITY + 2, &sender);
+    start();
+    delay(ARCH_RUN_TIME);
+    running = false;
+    hostTasksJoin();
+
+    int64_t elapsed = hostClockTime() - runStart;
+    for (uint32_t i = 0; i < displayTaskCount; i++)
+        busy += hostTaskBusyTime(displayTasks[i]);
+    hostClockRealTime(false);
+
+    memset(result, 0, sizeof(*result));
+    result->frames = frameCount;
+    if (frameCount > 1) {
+        result->intervalMean = (frameTimes[frameCount - 1] - frameTimes[0]) / (frameCount - 1);
+        for (uint32_t i = 1; i < frameCount; i++) {
+            int64_t jitter = llabs(frameTimes[i] - frameTimes[i - 1] - result->intervalMean);
+            result->jitterMean += jitter;
+            result->jitterMax = max(result->jitterMax, jitter);
+        }
+        result->jitterMean /= frameCount - 1;
+    }
+
+    result->taps = tapCount;
+    for (uint32_t i = 0; i < tapCount; i++) {
+        if (taps[i].response == 0) {
+            result->missed++;
+            continue;
+        }
+        int64_t response = taps[i].response - taps[i].release;
+        result->responseMean += response;
+        result->responseMax = max(result->responseMax, response);
+    }
+    if (tapCount > result->missed)
+        result->responseMean /= tapCount - result->missed;
+
+    result->cpu = (uint32_t)(busy * 10000 / elapsed);
+
+    archResults(result);
+}
+
+static void archResults(const archResult_t *result) {
+    Serial.printf("%u frames, every %u.%u ms, jitter %u.%u ms mean, %u.%u ms max\n", (unsigned)result->frames,
+        (unsigned)(result->intervalMean / 1000), (unsigned)(result->intervalMean / 100) % 10,
+        (unsigned)(result->jitterMean / 1000), (unsigned)(result->jitterMean / 100) % 10,
+        (unsigned)(result->jitterMax / 1000), (unsigned)(result->jitterMax / 100) % 10);
+    Serial.printf("%u taps, %u missed, response %u.%u ms mean, %u.%u ms max after the pen went up\n",
+        (unsigned)result->taps, (unsigned)result->missed,
+        (unsigned)(result->responseMean / 1000), (unsigned)(result->responseMean / 100) % 10,
+        (unsigned)(result->responseMax / 1000), (unsigned)(result->responseMax / 100) % 10);
+    Serial.printf("CPU %u.%02u%% of a core\n", (unsigned)(result->cpu / 100), (unsigned)(result->cpu % 100));
+}
+
+/**
+ * @brief Script the taps for a run, the same ones every time from ARCH_TAP_SEED.
+ *
+ * @param start Time the run started, us
+ */
+static void planTaps(int64_t start) {
+    FastRandom tapRandom(ARCH_TAP_SEED);
+    int64_t press = start;
+
+    tapCount = 0;
+    for ( ;; ) {
+        press += (int64_t)tapRandom.between(ARCH_TAP_GAP_MIN, ARCH_TAP_GAP_MAX + 1) * 1000;
+        if (tapCount == ARCH_TAPS || press > start + (int64_t)(ARCH_RUN_TIME - ARCH_TAP_END) * 1000)
+            break;
+        taps[tapCount].press = press;
+        taps[tapCount].release = press + (int64_t)tapRandom.between(ARCH_TAP_HOLD_MIN, ARCH_TAP_HOLD_MAX + 1) * 1000;
+        taps[tapCount].response = 0;
+        tapCount++;
+    }
+}
+
+/**
+ * @brief Read the touch controller, which takes ARCH_TOUCH_READ of bus time.
+ *
+ * @return int The tap the pen is down for, -1 if it is up
+ */
+static int readPen(void) {
+    hostClockAdvance(ARCH_TOUCH_READ);
+    int64_t now = hostClockTime();
+
+    for (uint32_t i = 0; i < tapCount; i++) {
+        if (now >= taps[i].press && now < taps[i].release)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Read the pen and answer a tap the first time it is seen up after being down, as
+ * the button handling in v1 and v3 does (TFT_eSPI_Button::justReleased()).
+ *
+ * @param key Pen state between reads
+ * @param bus Semaphore around the TFT, NULL for none
+ * @param hold Semaphore taken first to hold off the animation while a tap is answered, as
+ * v1's button handling takes animationSemaphore, NULL for none
+ */
+static void touchPoll(archKey_t *key, SemaphoreHandle_t bus, SemaphoreHandle_t hold) {
+    if (bus != NULL)
+        xSemaphoreTake(bus, portMAX_DELAY);
+    int tap = readPen();
+    if (bus != NULL)
+        xSemaphoreGive(bus);
+
+    if (tap >= 0) {
+        key->down = true;
+        key->tap = tap;
+        vTaskDelay(TOUCH_DEBOUNCE / portTICK_PERIOD_MS);
+    } else if (key->down) {
+        key->down = false;
+        if (hold != NULL)
+            xSemaphoreTake(hold, portMAX_DELAY);
+        if (bus != NULL)
+            xSemaphoreTake(bus, portMAX_DELAY);
+        tft.startWrite();
+        updateLog("Touch");
+        tft.endWrite();
+        hostClockSettle();          // on the panel
+        if (taps[key->tap].response == 0)
+            taps[key->tap].response = hostClockTime();
+        if (bus != NULL)
+            xSemaphoreGive(bus);
+        if (hold != NULL)
+            xSemaphoreGive(hold);
+    }
+}
+
+/**
+ * @brief Draw an animation frame with the latest telemetry, and time it.
+ */
+static void frame(void) {
+    if (frameCount < ARCH_FRAMES)
+        frameTimes[frameCount++] = hostClockTime();
+
+    tft.startWrite();
+    showTelemetry(&shownValues, telemetryTake(&shownValues));
+    animation();
+    tft.endWrite();
+}
+
+/**
+ * @brief Publish a reading every ARCH_SEND_PERIOD, as the demo sender, alternating two
+ * sets of flows so the arrows change.
+ */
+static void senderTask(void *parameter) {
+    telemetry_t reading = {3900, -450, 3000, 14100, 3810, 31, true};
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t sent = 0;
+
+    while (running) {
+        reading.solarPower = (sent & 1) ? 1200 : 3900;
+        reading.gridPower = (sent & 1) ? 800 : -450;
+        reading.waterPower = (sent & 1) ? 0 : 3000;
+        telemetryPublish(&reading, sent == 0 ? TELEMETRY_ALL : TELEMETRY_POWER);
+        sent++;
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(ARCH_SEND_PERIOD));
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief v1, an animation task and a touch task, each taking the TFT semaphore to draw or
+ * read. The animation task takes the animation semaphore around each frame, and the touch
+ * task takes it around answering a tap, so the animation is held off while it draws.
+ */
+static void v1Start(void) {
+    if (tftSemaphore == NULL) {
+        tftSemaphore = xSemaphoreCreateBinary();
+        animationSemaphore = xSemaphoreCreateBinary();
+    }
+    xSemaphoreTake(tftSemaphore, 0);
+    xSemaphoreGive(tftSemaphore);
+    xSemaphoreTake(animationSemaphore, 0);
+    xSemaphoreGive(animationSemaphore);
+
+    xTaskCreate(v1AnimationTask, "animationTask", 2048, NULL, tskIDLE_PRIORITY, &displayTasks[displayTaskCount++]);
+    xTaskCreate(v1TouchTask, "touchTask", 2048, NULL, tskIDLE_PRIORITY, &displayTasks[displayTaskCount++]);
+}
+
+static void v1AnimationTask(void *parameter) {
+    while (running) {
+        xSemaphoreTake(animationSemaphore, portMAX_DELAY);
+        xSemaphoreTake(tftSemaphore, portMAX_DELAY);
+        frame();
+        xSemaphoreGive(tftSemaphore);
+        xSemaphoreGive(animationSemaphore);
+        vTaskDelay(V1_ANIMATION_DELAY / portTICK_PERIOD_MS);
+    }
+    vTaskDelete(NULL);
+}
+
+static void v1TouchTask(void *parameter) {
+    archKey_t key = {false, 0};
+
+    while (running) {
+        touchPoll(&key, tftSemaphore, animationSemaphore);
+        vTaskDelay(V1_TOUCH_PERIOD / portTICK_PERIOD_MS);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief v3, one task drawing the animation when it is due and reading the touch every
+ * time round, nothing shared so no semaphores.
+ */
+static void v3Start(void) {
+    xTaskCreate(v3DisplayTask, "displayTask", 3072, NULL, tskIDLE_PRIORITY, &displayTasks[displayTaskCount++]);
+}
+
+static void v3DisplayTask(void *parameter) {
+    uint32_t animationRunTime = millis() - V3_ANIMATION_PERIOD;
+    archKey_t key = {false, 0};
+
+    while (running) {
+        if (millis() - animationRunTime >= V3_ANIMATION_PERIOD) {
+            animationRunTime = millis();
+            frame();
+        }
+
+        touchPoll(&key, NULL, NULL);
+
+        vTaskDelay(V3_LOOP_DELAY / portTICK_PERIOD_MS);
+    }
+    vTaskDelete(NULL);
+}
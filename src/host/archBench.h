@@ -0,0 +1,28 @@
+/*
+    Architecture benchmark for the host build, the v1 display (src/main.cpp.v1, an
+    animation task and a touch task sharing the TFT through semaphores) against v3 (one
+    display loop, no semaphores, as main.cpp was before the event driven display task).
+
+    Both run the same workload for ARCH_RUN_TIME on the HostSim panel with the clock in
+    real time, their tasks are std::threads (lib/HostSim/src/freertos).  The flow
+    animation is drawn with a telemetry reading published every ARCH_SEND_PERIOD, and a
+    scripted finger taps the screen, the same taps for each.  Each tap is answered with a
+    log line, as the screen saver toggle was, when the first touch read after the pen goes
+    up sees it released.  Reported for each:
+
+        frame intervals     mean, mean and largest difference from the period
+        taps                made, missed (never seen pen down) and the response time
+                            from the pen going up to the log line being on the panel
+        CPU                 time the display side tasks weren't blocked, bus time
+                            included as the ESP32 spends it waiting on the SPI
+
+    The host has no priorities or core pinning, so only the waits and the semaphores are
+    modelled, not preemption, and the figures depend on the host's load.
+*/
+
+#ifndef ARCH_BENCH_H
+#define ARCH_BENCH_H
+
+void archBenchmark(void);
+
+#endif  // ARCH_BENCH_H
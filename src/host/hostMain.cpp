@@ -0,0 +1,1317 @@
+/*
+    Host (Linux) driver for the screen code, built by env:native against lib/HostSim.
+
+    Runs the drawing code through a few scenarios without the ESP32 or the panel, saves a
+    PPM snapshot at the end of each one and prints the SPI traffic the real TFT_eSPI
+    would have generated, per call.  Each animation or screen saver tick is a frame drawn
+    in one startWrite()/endWrite() as the display task does, the per site and per frame
+    SPI profile is printed and saved to spi_profile.txt.
+
+    The telemetry channel is also run flat out from two producer threads while a display
+    thread takes snapshots and two more threads read it, to measure its throughput and
+    check that no read mixes two publishes, and the energy meter is run through a gap,
+    midnight and a restore from NVS against totals worked out by hand.  Each page is shown
+    in turn and the switch timed against PAGE_SWITCH_TARGET, then every switch between
+    two pages is checked against the page drawn in full.  The matrix screen saver is run
+    twice from the same seed and has to draw the same frames both times, and the pixel
+    shift screen saver is run through a whole cycle, checking every move is a pixel and
+    stays in range.  The dashboard is then left idle for ten minutes, waking only when the
+    display task would, to count the wakeups a second of an idle screen.  Draw commands are posted flat out from several threads, the display
+    must take every one once and in order.  The touch reader task is driven by a scripted
+    touch source and simulated pen IRQ, it must queue each sample and a pen up to end the
+    touch, and never read the controller while the IRQ is idle.  Scripted touches are fed
+    to the gesture engine, each must give the right gesture, or none for a glitch, stamped
+    with the right times.  The SPI bus arbiter is run with a display and a touch reader
+    task, touch reads must wait for a reserved frame, for no longer than the cap, and stay
+    in the gaps between frames.
+
+    Every scenario is checked against its golden frame in GOLDEN_FILE, a hash of what the
+    panel shows at the end of it, and against its budget, the most pixels, transactions
+    and address windows it may send.  Windows are what a change to how a region is
+    split into rectangles moves, transactions only count the frames holding the bus.  A change to what is drawn shows as a different hash and a
+    change that sends more fails its budget, so a slower screen fails like a broken one.
+    After a change that is meant to draw differently, or cost more, run with update to
+    rewrite the golden file from this run, budgets set to what was sent, and check the
+    diff in with the change.
+
+    The program exits with 1 if any of these checks fails.  pio run -e native runs it after
+    each build (tools/hostcheck.py), so a failed check fails the build.  By hand:
+
+        .pio/build/native/program [output directory] [update] [arch]
+
+    With arch the v1 and v3 display architectures are then timed against each other in
+    real time, see archBench.h.
+*/
+
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "TFT_eSPI.h"
+#include "HostFile.h"
+#include "esp_timer.h"
+#include "spiProfiler.h"
+#include "telemetry.h"
+#include "drawQueue.h"
+#include "touchInput.h"
+#include "touchGesture.h"
+#include "energy.h"
+#include "powerChart.h"
+#include "spiBus.h"
+#include "screen.h"
+#include "archBench.h"
+
+#define ANIMATION_PERIOD 50     // ms, as the display task
+#define MATRIX_PERIOD 200       // ms, as the display task
+#define ANIMATION_FRAMES 100
+#define MATRIX_FRAMES 20
+#define LOG_BURST 10
+#define CHART_COLUMNS 250               // Power chart columns to sample, more than it holds
+#define TELEMETRY_PUBLISHES 2000000     // Per producer thread
+#define ENERGY_START 1710712801000LL    // 2024-03-17 22:00:01 UTC, odd seconds so midnight falls between samples
+#define ENERGY_SAMPLE 2000              // ms
+#define ENERGY_GAP_START (ENERGY_START + 3600000LL)   // No samples for 10 minutes from 23:00:01
+#define ENERGY_GAP_END (ENERGY_GAP_START + 600000LL)
+#define ENERGY_END (ENERGY_START + 4 * 3600000LL)     // 02:00:01
+#define TELEMETRY_YIELD 64              // Producers yield every 64 publishes so a single core interleaves
+#define TELEMETRY_READERS 2             // Threads reading alongside the display
+#define DRAW_PRODUCERS 3                // Threads posting draw commands
+#define DRAW_POSTS 1000000              // Per producer thread
+#define DRAW_BATCH 4                    // As the display task
+#define MATRIX_SEED 1                   // Fixed, so the matrix draws the same frames every run
+#define SHIFT_FRAMES 20                 // Animation frames between pixel shifts, sped up
+#define IDLE_TIME 600000                // ms the dashboard is left idle
+#define IDLE_INACTIVE 120000            // ms, as the display task, before the pixel shift starts
+#define IDLE_WAKEUPS_MAX 1              // Most wakeups a second of an idle screen
+#define BUS_TOUCH_GAP 4000              // µs a touch read asks for, long so host scheduling noise doesn't matter
+#define BUS_TOUCH_HOLD 2                // ms a touch read holds the bus, within its gap
+#define BUS_FRAME_HOLD 8                // ms the display holds the bus for a frame
+#define BUS_FRAME_GAP 8                 // ms between the display's frames
+#define BUS_FRAMES 100
+#define BUS_DEFER_SLACK 20000           // µs past SPI_BUS_MAX_DEFER a capped wait may take on the host
+#define TOUCH_IDLE_WAIT 100             // ms, longer than a scripted touch takes to read
+#define TOUCH_SCRIPT_DOWN 2             // Reads that see the pen down after the IRQ
+#ifndef GOLDEN_FILE
+#define GOLDEN_FILE "src/host/golden.txt"   // From the project directory, as pio runs
+#endif
+#define GOLDEN_SCENARIOS 16
+#define GOLDEN_NAME_LENGTH 16
+
+typedef struct {
+    const char *name;
+    uint16_t x;                         // First sample
+    uint16_t y;
+    int16_t stepX;                      // Move each sample
+    int16_t stepY;
+    uint8_t downSamples;                // TOUCH_SAMPLE_INTERVAL apart, then a pen up sample
+    int8_t gesture;                     // touchGestureType_t expected, -1 for none
+} gestureScript_t;
+
+typedef struct {
+    char name[GOLDEN_NAME_LENGTH];
+    uint64_t hash;                      // frameHash() at the end of the scenario
+    uint64_t pixels;                    // Most pixels the scenario may send
+    uint32_t transactions;              // Most transactions
+    uint32_t windows;                   // Most address windows
+} goldenFrame_t;
+
+static const char *outputDir = ".";
+static HostFile profileFile;
+static goldenFrame_t golden[GOLDEN_SCENARIOS];
+static uint32_t goldenCount = 0;
+static bool goldenUpdate = false;       // Record this run as the golden frames
+static uint32_t goldenFailures = 0;
+
+static void scenarioBegin(const char *name);
+static void scenarioEnd(const char *name);
+static bool goldenLoad(void);
+static bool goldenSave(void);
+static void goldenCheck(const char *name);
+static uint64_t frameHash(void);
+static void frameBegin(void);
+static void frameEnd(void);
+static bool telemetryThroughput(void);
+static bool telemetryConsistent(const telemetry_t *values);
+static bool energyCheck(void);
+static bool chartRangeCheck(void);
+static bool pageSwitches(void);
+static bool pageRestoreCheck(void);
+static bool pixelShiftCycle(void);
+static bool idleRun(telemetry_t *reading);
+static void matrixRun(void);
+static void telemetryWake(void);
+static bool drawQueueThroughput(void);
+static void drawWake(void);
+static bool touchInputCheck(void);
+static bool gestureCheck(void);
+static bool spiBusCheck(void);
+static void busTouchTask(void *parameter);
+static void busDisplayTask(void *parameter);
+static void busHeld(void);
+static void busFreed(void);
+static bool scriptedTouchRead(touchSample_t *sample);
+static void scriptedTouchNotify(void);
+static uint32_t scriptedTouchNow(void);
+
+static std::atomic<uint32_t> telemetryWakeups(0);
+static std::atomic<uint32_t> drawWakeups(0);
+static std::atomic<uint32_t> touchReads(0);
+static std::atomic<uint32_t> touchNotifies(0);
+static std::atomic<int> busHolders(0);          // Clients between their begin and end hooks
+static std::atomic<uint32_t> busOverlaps(0);    // Times a client got the bus while another held it
+static std::atomic<int64_t> busFrameReserved(0);    // Display's reservation, only changed while it holds the bus
+static std::atomic<bool> busFramesDone(false);
+static std::atomic<int64_t> busTouchAcquired(0);
+static const spiClientConfig_t busClients[SPI_CLIENT_COUNT] = {
+    {"display", busHeld, busFreed, 0},
+    {"touch", busHeld, busFreed, BUS_TOUCH_GAP}
+};
+static const touchSample_t touchScript[TOUCH_SCRIPT_DOWN] = {{120, 80, 0, true}, {124, 83, 0, true}};
+static const touchSource_t scriptedTouch = {scriptedTouchRead, scriptedTouchNotify, scriptedTouchNow};
+static const gestureScript_t gestureScripts[] = {
+    {"glitch", 100, 100, 0, 0, 1, -1},
+    {"bounce", 100, 100, 0, 0, 2, -1},
+    {"tap", 200, 150, 0, 0, 5, TOUCH_TAP},
+    {"long press", 300, 200, 0, 0, 100, TOUCH_LONG_PRESS},
+    {"swipe left", 400, 160, -12, 0, 10, TOUCH_SWIPE_LEFT},
+    {"swipe right", 80, 160, 12, 0, 10, TOUCH_SWIPE_RIGHT},
+    {"swipe up", 240, 280, 0, -12, 10, TOUCH_SWIPE_UP},
+    {"swipe down", 240, 40, 0, 12, 10, TOUCH_SWIPE_DOWN}
+};
+
+
+/**
+ * @brief Start a scenario with the SPI counters cleared.
+ *
+ * @param name Scenario name
+ */
+static void scenarioBegin(const char *name) {
+    Serial.printf("\n== %s ==\n", name);
+    tft.resetStats();
+    spiProfileReset();
+}
+
+/**
+ * @brief Report the SPI traffic of the scenario and save the screen as <name>.ppm.
+ *
+ * @param name Scenario name
+ */
+static void scenarioEnd(const char *name) {
+    char path[256];
+
+    tft.printStats(Serial);
+    spiProfileReport(Serial, false);
+
+    profileFile.printf("== %s ==\n", name);
+    spiProfileReport(profileFile, true);
+    profileFile.flush();
+
+    snprintf(path, sizeof(path), "%s/%s.ppm", outputDir, name);
+    if (tft.writePPM(path))
+        Serial.printf("Saved %s\n", path);
+    else
+        Serial.printf("Failed to save %s\n", path);
+
+    goldenCheck(name);
+}
+
+/**
+ * @brief Compare the scenario just run with its golden frame and budget, or record it
+ * as the golden frame with update.
+ *
+ * @param name Scenario name
+ */
+static void goldenCheck(const char *name) {
+    uint64_t hash = frameHash();
+    const hostSpiStats_t &stats = tft.totalStats();
+    goldenFrame_t *frame = NULL;
+
+    for (uint32_t i = 0; i < goldenCount; i++) {
+        if (strcmp(golden[i].name, name) == 0)
+            frame = &golden[i];
+    }
+
+    if (goldenUpdate) {
+        if (frame == NULL && goldenCount < GOLDEN_SCENARIOS)
+            frame = &golden[goldenCount++];
+        if (frame != NULL) {
+            snprintf(frame->name, sizeof(frame->name), "%s", name);
+            frame->hash = hash;
+            frame->pixels = stats.pixels;
+            frame->transactions = stats.transactions;
+            frame->windows = stats.windows;
+        }
+        return;
+    }
+
+    if (frame == NULL) {
+        Serial.printf("Golden: no frame for %s in %s, run with update\n", name, GOLDEN_FILE);
+        goldenFailures++;
+        return;
+    }
+
+    bool same = hash == frame->hash;
+    bool inBudget = stats.pixels <= frame->pixels && stats.transactions <= frame->transactions &&
+        stats.windows <= frame->windows;
+    Serial.printf("Golden: frame %s, %llu of %llu pixels, %u of %u transactions, %u of %u windows%s\n",
+        same ? "matches" : "differs", (unsigned long long)stats.pixels, (unsigned long long)frame->pixels,
+        (unsigned)stats.transactions, (unsigned)frame->transactions, (unsigned)stats.windows,
+        (unsigned)frame->windows, inBudget ? "" : ", over budget");
+    if (!same || !inBudget)
+        goldenFailures++;
+}
+
+/**
+ * @brief FNV-1a hash of what the panel shows, the framebuffer and the scroll start.
+ *
+ * @return uint64_t Hash
+ */
+static uint64_t frameHash(void) {
+    const uint16_t *pixels = tft.framebuffer();
+    size_t count = (size_t)tft.width() * tft.height();
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ (pixels[i] & 0xff)) * 0x100000001b3ULL;
+        hash = (hash ^ (pixels[i] >> 8)) * 0x100000001b3ULL;
+    }
+    hash = (hash ^ (uint16_t)tft.scrollStart()) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+/**
+ * @brief Read the golden frames, a line per scenario of name, hash, pixels, transactions
+ * and windows. Lines starting with # are comments.
+ *
+ * @return true Read
+ */
+static bool goldenLoad(void) {
+    char line[128];
+    FILE *file = fopen(GOLDEN_FILE, "r");
+
+    if (file == NULL)
+        return false;
+
+    goldenCount = 0;
+    while (goldenCount < GOLDEN_SCENARIOS && fgets(line, sizeof(line), file) != NULL) {
+        goldenFrame_t *frame = &golden[goldenCount];
+        unsigned long long hash, pixels;
+        unsigned transactions, windows;
+
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%15s %llx %llu %u %u", frame->name, &hash, &pixels, &transactions, &windows) == 5) {
+            frame->hash = hash;
+            frame->pixels = pixels;
+            frame->transactions = transactions;
+            frame->windows = windows;
+            goldenCount++;
+        }
+    }
+    fclose(file);
+
+    return true;
+}
+
+/**
+ * @brief Write the golden frames recorded by this run.
+ *
+ * @return true Written
+ */
+static bool goldenSave(void) {
+    HostFile file;
+
+    if (!file.open(GOLDEN_FILE))
+        return false;
+
+    file.println("# Golden frames for the host build, see src/host/hostMain.cpp. Rewrite with");
+    file.println("# program <output directory> update after a change meant to draw differently.");
+    file.println("# scenario, frame hash, most pixels, most transactions, most windows");
+    for (uint32_t i = 0; i < goldenCount; i++) {
+        file.printf("%-12s %016llx %10llu %8u %8u\n", golden[i].name, (unsigned long long)golden[i].hash,
+            (unsigned long long)golden[i].pixels, (unsigned)golden[i].transactions, (unsigned)golden[i].windows);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Start the matrix screen saver from MATRIX_SEED and run it for MATRIX_FRAMES.
+ */
+static void matrixRun(void) {
+    matrixSeed(MATRIX_SEED);
+    startScreenSaver();
+    for (int i = 0; i < MATRIX_FRAMES; i++) {
+        frameBegin();
+        matrix();
+        frameEnd();
+        hostClockAdvance(MATRIX_PERIOD * 1000);
+    }
+}
+
+/**
+ * @brief Take the pixel shift once round its cycle and on to the far right, animating
+ * between moves.  Each move has to be a single pixel and stay within PIXEL_SHIFT_RANGE.
+ *
+ * @return true Every move good
+ */
+static bool pixelShiftCycle(void) {
+    int16_t last = 0;
+    bool good = true;
+
+    showPage(PAGE_DASHBOARD);
+    startPixelShift();
+    for (int i = 0; i < PIXEL_SHIFT_RANGE * 5; i++) {
+        for (int j = 0; j < SHIFT_FRAMES; j++) {
+            frameBegin();
+            animation();
+            frameEnd();
+            hostClockAdvance(ANIMATION_PERIOD * 1000);
+        }
+
+        frameBegin();
+        pixelShift();
+        frameEnd();
+
+        int16_t offset = tft.scrollStart();
+        if (offset > tft.width() / 2)
+            offset -= tft.width();
+        if (abs(offset - last) != 1 || abs(offset) > PIXEL_SHIFT_RANGE)
+            good = false;
+        last = offset;
+    }
+    Serial.printf("Pixel shift at %d after %u moves\n", last, (unsigned)(PIXEL_SHIFT_RANGE * 5));
+
+    return good;
+}
+
+/**
+ * @brief Leave the dashboard for IDLE_TIME with nothing flowing and no touches, waking
+ * only when the display task would: for a power chart sample every CHART_SAMPLE_PERIOD,
+ * at the inactivity timeout that starts the pixel shift and for each of its moves.  Each
+ * wakeup is a frame.  Reports the wakeups a second and the share of the time spent
+ * sending, the CPU time around it isn't modelled.
+ *
+ * @param reading Last reading published, the power is set to zero
+ * @return true Idle, nothing animating and no more than IDLE_WAKEUPS_MAX a second
+ */
+static bool idleRun(telemetry_t *reading) {
+    uint32_t start = millis();
+    uint32_t now = start;
+    uint32_t chartTime = start;
+    uint32_t shiftTime = 0;
+    uint32_t next;
+    uint32_t wakeups = 0;
+    int64_t busy = 0;
+    bool shifting = false;
+    bool animating = false;
+
+    reading->solarPower = 0;
+    reading->gridPower = 0;
+    reading->waterPower = 0;
+    telemetryPublish(reading, TELEMETRY_POWER);
+
+    while (now - start < IDLE_TIME) {
+        int64_t wake = esp_timer_get_time();
+
+        wakeups++;
+        next = chartTime + CHART_SAMPLE_PERIOD;
+        frameBegin();
+        showTelemetry(reading, telemetryTake(reading));
+        animating |= animationActive();
+        if (now - chartTime >= CHART_SAMPLE_PERIOD) {
+            chartTime = now;
+            chartSample();
+            next = chartTime + CHART_SAMPLE_PERIOD;
+        }
+        if (shifting) {
+            if (now - shiftTime >= PIXEL_SHIFT_PERIOD) {
+                shiftTime = now;
+                pixelShift();
+            }
+            next = min(next, shiftTime + PIXEL_SHIFT_PERIOD);
+        } else if (now - start >= IDLE_INACTIVE) {
+            startPixelShift();
+            shifting = true;
+            shiftTime = now;
+            next = now;
+        } else {
+            next = min(next, start + IDLE_INACTIVE);
+        }
+        frameEnd();
+        busy += esp_timer_get_time() - wake;
+
+        if ((int32_t)(next - millis()) > 0)
+            hostClockAdvance((int64_t)(next - millis()) * 1000);
+        now = millis();
+    }
+    stopPixelShift();
+
+    uint32_t perSecond = (uint32_t)((uint64_t)wakeups * 100000 / IDLE_TIME);
+    Serial.printf("%u s idle: %u wakeups, %u.%02u a second, %u ms sending, %u.%03u%% of the time\n",
+        (unsigned)(IDLE_TIME / 1000), (unsigned)wakeups, (unsigned)(perSecond / 100), (unsigned)(perSecond % 100),
+        (unsigned)(busy / 1000), (unsigned)(busy / (IDLE_TIME * 10)), (unsigned)(busy * 1000 / (IDLE_TIME * 10)) % 1000);
+    if (animating)
+        Serial.println("The flow animation ran with no power flowing");
+
+    return !animating && wakeups <= (uint64_t)IDLE_WAKEUPS_MAX * IDLE_TIME / 1000;
+}
+
+/**
+ * @brief Hold the bus for the frame, as the display task does between spiBusAcquire()
+ * and spiBusRelease().
+ */
+static void frameBegin(void) {
+    tft.startWrite();
+}
+
+static void frameEnd(void) {
+    SPI_PROFILE_FRAME();
+    tft.endWrite();
+}
+
+/**
+ * @brief Switch through every page and back to the dashboard, timing each switch with
+ * the simulated clock (which the bus time moves on) and saving each page as
+ * page<n>.ppm.
+ *
+ * @return true Every switch within PAGE_SWITCH_TARGET
+ */
+static bool pageSwitches(void) {
+    char path[256];
+    bool ok = true;
+
+    for (uint8_t i = 1; i <= PAGE_COUNT; i++) {
+        uint8_t page = i % PAGE_COUNT;
+        uint64_t pixels = tft.totalStats().pixels;
+        uint32_t windows = tft.totalStats().windows;
+
+        frameBegin();
+        uint32_t elapsed = showPage(page);
+        frameEnd();
+
+        Serial.printf("Page %u: %u.%02u ms, %u pixels sent in %u windows\n", (unsigned)page, (unsigned)(elapsed / 1000),
+            (unsigned)(elapsed % 1000 / 10), (unsigned)(tft.totalStats().pixels - pixels),
+            (unsigned)(tft.totalStats().windows - windows));
+        if (elapsed > PAGE_SWITCH_TARGET * 1000)
+            ok = false;
+
+        snprintf(path, sizeof(path), "%s/page%u.ppm", outputDir, (unsigned)page);
+        if (!tft.writePPM(path))
+            Serial.printf("Failed to save %s\n", path);
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Make every switch from one page to another and check the screen is the same
+ * as the new page drawn in full from the cache, so the static layers differ and the
+ * live content are in all the right places.
+ *
+ * @return true Every switch matches
+ */
+static bool pageRestoreCheck(void) {
+    std::vector<uint16_t> switched(tft.width() * tft.height());
+    bool ok = true;
+
+    for (uint8_t from = 0; from < PAGE_COUNT; from++) {
+        for (uint8_t to = 0; to < PAGE_COUNT; to++) {
+            if (to == from)
+                continue;
+
+            showPage(from);
+            showPage(to);
+            std::copy(tft.framebuffer(), tft.framebuffer() + switched.size(), switched.begin());
+            initialiseScreen();
+
+            uint32_t differ = 0;
+            for (size_t i = 0; i < switched.size(); i++)
+                differ += switched[i] != tft.framebuffer()[i];
+            if (differ > 0) {
+                Serial.printf("Page %u to %u: %u pixels differ\n", (unsigned)from, (unsigned)to, (unsigned)differ);
+                ok = false;
+            }
+        }
+    }
+    Serial.printf("Page switches %s a full redraw\n", ok ? "match" : "don't match");
+
+    return ok;
+}
+
+/**
+ * @brief Publish as fast as possible from a radio thread (power and energy) and a sender
+ * thread (LQI and battery) while a display thread takes snapshots and TELEMETRY_READERS
+ * threads read the values as any other task would. Each publish is made
+ * self-consistent so a torn snapshot shows up: the radio's fields are all n, or -n for
+ * the grid, and the sender's battery flag is the low bit of its LQI. The radio's n only
+ * goes up, so a snapshot must never see it go back. All the threads yield now and then so
+ * they interleave on a single core too.
+ *
+ * @return true No torn or stale reads
+ */
+static bool telemetryThroughput(void) {
+    std::atomic<int> running(2);
+    std::atomic<uint32_t> reads(0), readsTorn(0);
+    std::thread readers[TELEMETRY_READERS];
+    uint32_t snapshots = 0, changedSnapshots = 0, torn = 0, stale = 0;
+    int32_t lastSolar = 0;
+    telemetry_t values;
+
+    telemetryBegin(telemetryWake);
+    values = {0, 0, 0, 0, 0, 0, false};
+    telemetryPublish(&values, TELEMETRY_ALL);   // a consistent start, then nothing pending
+    telemetryTake(&values);
+    telemetryWakeups = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread radio([&running] {
+        telemetry_t reading;
+        for (int32_t n = 1; n <= TELEMETRY_PUBLISHES; n++) {
+            reading.solarPower = n;
+            reading.gridPower = -n;
+            reading.waterPower = n;
+            reading.solarEnergy = n;
+            reading.waterEnergy = n;
+            telemetryPublish(&reading, TELEMETRY_POWER | TELEMETRY_ENERGY);
+            if ((n & (TELEMETRY_YIELD - 1)) == 0)
+                std::this_thread::yield();
+        }
+        running--;
+    });
+
+    std::thread sender([&running] {
+        telemetry_t reading;
+        for (int32_t n = 1; n <= TELEMETRY_PUBLISHES; n++) {
+            reading.lqi = n & 0xFF;
+            reading.batteryOk = n & 1;
+            telemetryPublish(&reading, TELEMETRY_LQI | TELEMETRY_BATTERY);
+            if ((n & (TELEMETRY_YIELD - 1)) == 0)
+                std::this_thread::yield();
+        }
+        running--;
+    });
+
+    for (int r = 0; r < TELEMETRY_READERS; r++) {
+        readers[r] = std::thread([&running, &reads, &readsTorn] {
+            telemetry_t seen;
+            while (running > 0) {
+                telemetryRead(&seen);
+                reads++;
+                if (!telemetryConsistent(&seen))
+                    readsTorn++;
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    do {
+        uint32_t changed = telemetryTake(&values);
+        snapshots++;
+        if (changed)
+            changedSnapshots++;
+        if (!telemetryConsistent(&values))
+            torn++;
+        if (values.solarPower < lastSolar)
+            stale++;
+        lastSolar = values.solarPower;
+        std::this_thread::yield();
+    } while (running > 0);
+
+    radio.join();
+    sender.join();
+    for (int r = 0; r < TELEMETRY_READERS; r++)
+        readers[r].join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Serial.printf("%u publishes from 2 threads in %.3f s, %.1f M/s\n", (unsigned)(2 * TELEMETRY_PUBLISHES), seconds,
+        2 * TELEMETRY_PUBLISHES / seconds / 1e6);
+    Serial.printf("%u snapshots, %u with changes, %u display wakeups, %u torn, %u stale\n", (unsigned)snapshots,
+        (unsigned)changedSnapshots, (unsigned)telemetryWakeups, (unsigned)torn, (unsigned)stale);
+    Serial.printf("%u reads from %d other threads, %u torn\n", (unsigned)reads, TELEMETRY_READERS, (unsigned)readsTorn);
+    telemetryReport(Serial);
+
+    return torn == 0 && stale == 0 && readsTorn == 0 && values.solarPower == TELEMETRY_PUBLISHES;
+}
+
+/**
+ * @brief Post draw commands as fast as possible from DRAW_PRODUCERS threads while the
+ * display thread takes them DRAW_BATCH at a time. Each producer numbers its commands, a
+ * full ring is retried, so the display must see every producer's commands exactly once
+ * and in order.
+ *
+ * @return true Nothing lost, repeated or out of order
+ */
+static bool drawQueueThroughput(void) {
+    std::atomic<int> running(DRAW_PRODUCERS);
+    std::thread producers[DRAW_PRODUCERS];
+    int32_t next[DRAW_PRODUCERS] = {0};
+    drawCommand_t batch[DRAW_BATCH];
+    uint32_t taken = 0, batches = 0, full = 0, wrong = 0;
+    std::atomic<uint32_t> fullRetries(0);
+
+    drawQueueBegin(drawWake);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < DRAW_PRODUCERS; p++) {
+        producers[p] = std::thread([p, &running, &fullRetries] {
+            drawCommand_t command = {DRAW_LOG, (uint8_t)p, 0, ""};
+            for (int32_t n = 0; n < DRAW_POSTS; n++) {
+                command.value = n;
+                snprintf(command.text, sizeof(command.text), "%d:%d", p, (int)n);
+                while (!drawQueuePost(&command)) {
+                    fullRetries++;
+                    std::this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+
+    uint32_t count;
+    do {
+        count = drawQueueTake(batch, DRAW_BATCH);
+        for (uint32_t i = 0; i < count; i++) {
+            char text[DRAW_TEXT_LENGTH];
+            uint8_t p = batch[i].source;
+            snprintf(text, sizeof(text), "%d:%d", p, (int)batch[i].value);
+            if (p >= DRAW_PRODUCERS || batch[i].value != next[p] || strcmp(text, batch[i].text) != 0)
+                wrong++;
+            else
+                next[p]++;
+        }
+        taken += count;
+        batches += count > 0;
+        if (count < DRAW_BATCH)
+            std::this_thread::yield();
+    } while (running > 0 || count > 0);
+
+    for (int p = 0; p < DRAW_PRODUCERS; p++)
+        producers[p].join();
+    while ((count = drawQueueTake(batch, DRAW_BATCH)) > 0) {
+        for (uint32_t i = 0; i < count; i++)
+            wrong += batch[i].value != next[batch[i].source]++;
+        taken += count;
+    }
+    full = fullRetries;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Serial.printf("%u commands from %d threads in %.3f s, %.1f M/s\n", (unsigned)taken, DRAW_PRODUCERS, seconds,
+        taken / seconds / 1e6);
+    Serial.printf("%u batches, %u display wakeups, %u posts retried on a full ring, %u wrong\n", (unsigned)batches,
+        (unsigned)drawWakeups, (unsigned)full, (unsigned)wrong);
+    drawQueueReport(Serial);
+
+    return wrong == 0 && taken == (uint32_t)(DRAW_PRODUCERS * DRAW_POSTS);
+}
+
+static void drawWake(void) {
+    drawWakeups++;
+}
+
+/**
+ * @brief Run the touch reader task with the clock in real time against touchScript: the
+ * pen goes down, is read TOUCH_SCRIPT_DOWN times and then lifts. Nothing may be read
+ * before the simulated IRQ or after the touch ends, the samples must be queued in order
+ * and the touch ended with one pen up sample.
+ *
+ * @return true Samples and reads as expected
+ */
+static bool touchInputCheck(void) {
+    touchSample_t samples[TOUCH_QUEUE_LENGTH];
+    uint32_t count = 0;
+    bool ok = true;
+
+    hostClockRealTime(true);
+    if (!touchInputBegin(&scriptedTouch, true)) {
+        hostClockRealTime(false);
+        return false;
+    }
+
+    delay(TOUCH_IDLE_WAIT);
+    uint32_t idleReads = touchReads;
+
+    touchInputIrq();
+    delay(TOUCH_IDLE_WAIT);
+    uint32_t reads = touchReads;
+
+    delay(TOUCH_IDLE_WAIT);
+    uint32_t laterReads = touchReads;
+
+    while (count < TOUCH_QUEUE_LENGTH && touchInputRead(&samples[count]))
+        count++;
+
+    touchInputEnd();
+    hostTasksJoin();
+    hostClockRealTime(false);
+
+    Serial.printf("%u reads before the IRQ, %u for the touch, %u after it, %u samples queued, %u notifies\n",
+        (unsigned)idleReads, (unsigned)reads, (unsigned)(laterReads - reads), (unsigned)count,
+        (unsigned)touchNotifies);
+
+    if (idleReads != 0 || laterReads != reads) {
+        Serial.println("Touch read while the IRQ was idle");
+        ok = false;
+    }
+    if (reads != TOUCH_SCRIPT_DOWN + TOUCH_RELEASE_SAMPLES || count != TOUCH_SCRIPT_DOWN + 1 ||
+        touchNotifies != count || touchInputOverruns() != 0) {
+        Serial.println("Touch samples missing or extra");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < TOUCH_SCRIPT_DOWN; i++) {
+        if (!samples[i].down || samples[i].x != touchScript[i].x || samples[i].y != touchScript[i].y)
+            ok = false;
+    }
+    const touchSample_t *up = &samples[TOUCH_SCRIPT_DOWN];
+    if (up->down || up->time < samples[TOUCH_SCRIPT_DOWN - 1].time + TOUCH_RELEASE_SAMPLES * TOUCH_SAMPLE_INTERVAL) {
+        Serial.println("Touch not ended by a pen up sample after the missed reads");
+        ok = false;
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Run the SPI bus arbiter with the clock in real time, the display and touch
+ * reader on their own tasks as on the ESP32:
+ *
+ *      deferral    the display has reserved the bus within the touch read's gap, the
+ *                  touch read must wait until the display has had its frame
+ *      cap         the display reserves the bus and never takes it, the touch read
+ *                  must get it after SPI_BUS_MAX_DEFER
+ *      race        BUS_FRAMES frames, each reserving the next before releasing the bus
+ *                  as the display task does, against touch reads back to back.  No read
+ *                  may start with the display's next frame due within its gap, none
+ *                  may hit the cap, and the bus must never be held by both
+ *
+ * @return true The arbiter kept the touch reads in the gaps between frames
+ */
+static bool spiBusCheck(void) {
+    TaskHandle_t touchTask;
+    int64_t start;
+    int64_t released;
+    int64_t acquired;
+    bool ok = true;
+
+    hostClockRealTime(true);
+    if (!spiBusBegin(busClients)) {
+        hostClockRealTime(false);
+        return false;
+    }
+
+    // Deferral, the touch read asks for the bus just before the display's frame is due
+    spiBusReserve(SPI_CLIENT_DISPLAY, esp_timer_get_time() + BUS_TOUCH_GAP / 2);
+    busTouchAcquired = 0;
+    xTaskCreate(busTouchTask, "busTouch", 0, (void *)1, 0, &touchTask);
+    delay(BUS_TOUCH_GAP / 2000);
+    spiBusAcquire(SPI_CLIENT_DISPLAY);
+    delay(BUS_FRAME_HOLD);
+    released = esp_timer_get_time();
+    spiBusRelease(SPI_CLIENT_DISPLAY);
+    hostTasksJoin();
+    Serial.printf("Deferral: touch read %d us after the frame\n", (int)(busTouchAcquired - released));
+    if (busTouchAcquired < released) {
+        Serial.println("Touch read took the bus from under the display's reservation");
+        ok = false;
+    }
+
+    // Cap, the display reserves the bus and doesn't come for it
+    spiBusReserve(SPI_CLIENT_DISPLAY, esp_timer_get_time() + BUS_TOUCH_GAP / 2);
+    start = esp_timer_get_time();
+    spiBusAcquire(SPI_CLIENT_TOUCH);
+    acquired = esp_timer_get_time();
+    spiBusRelease(SPI_CLIENT_TOUCH);
+    spiBusReserve(SPI_CLIENT_DISPLAY, 0);
+    Serial.printf("Cap: touch read waited %u us for a reservation not taken up\n", (unsigned)(acquired - start));
+    if (acquired - start < SPI_BUS_MAX_DEFER || acquired - start > SPI_BUS_MAX_DEFER + BUS_DEFER_SLACK) {
+        Serial.printf("Touch read not deferred for %u us\n", (unsigned)SPI_BUS_MAX_DEFER);
+        ok = false;
+    }
+
+    // Race, frames against back to back touch reads
+    TaskHandle_t displayTask;
+    uint32_t violations[2] = {0, 0};    // Reads started within the gap, reads capped
+    uint32_t reads = 0;
+    busFramesDone = false;
+    busFrameReserved = esp_timer_get_time() + BUS_FRAME_GAP * 1000;
+    spiBusReserve(SPI_CLIENT_DISPLAY, busFrameReserved);
+    xTaskCreate(busDisplayTask, "busDisplay", 0, NULL, 0, &displayTask);
+    while (!busFramesDone) {
+        start = esp_timer_get_time();
+        spiBusAcquire(SPI_CLIENT_TOUCH);
+        acquired = esp_timer_get_time();
+        int64_t frame = busFrameReserved;
+        if (frame != 0 && frame < start + BUS_TOUCH_GAP)
+            violations[0]++;
+        if (acquired - start >= SPI_BUS_MAX_DEFER)
+            violations[1]++;
+        reads++;
+        delay(BUS_TOUCH_HOLD);
+        spiBusRelease(SPI_CLIENT_TOUCH);
+    }
+    hostTasksJoin();
+    hostClockRealTime(false);
+
+    Serial.printf("Race: %u frames, %u touch reads, %u in a frame's gap, %u capped, %u overlaps\n",
+        (unsigned)BUS_FRAMES, (unsigned)reads, (unsigned)violations[0], (unsigned)violations[1],
+        (unsigned)busOverlaps);
+    spiBusReport(Serial);
+
+    return ok && reads > 0 && violations[0] == 0 && violations[1] == 0 && busOverlaps == 0;
+}
+
+/**
+ * @brief A touch read, for the deferral check.
+ */
+static void busTouchTask(void *parameter) {
+    (void)parameter;
+    spiBusAcquire(SPI_CLIENT_TOUCH);
+    busTouchAcquired = esp_timer_get_time();
+    spiBusRelease(SPI_CLIENT_TOUCH);
+}
+
+/**
+ * @brief BUS_FRAMES frames as the display task draws them, each holding the bus for
+ * BUS_FRAME_HOLD and reserving it for the next before letting it go. The first frame
+ * has already been reserved.
+ */
+static void busDisplayTask(void *parameter) {
+    int64_t next;
+
+    (void)parameter;
+    delay(BUS_FRAME_GAP);               // first frame as reserved by spiBusCheck()
+    for (int i = 0; i < BUS_FRAMES; i++) {
+        spiBusAcquire(SPI_CLIENT_DISPLAY);
+        busFrameReserved = 0;
+        delay(BUS_FRAME_HOLD);
+        next = esp_timer_get_time() + BUS_FRAME_GAP * 1000;
+        if (i < BUS_FRAMES - 1) {
+            busFrameReserved = next;
+            spiBusReserve(SPI_CLIENT_DISPLAY, next);
+        }
+        spiBusRelease(SPI_CLIENT_DISPLAY);
+        delay(BUS_FRAME_GAP);
+    }
+    busFramesDone = true;
+}
+
+static void busHeld(void) {
+    if (busHolders++ != 0)
+        busOverlaps++;
+}
+
+static void busFreed(void) {
+    busHolders--;
+}
+
+/**
+ * @brief Feed each of gestureScripts to the gesture engine as the touch reader would, a
+ * sample every TOUCH_SAMPLE_INTERVAL with a pixel of noise, then the pen up sample after
+ * TOUCH_RELEASE_SAMPLES missed reads. Each must give its gesture and nothing else, at the
+ * touch's first sample with the start and completing sample's times, or no gesture.
+ *
+ * @return true Every script gave what it should
+ */
+static bool gestureCheck(void) {
+    TouchGestureEngine engine;
+    uint32_t time = 1000;
+    bool ok = true;
+
+    for (const gestureScript_t &script : gestureScripts) {
+        touchGesture_t gesture, found = {};
+        uint32_t count = 0;
+        uint32_t start = time;
+        uint32_t expected = 0;
+
+        for (uint8_t i = 0; i < script.downSamples; i++) {
+            uint16_t x = script.x + script.stepX * i + (i & 1);
+            uint16_t y = script.y + script.stepY * i + (i & 1);
+            if (engine.update(x, y, time, true, &gesture)) {
+                found = gesture;
+                count++;
+            }
+            if (i < script.downSamples - 1)
+                time += TOUCH_SAMPLE_INTERVAL;
+        }
+        time += (TOUCH_RELEASE_SAMPLES + 1) * TOUCH_SAMPLE_INTERVAL;
+        if (engine.update(0, 0, time, false, &gesture)) {
+            found = gesture;
+            count++;
+        }
+
+        if (script.gesture == TOUCH_LONG_PRESS)
+            expected = start + TOUCH_LONG_PRESS_TIME;
+        else
+            expected = time;
+
+        bool good;
+        if (script.gesture < 0) {
+            good = count == 0;
+            Serial.printf("%-12s %s\n", script.name, count == 0 ? "no gesture" : "gave a gesture");
+        } else {
+            good = count == 1 && found.type == script.gesture && found.x == script.x && found.y == script.y &&
+                found.start == start && found.time == expected;
+            Serial.printf("%-12s %u gestures, type %d at %u,%u, %u ms after the first sample\n", script.name,
+                (unsigned)count, count > 0 ? (int)found.type : -1, count > 0 ? found.x : 0, count > 0 ? found.y : 0,
+                count > 0 ? (unsigned)(found.time - found.start) : 0);
+        }
+        ok &= good;
+
+        time += 1000;
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Scripted touch controller, the pen is down for the first TOUCH_SCRIPT_DOWN reads
+ * and up from then on.
+ */
+static bool scriptedTouchRead(touchSample_t *sample) {
+    uint32_t read = touchReads++;
+
+    if (read >= TOUCH_SCRIPT_DOWN)
+        return false;
+
+    *sample = touchScript[read];
+    sample->time = millis();
+    return true;
+}
+
+static void scriptedTouchNotify(void) {
+    touchNotifies++;
+}
+
+static uint32_t scriptedTouchNow(void) {
+    return millis();
+}
+
+/**
+ * @brief Do the values come from one publish by each producer thread?
+ *
+ */
+static bool telemetryConsistent(const telemetry_t *values) {
+    return values->gridPower == -values->solarPower && values->waterPower == values->solarPower &&
+        values->solarEnergy == (uint32_t)values->solarPower && values->waterEnergy == (uint32_t)values->solarPower &&
+        values->batteryOk == (bool)(values->lqi & 1);
+}
+
+/**
+ * @brief Run the energy meter from 22:00 to 02:00 with a 10 minute gap at 23:00, 1 kW of
+ * solar throughout and the water heater ramping 0 to 3.6 kW over the first hour. The
+ * trapezoid rule is exact for both, so the totals must match to the Wh. Then check that a
+ * checkpoint restores.
+ *
+ * @return true Totals as expected
+ */
+static bool energyCheck(void) {
+    EnergyMeter meter, restored, demo;
+    int32_t power[ENERGY_CHANNELS] = {1000, 0, 0, 0};
+    int64_t midnight = ENERGY_START + 2 * 3600000LL - 1000;
+    uint32_t newDays = 0, beforeMidnight = 0, waterBefore = 0;
+    bool ok;
+
+    setenv("TZ", "UTC", 1);
+    tzset();
+    meter.begin(ENERGY_START);
+
+    for (int64_t t = ENERGY_START; t <= ENERGY_END; t += ENERGY_SAMPLE) {
+        if (t > ENERGY_GAP_START && t < ENERGY_GAP_END)
+            continue;
+        power[ENERGY_WATER] = t - ENERGY_START <= 3600000LL ? (t - ENERGY_START) / 1000 : 0;
+        if (t > midnight - ENERGY_SAMPLE && t < midnight) {
+            beforeMidnight = meter.todayWh(ENERGY_SOLAR);
+            waterBefore = meter.todayWh(ENERGY_WATER);
+        }
+        if (meter.addSample(t, power)) {
+            newDays++;
+            meter.report(Serial);
+        }
+        meter.checkpoint(t);
+    }
+    meter.report(Serial);
+
+    // 1 kW from 22:00:01 to 23:59:59 less the gap, and 00:00:00 to 02:00:01
+    uint32_t expectBefore = (uint32_t)((midnight - ENERGY_SAMPLE + 1000 - ENERGY_START - 600000LL) * 1000 / ENERGY_MJ_PER_WH);
+    uint32_t expectToday = (uint32_t)((ENERGY_END - midnight - 1000) * 1000 / ENERGY_MJ_PER_WH);
+    ok = newDays == 1 && meter.getGaps() == 1 && beforeMidnight == expectBefore && waterBefore == 1800 &&
+        meter.todayWh(ENERGY_SOLAR) == expectToday;
+    Serial.printf("Before midnight %u Wh (expected %u), water %u Wh (expected 1800), today %u Wh (expected %u), %u new day, %u gap\n",
+        (unsigned)beforeMidnight, (unsigned)expectBefore, (unsigned)waterBefore, (unsigned)meter.todayWh(ENERGY_SOLAR),
+        (unsigned)expectToday, (unsigned)newDays, (unsigned)meter.getGaps());
+
+    meter.checkpoint(ENERGY_END, true);
+    restored.begin(ENERGY_END + ENERGY_SAMPLE);
+    Serial.print("Restored: ");
+    restored.report(Serial);
+
+    // The demo sender's totals are kept in another namespace, they start from nothing
+    demo.begin(ENERGY_END + ENERGY_SAMPLE, "energyDemo");
+    Serial.print("Demo namespace: ");
+    demo.report(Serial);
+
+    return ok && restored.todayWh(ENERGY_SOLAR) == meter.todayWh(ENERGY_SOLAR) &&
+        restored.totalKWh(ENERGY_SOLAR) == meter.totalKWh(ENERGY_SOLAR) && demo.totalKWh(ENERGY_SOLAR) == 0;
+}
+
+/**
+ * @brief A 5 kW spike, then quiet columns until it scrolls off. The range must grow to
+ * 5 kW, stay while the spike is shown and shrink back to 1 kW the sample it leaves.
+ */
+static bool chartRangeCheck(void) {
+    PowerChart chart(&tft);             // never begun, so nothing is drawn and a sample is a column
+    uint32_t rescales = 0, shrunkAt = 0;
+    bool grown = false;
+
+    for (uint32_t sample = 0; sample <= CHART_WIDTH; sample++) {
+        if (chart.addSample(sample == 0 ? 5000 : 500, 0, 0)) {
+            rescales++;
+            if (chart.getRange() == 5000)
+                grown = true;
+            else
+                shrunkAt = sample;
+        }
+    }
+
+    Serial.printf("Range %u W after %u rescales, shrunk at sample %u (expected %u)\n", (unsigned)chart.getRange(),
+        (unsigned)rescales, (unsigned)shrunkAt, (unsigned)CHART_WIDTH);
+
+    return grown && rescales == 2 && chart.getRange() == CHART_RANGE_STEP && shrunkAt == CHART_WIDTH;
+}
+
+static void telemetryWake(void) {
+    telemetryWakeups++;
+}
+
+int main(int argc, char *argv[]) {
+    telemetry_t reading;
+
+    char path[256];
+
+    if (argc > 1)
+        outputDir = argv[1];
+    for (int i = 2; i < argc; i++)
+        goldenUpdate |= strcmp(argv[i], "update") == 0;
+
+    if (!goldenLoad() && !goldenUpdate)
+        Serial.printf("No golden frames in %s\n", GOLDEN_FILE);
+
+    randomSeed(1);
+
+    snprintf(path, sizeof(path), "%s/spi_profile.txt", outputDir);
+    if (!profileFile.open(path))
+        Serial.printf("Failed to open %s\n", path);
+
+    // Boot, as the display task does it
+    scenarioBegin("boot");
+    tft.init();
+    tft.setRotation(3);
+    tft.setSwapBytes(true);
+    spiProfilerBegin(&tft);
+    createSprites();
+    smoothFonts = loadSmoothFonts();
+    createPages();
+    initialiseScreen();
+    updateLog("Sender Battery OK");
+    updateLog("Heating OFF");
+    updateLog("Water Tank: HOT");
+    scenarioEnd("boot");
+
+    // Flow animation, all lanes that are on by default
+    scenarioBegin("animation");
+    uint32_t ticksDrawn = 0;
+    for (int i = 0; i < ANIMATION_FRAMES; i++) {
+        frameBegin();
+        ticksDrawn += animation();
+        frameEnd();
+        hostClockAdvance(ANIMATION_PERIOD * 1000);
+    }
+    Serial.printf("%u of %u ticks drawn\n", (unsigned)ticksDrawn, (unsigned)ANIMATION_FRAMES);
+    scenarioEnd("animation");
+
+    // Log area, a burst of messages each redrawing the whole log sprite
+    scenarioBegin("log");
+    for (int i = 0; i < LOG_BURST; i++) {
+        char msg[44];
+        snprintf(msg, sizeof(msg), "Log message %d", i);
+        frameBegin();
+        updateLog(msg);
+        frameEnd();
+    }
+    scenarioEnd("log");
+
+    // Matrix screen saver, then again from the same seed to check it draws the same
+    scenarioBegin("matrix");
+    matrixRun();
+    scenarioEnd("matrix");
+    std::vector<uint16_t> matrixFrame(tft.framebuffer(), tft.framebuffer() + tft.width() * tft.height());
+    matrixRun();
+    if (!std::equal(matrixFrame.begin(), matrixFrame.end(), tft.framebuffer())) {
+        Serial.println("Matrix frames differ from the same seed");
+        return 1;
+    }
+
+    // Leaving the screen saver with a tap, as the display task does
+    scenarioBegin("saverexit");
+    frameBegin();
+    screenSaverActive = false;
+    initialiseScreen();
+    updateLog("Screen saver stopped by user");
+    frameEnd();
+    scenarioEnd("saverexit");
+
+    // Telemetry arriving, exporting then importing, drawn as the display task does, only
+    // taking the bus when the values changed or an arrow reached another pixel
+    scenarioBegin("telemetry");
+    telemetryBegin(NULL);
+    tft.startWrite();
+    screenSaverActive = false;
+    initialiseScreen();
+    tft.endWrite();
+    reading = {3900, -450, 3000, 14100, 3810, 31, false};
+    telemetryPublish(&reading, TELEMETRY_ALL);
+    ticksDrawn = 0;
+    for (int i = 0; i < ANIMATION_FRAMES; i++) {
+        uint32_t changed;
+        bool held = false;
+
+        if (i == ANIMATION_FRAMES / 2) {
+            reading.solarPower = 120;
+            reading.gridPower = 330;
+            reading.waterPower = 0;
+            telemetryPublish(&reading, TELEMETRY_POWER);
+        }
+        changed = telemetryTake(&reading);
+        if (changed != 0) {
+            frameBegin();
+            held = true;
+            showTelemetry(&reading, changed);
+        }
+        if (animationStep()) {
+            if (!held)
+                frameBegin();
+            held = true;
+            animationDraw();
+        }
+        if (held)
+            frameEnd();
+        ticksDrawn += held && i >= ANIMATION_FRAMES / 2;
+        hostClockAdvance(ANIMATION_PERIOD * 1000);
+    }
+    Serial.printf("%u of %u ticks took the bus at low power\n", (unsigned)ticksDrawn, (unsigned)(ANIMATION_FRAMES / 2));
+    scenarioEnd("telemetry");
+
+    // Power chart, a day's worth of solar curve squeezed in so the chart wraps, each
+    // sample a frame so the profile shows the cost per sample staying the same
+    scenarioBegin("chart");
+    for (int i = 0; i < CHART_COLUMNS * CHART_SAMPLES_PER_COLUMN; i++) {
+        int32_t solar = 3600 * sin(M_PI * i / (CHART_COLUMNS * CHART_SAMPLES_PER_COLUMN)) + random(-200, 200);
+        reading.solarPower = max(solar, (int32_t)0);
+        reading.waterPower = constrain(reading.solarPower - 450, 0, 3000);
+        reading.gridPower = 450 + reading.waterPower - reading.solarPower;
+        telemetryPublish(&reading, TELEMETRY_POWER);
+        frameBegin();
+        showTelemetry(&reading, telemetryTake(&reading));
+        chartSample();
+        frameEnd();
+        hostClockAdvance(CHART_SAMPLE_PERIOD * 1000);
+    }
+    scenarioEnd("chart");
+
+    // Every page in turn and back to the dashboard, each switch a frame
+    scenarioBegin("pages");
+    bool pagesFast = pageSwitches();
+    scenarioEnd("pages");
+    if (!pagesFast) {
+        Serial.printf("Page switches over %u ms\n", (unsigned)PAGE_SWITCH_TARGET);
+        return 1;
+    }
+    if (!pageRestoreCheck()) {
+        Serial.println("Page switches leave the screen different to a full redraw");
+        return 1;
+    }
+
+    // Pixel shift screen saver, the dashboard still animating underneath, saved shifted
+    scenarioBegin("pixelshift");
+    bool shiftGood = pixelShiftCycle();
+    scenarioEnd("pixelshift");
+    stopPixelShift();
+    if (!shiftGood || tft.scrollStart() != 0) {
+        Serial.println("Pixel shift moved the wrong way or did not stop");
+        return 1;
+    }
+
+    // Dashboard left alone, nothing flowing and no touches
+    scenarioBegin("idle");
+    bool idle = idleRun(&reading);
+    scenarioEnd("idle");
+    if (!idle) {
+        Serial.printf("Idle screen animated or woke more than %u times a second\n", (unsigned)IDLE_WAKEUPS_MAX);
+        return 1;
+    }
+
+    if (goldenUpdate) {
+        if (!goldenSave()) {
+            Serial.printf("Failed to save %s\n", GOLDEN_FILE);
+            return 1;
+        }
+        Serial.printf("Saved %u golden frames to %s\n", (unsigned)goldenCount, GOLDEN_FILE);
+    } else if (goldenFailures > 0) {
+        Serial.printf("%u scenarios differ from their golden frames or are over budget\n", (unsigned)goldenFailures);
+        return 1;
+    }
+
+    Serial.printf("\n== energy ==\n");
+    if (!energyCheck()) {
+        Serial.println("Energy totals are wrong");
+        return 1;
+    }
+
+    Serial.printf("\n== chart range ==\n");
+    if (!chartRangeCheck()) {
+        Serial.println("The chart range did not follow the columns shown");
+        return 1;
+    }
+
+    Serial.printf("\n== telemetry throughput ==\n");
+    if (!telemetryThroughput()) {
+        Serial.println("Telemetry reads were torn or stale");
+        return 1;
+    }
+
+    Serial.printf("\n== draw queue ==\n");
+    if (!drawQueueThroughput()) {
+        Serial.println("Draw commands were lost or out of order");
+        return 1;
+    }
+
+    Serial.printf("\n== touch input ==\n");
+    if (!touchInputCheck()) {
+        Serial.println("Touch input samples were wrong");
+        return 1;
+    }
+
+    Serial.printf("\n== touch gestures ==\n");
+    if (!gestureCheck()) {
+        Serial.println("Touch gestures were wrong");
+        return 1;
+    }
+
+    Serial.printf("\n== SPI bus ==\n");
+    if (!spiBusCheck()) {
+        Serial.println("Touch reads were not kept out of the display's frames");
+        return 1;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "arch") == 0)
+            archBenchmark();
+    }
+
+    return 0;
+}
@@ -14,6 +14,7 @@
         #define TFT_RST  4      // Reset pin (could connect to Arduino RESET pin)
         #define TFT_BL   3.3v   // LED back-light
         #define TOUCH_CS 21     // Chip select pin (T_CS) of touch screen
+        #define SMOOTH_FONT     // Anti-aliased fonts loaded from the font partition
 
         HSPI
         #define TFT_MOSI 13     // In some display driver board, it might be written as "SDA" and so on.
@@ -25,6 +26,11 @@
         #define TFT_BL   3.3v   // LED back-light
         #define TOUCH_CS 4      // Chip select pin (T_CS) of touch screen
 
+    Split, build with -DTOUCH_SEPARATE_SPI (env:upesy_wroom_split)
+        Display on VSPI as above, touch controller on HSPI driven by xpt2046.cpp, TFT_eSPI's
+        TOUCH_CS stays defined for the calibration functions but the pin is not used.
+        T_CLK 14, T_DO 12, T_DIN 13, T_CS 15
+
     Thanks to https://github.com/OscarCalero/TFT_ILI9486/blob/main/Imagenes_SD_y_Touch.ino for his video and
     code to get me started in the right direction.
 */
@@ -33,19 +39,26 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "TFT_eSPI.h"
 #include "img_logo.h"
+#include "fontPartition.h"
+#include "touchInput.h"
+#include "touchGesture.h"
+#include "spiBus.h"
+#include "xpt2046.h"
+#include "touchCalibration.h"
+#include "spiProfiler.h"
+#include "taskStats.h"
+#include "taskConfig.h"
+#include "memTelemetry.h"
+#include "telemetry.h"
+#include "drawQueue.h"
+#include "energy.h"
+#include "screen.h"
 
-/*
-    CLOG_ENABLE Needs to be defined before cLog.h is included.  
-    
-    Using cLog's linked list to hold log messages which will be displayed in the log
-    area as required. Can display up to 7 messages each up to 43 characters wide. New
-    messages will replace older ones and the screen will then be updated.
-*/ 
-
-#define CLOG_ENABLE true
-#include "cLog.h"
 
 /*
     VSPI port for ESP32 && TFT ILI9486 480x320 with touch & SD card reader
@@ -63,7 +76,13 @@
     11 T_CS                 21
     12 T_DIN (SPI MOSI)     23 (same as LCD)
     13 T_DO (SPI MISO)      19 (same as LCD)
-    14 T_IRQ                Currently not connected
+    14 T_IRQ                Currently not connected (set TOUCH_IRQ to the pin if it is)
+
+    With TOUCH_SEPARATE_SPI the touch controller moves to HSPI, the display stays as above
+    10 T_CLK (SPI)          14
+    11 T_CS                 15
+    12 T_DIN (SPI MOSI)     13
+    13 T_DO (SPI MISO)      12
 
 
     HSPI port for ESP32 && TFT ILI9486 480x320 with touch & SD card reader
@@ -88,114 +107,160 @@
 // freeRTOS - one task for all the screen activity, for use in iBoost as it's own task.
 TaskHandle_t displayTaskHandle = NULL;
 void displayTask(void *parameter);
-//
 
-TFT_eSPI tft = TFT_eSPI();              // TFT object
+// The display task sleeps on this event group until there is something to do, either one
+// of these events or the next timer deadline (animation, screen saver).
+EventGroupHandle_t displayEvents = NULL;
+#define DISPLAY_EVENT_TOUCH (1 << 0)    // Touch samples queued by the touch reader task
+#define DISPLAY_EVENT_DATA  (1 << 1)    // New telemetry to show, see telemetryPublish()
+#define DISPLAY_EVENT_STATS (1 << 2)    // Print the task and display stats, 's' on Serial or a long press
+#define DISPLAY_EVENT_DRAW  (1 << 3)    // Draw commands posted, see drawQueuePost()
+#define DISPLAY_EVENT_ALL   (DISPLAY_EVENT_TOUCH | DISPLAY_EVENT_DATA | DISPLAY_EVENT_STATS | DISPLAY_EVENT_DRAW)
+#define DISPLAY_DRAW_BATCH 4            // Draw commands taken at a time
+#define DISPLAY_TASK_STACK 3072         // Core and priority of every task in taskConfig.h
+#define DISPLAY_STATS false             // Also report the display stats every DISPLAY_STATS_PERIOD, not just on 's'
+#define DISPLAY_STATS_PERIOD 10000      // every 10 seconds
+#define MEM_TELEMETRY_PERIOD 10000      // Heap and stack sample every 10 seconds, 'm' on Serial to dump
+#define MEM_BLOCK_WARNING (270 * 75 * 2)    // Log sprite, the biggest allocated after boot
+#define SCREEN_SAVER_PIXEL_SHIFT true   // After inactivity shift the dashboard about, false for the matrix
+void displayNotify(EventBits_t events);
+
+// Simulated sender publishing readings until the radio is added, see demoSenderTask()
+#ifndef TELEMETRY_DEMO
+#define TELEMETRY_DEMO false            // -DTELEMETRY_DEMO=true to run it
+#endif
+#define DEMO_SEND_PERIOD 2000           // A reading every 2 seconds
+#define DEMO_HOUSE_LOAD 450             // W used by the house
+#define DEMO_HEATER_POWER 3000          // W of the immersion heater
+#define DEMO_TASK_STACK 2048
+#define DEMO_ENERGY_NAMESPACE "energyDemo"  // Simulated kWh are checkpointed here, not over the real totals
+
+// Today's totals integrated from whatever power readings are published, see energyTask()
+#define ENERGY_SAMPLE_PERIOD 2000       // ms, as often as the sender publishes
+#define ENERGY_TASK_STACK 4096          // NVS writes for the energy checkpoints need the room
+
+//
 
-TFT_eSprite lineSprite = TFT_eSprite(&tft);    // Sprite object
-TFT_eSprite rightArrowSprite = TFT_eSprite(&tft);    // Sprite object
-TFT_eSprite leftArrowSprite = TFT_eSprite(&tft);    // Sprite object
-TFT_eSprite fillFrameSprite = TFT_eSprite(&tft);    // Sprite object
-TFT_eSprite logSprite = TFT_eSprite(&tft);    // Sprite object for log area
 
 // TFT specific defines
 //#define TOUCH_CS 21             // Touch CS to PIN 21 for VSPI, PIN 4 for HSPI
-#define REPEAT_CAL false        // True if calibration is requested after reboot
-#define TFT_GREY    0x5AEB
-#define TFT_TEAL    0x028A      // RGB 00 80 80
-#define TFT_GREEN_ENERGY    0x1d85  // RGB 3 44 5
-
-#define TFT_BACKGROUND 0x3189 // 0x2969 // 0x4a31 // TFT_BLACK
-#define TFT_FOREGROUND TFT_WHITE
-#define TFT_WATERTANK_HOT TFT_RED
-#define TFT_WATERTANK_WARM TFT_PURPLE
-#define TFT_WATERTANK_COLD TFT_BLUE
+#define TOUCH_IRQ -1            // T_IRQ pin, -1 if not connected and the touch reader task has to poll
+#define TOUCH_Z_THRESHOLD 350   // Minimum XPT2046 pressure for a valid sample
+#ifndef TOUCH_LOG_GESTURES
+#define TOUCH_LOG_GESTURES false    // -DTOUCH_LOG_GESTURES=true prints each gesture and its latency
+#endif
+
+// Touch controller on its own SPI host so touch reads never wait for the display,
+// -DTOUCH_SEPARATE_SPI selects this layout
+#ifdef TOUCH_SEPARATE_SPI
+#define TOUCH_HSPI_SCLK 14
+#define TOUCH_HSPI_MISO 12
+#define TOUCH_HSPI_MOSI 13
+#define TOUCH_HSPI_CS   15
+XPT2046 touchController(HSPI, TOUCH_HSPI_SCLK, TOUCH_HSPI_MISO, TOUCH_HSPI_MOSI, TOUCH_HSPI_CS);
+#endif
+
+// -DTOUCH_LATENCY_BENCH times touch reads during back to back full screen redraws at boot,
+// build with and without TOUCH_SEPARATE_SPI to compare the two layouts
+#ifdef TOUCH_LATENCY_BENCH
+#define BENCH_REDRAWS 100
+volatile uint32_t benchTouchReads = 0;
+volatile int64_t benchTouchTime = 0;
+volatile int64_t benchTouchMax = 0;
+static void touchLatencyBenchmark(void);
+#endif
+// -DTASK_JITTER_BENCH times the animation frames at boot, with no load and then a simulated
+// network load on each core in turn, to show what the task topology (taskConfig.h) buys
+#ifdef TASK_JITTER_BENCH
+#define JITTER_FRAMES 200
+#define JITTER_PERIOD 50            // ms, as the animation
+static void frameJitterBenchmark(void);
+static void frameJitterRun(const char *name, int core);
+static void networkLoadTask(void *parameter);
+#endif
+#define REPEAT_CAL false        // True to calibrate at boot even if there is saved calibration
 
 #define totalButtonNumber 3
 #define LABEL1_FONT &FreeSansOblique12pt7b  // Key label font 1
 #define LABEL2_FONT &FreeSansBold12pt7b     // Key label font 2
 TFT_eSPI_Button key[totalButtonNumber];     // TFT_eSPI button class
 
-// Screen Saver 
-#define TEXT_HEIGHT 8     // Height of text to be printed and scrolled
-#define TEXT_WIDTH 6      // Width of text to be printed and scrolled
-
-#define LINE_HEIGHT 9     // TEXT_HEIGHT + 1
-#define COL_WIDTH 8       // TEXT_WIDTH + 2
-
-#define MAX_CHR 35        // characters per line (tft.height() / LINE_HEIGHT);
-#define MAX_COL 54        // maximum number of columns (tft.width() / COL_WIDTH);
-#define MAX_COL_DOT6 32   // MAX_COL * 0.6
-
-int col_pos[MAX_COL];
-int chr_map[MAX_COL][MAX_CHR];
-byte color_map[MAX_COL][MAX_CHR];
-uint16_t yPos = 0;
-int rnd_x;
-int rnd_col_pos;
-int color;
-//
-
-// Animation
-static int sunX = 100;      // Sun x y
-static int sunY = 105;
-static int gridX = 260;
-static int gridY = 105;
-static int waterX = 105;
-static int waterY = 170;
-static int width = 83;    // Width of drawing space minus width of arrow 
-static int step = 1;       // How far to move the triangle each iteration
-//
-
-// freeRTOS
+// Boot splash logo, pushed in strips by DMA from two alternating buffers
+#define LOGO_X 75
+#define LOGO_Y 75
+#define LOGO_WIDTH 320
+#define LOGO_HEIGHT 170
+#define LOGO_STRIP_ROWS 10
+uint16_t *logoBuffers[2] = {NULL, NULL};
+int logoRow = 0;                    // Next row of the logo to push
+bool logoDMA = false;               // false if DMA isn't available and the logo was pushed in one go
+
+// Boot profile, a timestamp at the end of each boot stage
+#define BOOT_STAGES_MAX 16
+typedef struct {
+    const char *name;
+    int64_t time;                   // esp_timer_get_time() at the end of the stage
+} bootStage_t;
+bootStage_t bootStages[BOOT_STAGES_MAX];
+uint8_t bootStageCount = 0;
 //
 
 // Touchscreen related
 uint16_t t_x = 0, t_y = 0;      // touch screen coordinates
+TouchGestureEngine touchGestures;   // Filters the raw samples and recognises gestures
 int xw = tft.width()/2;         // xw, yh are middle of the screen
 int yh = tft.height()/2;
-bool pressed = false;
 //
 
-// Clog init
-const uint16_t maxEntries = 7;
-const uint16_t maxEntryChars = 44;
-CLOG_NEW myLog1(maxEntries, maxEntryChars, NO_TRIGGER, WRAP);
-//
 
 // Function defenitions
-static void initialiseScreen(void);
-static void drawButtons(void);
-static void showMessage(String msg, int x, int y, int textSize, int font);
-static void updateLog(const char *msg);
-static void drawHouse(int x, int y);
-static void drawPylon(int x, int y);
-static void drawSun(int x, int y);
-static void drawWaterTank(int x, int y);
-static void matrix(void);
+static void logoBegin(void);
+static bool logoPushStrip(void);
+static void logoEnd(void);
+static void bootStage(const char *name);
+static void printBootProfile(void);
 
 // Removed freeRTOS tasks to simple loop
-static void animation(void);
-static void matrix(void);
-static void touch(void);
-static void startScreenSaver(void);
+static void touch(const touchSample_t *sample);
+static void switchPage(uint8_t page);
+static void wakeBy(TickType_t *wait, uint32_t deadline, uint32_t now);
+static void IRAM_ATTR touchIrq(void);
+static bool readTouch(touchSample_t *sample);
+static bool readTouchRaw(uint16_t *x, uint16_t *y, uint16_t threshold);
+static void setupTouchCalibration(void);
+static void touchQueued(void);
+static uint32_t touchTime(void);
+static void displayBusBegin(void);
+static void displayBusEnd(void);
+static void telemetryQueued(void);
+static void drawQueued(void);
+static void displayBusTake(bool *held);
+static void drawCommands(bool *held);
+static void demoSenderTask(void *parameter);
+static void energyTask(void *parameter);
+
+// Touch controller as seen by the touch reader task
+const touchSource_t tftTouchSource = {readTouch, touchQueued, touchTime};
+
+// The display and touch controller share the SPI bus. The display holds it for a whole
+// frame, touch reads (~200us) are fitted into the gaps between frames.
+const spiClientConfig_t spiClients[SPI_CLIENT_COUNT] = {
+    {"display", displayBusBegin, displayBusEnd, 0},
+    {"touch", NULL, NULL, 200}
+};
 
 static uint32_t inactiveRunTime = -99999;  // inactivity run time timer
 
-bool solarGeneration = true;
-bool gridImport = true;
-bool gridExport = false;
-bool waterHeating = true;
-
-
-bool screenSaverActive = false;     // Is the screen saver active or not
-
 
 void setup(void) {
     BaseType_t xReturned;
 
+    displayEvents = xEventGroupCreate();
+    drawQueueBegin(drawQueued);
+    spiBusBegin(spiClients);
 
-    xReturned = xTaskCreate(displayTask, "displayTask", 3072, NULL, tskIDLE_PRIORITY, &displayTaskHandle);
+    xReturned = xTaskCreatePinnedToCore(displayTask, "displayTask", DISPLAY_TASK_STACK, NULL, DISPLAY_TASK_PRIORITY,
+        &displayTaskHandle, DISPLAY_TASK_CORE);
     if (xReturned != pdPASS) {
         Serial.println("Failed to create displayTask, setup failed");
     } else {
@@ -204,7 +269,25 @@ void setup(void) {
 }
 
 void loop(void) {
-    // See task
+    // Everything is done by the tasks, just watch Serial for a stats or memory request or
+    // a page, 1 to 4
+    while (Serial.available()) {
+        int c = Serial.read();
+        if (c >= '1' && c < '1' + PAGE_COUNT) {
+            drawCommand_t command = {DRAW_PAGE, 0, c - '1', ""};
+            drawQueuePost(&command);
+        }
+
+        switch (c) {
+            case 's':
+                displayNotify(DISPLAY_EVENT_STATS);
+                break;
+            case 'm':
+                memTelemetryDump(Serial);
+                break;
+        }
+    }
+    delay(100);
 }
 
 /**
@@ -213,11 +296,25 @@ void loop(void) {
  */
 void displayTask(void *parameter) {
     uint32_t animationRunTime = -99999;  // time for next update
-    uint8_t updateAnimation = 50;        // update every 40ms
+    uint8_t updateAnimation = FRAME_PERIOD;     // update every 50ms
     uint32_t matrixRunTime = -99999;  // time for next update
     uint8_t updateMatrix = 200;        // update matrix screen saver every 150ms
+    uint32_t shiftRunTime = 0;          // time of the last pixel shift
     uint32_t inactive = 1000 * 60 * 2;  // inactivity of 15 minutes then start screen saver
-    uint8_t counter = 0;
+    uint32_t chartRunTime = 0;          // time of the last power chart sample
+    touchSample_t sample;
+    uint32_t statsRunTime = 0;          // time of the last stats report
+    uint32_t wakeups = 0;               // display task wakeups since the last report
+    int64_t busyTime = 0;               // microseconds spent working since the last report
+    uint32_t smoothTime;                // µs to draw the live values with each font, at boot
+    uint32_t builtInTime;
+    int64_t wakeTime;
+    TickType_t wait;
+    EventBits_t events = 0;
+    bool spritesReady = false;
+    bool fontsReady = false;
+    bool pagesReady = false;
+    telemetry_t values;
 
     // Set all chip selects high to astatic void bus contention during initialisation of each peripheral
     digitalWrite(TOUCH_CS, HIGH);   // ********** TFT_eSPI touch **********
@@ -225,12 +322,16 @@ void displayTask(void *parameter) {
     // digitalWrite(SD_CS, HIGH);   // ********** SD card **********
 
     randomSeed(analogRead(A0));
+    matrixSeed(esp_random());       // hardware RNG, the matrix is different every time
 
-    Serial.begin(115200);
-    delay (2000);
+    // Boot in stages without sleeping, the logo is pushed by DMA while the sprites and
+    // fonts are set up, see bootStage() for the profile printed at the end
+    bootStage(NULL);
 
+    Serial.begin(115200);
     Serial.println("");
     Serial.println("Hello ESP32-WROOM-32D and SPI LCD TFT Display");
+    bootStage("serial");
 
     tft.init();
     tft.invertDisplay(false); // Required for my LCD TFT screen for color correction
@@ -238,39 +339,51 @@ void displayTask(void *parameter) {
     tft.setRotation(3);
     tft.setSwapBytes(true); // Color bytes are swapped when writing to RAM, this introduces a small overhead but
                             // there is a net performance gain by using swapped bytes.
-
-    tft.pushImage(75, 75, 320, 170, (uint16_t *)img_logo);
-
-    delay(1000);
+#ifdef SPI_PROFILER
+    spiProfilerBegin(&tft);
+#endif
+    bootStage("panel");
+
+#ifdef TOUCH_SEPARATE_SPI
+    touchController.begin();
+#endif
+    setupTouchCalibration();
+    bootStage("calibration");
+
+    // Logo strips go out by DMA while the CPU gets on with the sprites, fonts and pages
+    logoBegin();
+    while (logoPushStrip()) {
+        if (!spritesReady) {
+            createSprites();
+            spritesReady = true;
+            bootStage("sprites");
+        } else if (!fontsReady) {
+            smoothFonts = loadSmoothFonts();
+            fontsReady = true;
+            bootStage("fonts");
+        } else if (!pagesReady) {
+            createPages();
+            pagesReady = true;
+            bootStage("pages");
+        }
+    }
+    if (!spritesReady) {
+        createSprites();
+        bootStage("sprites");
+    }
+    if (!fontsReady) {
+        smoothFonts = loadSmoothFonts();
+        bootStage("fonts");
+    }
+    if (!pagesReady) {
+        createPages();
+        bootStage("pages");
+    }
+    logoEnd();
+    bootStage("logo");
 
     tft.setTextSize(2);
 
-    Serial.println("Initialisation complete");
-
-    // Create the Sprites
-    logSprite.createSprite(270, 75);
-    logSprite.fillSprite(TFT_BACKGROUND);
-
-    // Sprites for animations
-    lineSprite.createSprite(95, 1);
-    rightArrowSprite.createSprite(12, 21);
-    leftArrowSprite.createSprite(12, 21);
-    fillFrameSprite.createSprite(12, 21);
-    lineSprite.fillSprite(TFT_BACKGROUND);
-    rightArrowSprite.fillSprite(TFT_BACKGROUND);
-    leftArrowSprite.fillSprite(TFT_BACKGROUND);
-    fillFrameSprite.fillSprite(TFT_BACKGROUND);
-
-    lineSprite.drawLine(0, 0, 95, 0, TFT_LIGHTGREY);
-
-    rightArrowSprite.fillTriangle(11, 10, 1, 0, 1, 20, TFT_GREEN_ENERGY);  // > small right pointing sideways triangle
-    rightArrowSprite.drawPixel(0, 10, TFT_LIGHTGREY);    
-
-    leftArrowSprite.fillTriangle(0, 10, 10, 0, 10, 20, TFT_RED);  // < small left pointing sideways triangle
-    leftArrowSprite.drawPixel(11, 10, TFT_LIGHTGREY);    
-
-    fillFrameSprite.drawLine(0, 10, 11, 10, TFT_LIGHTGREY);
-
     // // vertical lines on screen to help with graphic placement
     // for (int i = 10; i < 480; i += 10) {
     //     tft.drawLine(i, 0, i, 320, TFT_BLUE);
@@ -281,559 +394,727 @@ void displayTask(void *parameter) {
     // }
 
     initialiseScreen(); 
+    bootStage("scene");
+
+    timeValues(&smoothTime, &builtInTime);
+    bootStage("value timing");
 
     updateLog("Sender Battery OK"); // 43 chars max
-    
-    delay(1000);
     updateLog("Heating OFF");
-
-    delay(1000);
     updateLog("Water Tank: HOT");
-
+    bootStage("log");
 
     inactiveRunTime = millis();     // start inactivity timer for turning on the screen saver
+    statsRunTime = millis();
+    chartRunTime = millis();
+
+    if (!touchInputBegin(&tftTouchSource, TOUCH_IRQ >= 0)) {
+        Serial.println("Failed to start touch input");
+    } else if (TOUCH_IRQ >= 0) {
+        pinMode(TOUCH_IRQ, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), touchIrq, FALLING);
+    }
+    bootStage("touch");
+
+    if (!memTelemetryBegin(MEM_TELEMETRY_PERIOD, MEM_BLOCK_WARNING))
+        Serial.println("Failed to start memory telemetry");
+    if (!taskStatsBegin())
+        Serial.println("Failed to start the core load hooks");
+
+    telemetryBegin(telemetryQueued);
+    if (xTaskCreatePinnedToCore(energyTask, "energy", ENERGY_TASK_STACK, NULL, ENERGY_TASK_PRIORITY, NULL,
+            ENERGY_TASK_CORE) != pdPASS)
+        Serial.println("Failed to start the energy meter");
+    if (TELEMETRY_DEMO && xTaskCreatePinnedToCore(demoSenderTask, "demoSender", DEMO_TASK_STACK, NULL, SENDER_TASK_PRIORITY,
+            NULL, SENDER_TASK_CORE) != pdPASS)
+        Serial.println("Failed to start the demo sender");
+    bootStage("telemetry");
+
+    Serial.println("Initialisation complete");
+    printBootProfile();
+    if (smoothTime > 0)
+        Serial.printf("Live values: %u us with the smooth fonts, %u us with the built-in fonts, %s\n",
+            (unsigned)smoothTime, (unsigned)builtInTime, smoothTime <= FRAME_PERIOD * 1000 ?
+            "within the frame" : "OVER the frame");
+    else
+        Serial.printf("Live values: %u us with the built-in fonts, no smooth fonts\n", (unsigned)builtInTime);
+
+#ifdef TOUCH_LATENCY_BENCH
+    touchLatencyBenchmark();
+    initialiseScreen();
+#endif
+
+#ifdef TASK_JITTER_BENCH
+    frameJitterBenchmark();
+#endif
 
     for ( ;; ) {
+        uint32_t now = millis();
+        uint32_t changed;
+        bool held = false;                  // bus only taken once something needs drawing
+
+        wakeTime = esp_timer_get_time();
+        wakeups++;
+        wait = portMAX_DELAY;               // nothing to do until an event arrives
+
+        if (events & DISPLAY_EVENT_STATS)
+            taskStatsReport(Serial);
+
+        while (touchInputRead(&sample)) {   // queued by the touch reader task
+            displayBusTake(&held);
+            touch(&sample);
+        }
+
+        drawCommands(&held);                // posted by the other tasks
+
+        changed = telemetryTake(&values);   // latest readings, one snapshot a frame
+        if (changed != 0) {
+            displayBusTake(&held);
+            showTelemetry(&values, changed);
+        }
+
+        if (now - chartRunTime >= CHART_SAMPLE_PERIOD) {   // kept up to date under the screen saver too
+            chartRunTime = now;
+            displayBusTake(&held);
+            chartSample();
+        }
+        wakeBy(&wait, chartRunTime + CHART_SAMPLE_PERIOD, now);
+
         if (screenSaverActive) {
-            if (millis() - matrixRunTime >= updateMatrix) {  // time has elapsed, update display
-                matrixRunTime = millis();
+            if (now - matrixRunTime >= updateMatrix) {  // time has elapsed, update display
+                matrixRunTime = now;
+                displayBusTake(&held);
                 matrix();
             }
+            wakeBy(&wait, matrixRunTime + updateMatrix, now);
         } else {
-            if (millis() - animationRunTime >= updateAnimation) {  // time has elapsed, update display
-                animationRunTime = millis();
-                animation();
+            if (animationActive()) {
+                if (now - animationRunTime >= updateAnimation) {  // time has elapsed, update display
+                    animationRunTime = now;
+                    if (animationStep()) {  // an arrow reached another pixel
+                        displayBusTake(&held);
+                        animationDraw();
+                    }
+                }
+                wakeBy(&wait, animationRunTime + updateAnimation, now);
             }
 
-            if (millis() >= inactiveRunTime + inactive) {       // We've been inactive for 'n' minutes, start screensaver
-                updateLog("No activity, start screen saver");
-                startScreenSaver();
+            if (pixelShifting()) {
+                if (now - shiftRunTime >= PIXEL_SHIFT_PERIOD) {
+                    shiftRunTime = now;
+                    displayBusTake(&held);
+                    pixelShift();
+                }
+                wakeBy(&wait, shiftRunTime + PIXEL_SHIFT_PERIOD, now);
+            } else if (now - inactiveRunTime >= inactive) {       // We've been inactive for 'n' minutes, start screensaver
+                displayBusTake(&held);
+                if (SCREEN_SAVER_PIXEL_SHIFT) {
+                    updateLog("No activity, start pixel shift");
+                    startPixelShift();
+                    shiftRunTime = now;
+                } else {
+                    updateLog("No activity, start screen saver");
+                    startScreenSaver();
+                }
+                wait = 0;
+            } else {
+                wakeBy(&wait, inactiveRunTime + inactive, now);
             }
         }
 
-        touch();    // has the touch screen been pressed, check each loop or can we add a wait time?
-
-        vTaskDelay(30 / portTICK_PERIOD_MS);
-        counter++;
-        if (counter > 100) {
-            counter = 0;
-            Serial.print("Display Task Stack Left: ");
-            Serial.println(uxTaskGetStackHighWaterMark(NULL));
+        SPI_PROFILE_FRAME();
+
+        // Let the touch reader know when we next want the bus
+        spiBusReserve(SPI_CLIENT_DISPLAY, wait == portMAX_DELAY ? 0 : esp_timer_get_time() + (int64_t)wait * portTICK_PERIOD_MS * 1000);
+        if (held)
+            spiBusRelease(SPI_CLIENT_DISPLAY);
+
+        busyTime += esp_timer_get_time() - wakeTime;
+
+        // Wakeups and CPU use since the last report, on request so an idle screen stays idle
+        if ((events & DISPLAY_EVENT_STATS) || (DISPLAY_STATS && now - statsRunTime >= DISPLAY_STATS_PERIOD)) {
+            uint32_t elapsed = max(now - statsRunTime, (uint32_t)1);
+            Serial.printf("Display task: %u.%u wakeups/s, CPU %u.%02u%%, stack left %u\n",
+                (unsigned)(wakeups * 1000 / elapsed), (unsigned)(wakeups * 10000 / elapsed) % 10,
+                (unsigned)(busyTime / (elapsed * 10)), (unsigned)(busyTime * 100 / (elapsed * 10)) % 100,
+                (unsigned)uxTaskGetStackHighWaterMark(NULL));
+            spiBusReport(Serial);
+            telemetryReport(Serial);
+            drawQueueReport(Serial);
+#ifdef SPI_PROFILER
+            spiProfileReport(Serial, false);
+            spiProfileReset();
+#endif
+            statsRunTime = now;
+            wakeups = 0;
+            busyTime = 0;
         }
+        if (DISPLAY_STATS)
+            wakeBy(&wait, statsRunTime + DISPLAY_STATS_PERIOD, now);
+
+        events = xEventGroupWaitBits(displayEvents, DISPLAY_EVENT_ALL, pdTRUE, pdFALSE, wait);
     }
     vTaskDelete(NULL);
 }
 
-
-
 /**
- * @brief Animation of arrows to show the flow of electricity. Solar generation, water tank
- * heating, grid import or export.
+ * @brief Wake the display task, safe to call from any task. Use DISPLAY_EVENT_DATA when
+ * new values are available to show.
  * 
+ * @param events DISPLAY_EVENT_xxx bits
  */
-static void animation(void) {
-    static int sunStartPosition = sunX;       // 
-    static int gridImportStartPosition = gridX;     //
-    static int gridExportStartPosition = gridX;     //
-    static int waterStartPosition = waterX;     //
-    static int sunArrow = sunStartPosition + 40;                // solar generation arrow start point 
-    static int gridImportArrow = gridImportStartPosition + width;      // grid import arrow start point
-    static int gridExportArrow = gridExportStartPosition;      // grid export arrow start point
-    static int waterArrow = waterStartPosition + 15;            // water heating arrow start point - move so it's not the same position as sum
-
-    // Solar generation arrow
-    if (solarGeneration) {
-        rightArrowSprite.pushSprite(sunArrow, sunY);
-        sunArrow += step;
-        if (sunArrow > (width + sunStartPosition)) {
-            fillFrameSprite.pushSprite(sunArrow-step, sunY);
-            sunArrow = sunStartPosition;
-        } 
-    }
-
-    // Grid import arrow
-    if (gridImport) {
-        leftArrowSprite.pushSprite(gridImportArrow, gridY);
-        gridImportArrow -= step;
-        if (gridImportArrow < gridImportStartPosition) {
-            fillFrameSprite.pushSprite(gridImportArrow+step, gridY);
-            gridImportArrow = gridImportStartPosition + width;
-        } 
-    }
+void displayNotify(EventBits_t events) {
+    if (displayEvents != NULL)
+        xEventGroupSetBits(displayEvents, events);
+}
 
-    // Grid export arrow
-    if (gridExport) {
-        rightArrowSprite.pushSprite(gridExportArrow, gridY);
-        gridExportArrow += step;
-        if (gridExportArrow > gridExportStartPosition + width) {
-            fillFrameSprite.pushSprite(gridExportArrow-step, gridY);
-            gridExportArrow = gridExportStartPosition;
-        } 
-    }
+/**
+ * @brief T_IRQ falling edge, the touch screen has been pressed. Wakes the touch reader task.
+ * 
+ */
+static void IRAM_ATTR touchIrq(void) {
+    touchInputIrqFromISR();
+}
 
-    // Water tank heating by solar arrow
-    if (waterHeating) {
-        rightArrowSprite.pushSprite(waterArrow, waterY);
-        waterArrow += step;
-        if (waterArrow > waterStartPosition + width) {
-            fillFrameSprite.pushSprite(waterArrow-step, waterY);
-            waterArrow = waterStartPosition;
-        } 
-    }
+/**
+ * @brief Read the touch controller for the touch reader task, waits for the display task
+ * to finish with the SPI bus. A single raw sample is taken, filtering is done later by
+ * the gesture engine rather than TFT_eSPI's repeated reads.
+ * 
+ * @param sample Filled in with the screen coordinates
+ * @return true The screen is being touched
+ */
+static bool readTouch(touchSample_t *sample) {
+    bool touched;
+#ifdef TOUCH_LATENCY_BENCH
+    int64_t start = esp_timer_get_time();
+#endif
+
+#ifdef TOUCH_SEPARATE_SPI
+    touched = readTouchRaw(&sample->x, &sample->y, TOUCH_Z_THRESHOLD);
+#else
+    spiBusAcquire(SPI_CLIENT_TOUCH);
+    touched = readTouchRaw(&sample->x, &sample->y, TOUCH_Z_THRESHOLD);
+    spiBusRelease(SPI_CLIENT_TOUCH);
+#endif
+    sample->time = millis();
+
+#ifdef TOUCH_LATENCY_BENCH
+    int64_t latency = esp_timer_get_time() - start;
+    benchTouchReads++;
+    benchTouchTime += latency;
+    if (latency > benchTouchMax)
+        benchTouchMax = latency;
+#endif
+
+    if (!touched)
+        return false;
+
+    tft.convertRawXY(&sample->x, &sample->y);
+    return sample->x < tft.width() && sample->y < tft.height();
 }
 
 /**
- * @brief Touch screen has been touched!
+ * @brief Read the raw touch position from whichever bus the touch controller is on. The
+ * caller must hold the SPI bus if it's shared.
  * 
+ * @param x Raw x
+ * @param y Raw y
+ * @param threshold Minimum pressure to count as a touch
+ * @return true Touched, x and y are valid
  */
-static void touch(void) {
-    if (tft.getTouch(&t_x, &t_y))
-        pressed = true;
+static bool readTouchRaw(uint16_t *x, uint16_t *y, uint16_t threshold) {
+#ifdef TOUCH_SEPARATE_SPI
+    if (touchController.readZ() < threshold)
+        return false;
+    touchController.readXY(x, y);
+#else
+    if (tft.getTouchRawZ() < threshold)
+        return false;
+    tft.getTouchRaw(x, y);
+#endif
+    return true;
+}
 
-    if (pressed) {
-        pressed = false;
-        key[2].press(true);
-    }
+/**
+ * @brief Load the touch calibration, from NVS or baked into the firmware, and only if
+ * there is none (or REPEAT_CAL) ask the user to calibrate. Called at boot before the touch
+ * reader task starts, so the bus isn't shared yet.
+ * 
+ */
+static void setupTouchCalibration(void) {
+    uint16_t calData[TOUCH_CAL_VALUES];
 
-    if (key[2].justReleased()) {
-        key[2].press(false);
-        if (!screenSaverActive) {
-            updateLog("Screen saver started by user");
-            startScreenSaver();
-        } else if (screenSaverActive) {
-            Serial.println("Stop screen saver");
-            screenSaverActive = false;
-            inactiveRunTime = millis();     // reset inactivity timer to now
-            initialiseScreen();
-            updateLog("Screen saver stopped by user");
+    if (!REPEAT_CAL) {
+        if (touchCalLoad(calData)) {
+            tft.setTouch(calData);
+            return;
+        }
+        if (touchCalBaked(calData)) {
+            Serial.println("Using baked in touch calibration");
+            tft.setTouch(calData);
+            return;
         }
     }
 
-    if (key[2].justPressed()) {
-        key[2].press(false);
-        vTaskDelay(10 / portTICK_PERIOD_MS); // debounce
-    }
+    tft.fillScreen(TFT_BLACK);
+    tft.setCursor(20, 0);
+    tft.setTextFont(2);
+    tft.setTextSize(1);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.println("Touch corners as indicated");
+
+    touchCalRun(&tft, readTouchRaw, TOUCH_Z_THRESHOLD, calData);
+    tft.setTouch(calData);
+
+    Serial.printf("Touch calibration: %u,%u,%u,%u,%u\n", calData[0], calData[1], calData[2], calData[3], calData[4]);
+    if (!touchCalSave(calData))
+        Serial.println("Failed to save touch calibration");
+
+    tft.fillScreen(TFT_BLACK);
 }
 
 /**
- * @brief Matrix style screen saver.
+ * @brief Touch samples have been queued, wake the display task to handle them.
  * 
  */
-static void matrix(void) {
-
-    for (int j = 0; j < MAX_COL; j++) {
-        rnd_col_pos = random(1, MAX_COL);
+static void touchQueued(void) {
+    displayNotify(DISPLAY_EVENT_TOUCH);
+}
 
-        rnd_x = rnd_col_pos * COL_WIDTH;
+static uint32_t touchTime(void) {
+    return millis();
+}
 
-        col_pos[rnd_col_pos - 1] = rnd_x; // save position
+/**
+ * @brief New telemetry has been published, wake the display task to show it.
+ * 
+ */
+static void telemetryQueued(void) {
+    displayNotify(DISPLAY_EVENT_DATA);
+}
 
-        for (int i = 0; i < MAX_CHR; i++) { // 40
-            tft.setTextColor(color_map[rnd_col_pos][i] << 5, TFT_BLACK); // Set the green character brightness
+/**
+ * @brief A draw command has been posted, wake the display task to carry it out.
+ * 
+ */
+static void drawQueued(void) {
+    displayNotify(DISPLAY_EVENT_DRAW);
+}
 
-            if (color_map[rnd_col_pos][i] == 63) {
-                tft.setTextColor(TFT_DARKGREY, TFT_BLACK); // Draw different colour character
-            }
+/**
+ * @brief Take the SPI bus for the display task the first time a tick needs to draw, so a
+ * tick with nothing to draw leaves the bus to the touch reader.
+ * 
+ * @param held Bus already taken this tick, set once taken
+ */
+static void displayBusTake(bool *held) {
+    if (*held)
+        return;
 
-            if ((chr_map[rnd_col_pos][i] == 0) || (color_map[rnd_col_pos][i] == 63)) {
-                chr_map[rnd_col_pos][i] = random(31, 128);
+    spiBusAcquire(SPI_CLIENT_DISPLAY);
+    *held = true;
+}
 
-                if (i > 1) {
-                    chr_map[rnd_col_pos][i - 1] = chr_map[rnd_col_pos][i];
-                    chr_map[rnd_col_pos][i - 2] = chr_map[rnd_col_pos][i];
-                }
+/**
+ * @brief Carry out the draw commands posted by the other tasks, in the order they were
+ * posted, a batch at a time.
+ * 
+ * @param held Bus already taken this tick, taken here if there are any commands
+ */
+static void drawCommands(bool *held) {
+    drawCommand_t batch[DISPLAY_DRAW_BATCH];
+    uint32_t count;
+
+    do {
+        count = drawQueueTake(batch, DISPLAY_DRAW_BATCH);
+        if (count > 0)
+            displayBusTake(held);
+        for (uint32_t i = 0; i < count; i++) {
+            switch (batch[i].type) {
+                case DRAW_LOG:
+                    updateLog(batch[i].text);
+                    break;
+                case DRAW_PAGE:
+                    if (!screenSaverActive)
+                        switchPage(batch[i].value);
+                    break;
             }
-
-            yPos += LINE_HEIGHT;
-
-            tft.drawChar(chr_map[rnd_col_pos][i], rnd_x, yPos, 1); // Draw the character
-
         }
+    } while (count == DISPLAY_DRAW_BATCH);
+}
 
-        yPos = 0;
-
-        for (int n = 0; n < MAX_CHR-1; n++) {   // added -1 so we don't get undefinded behaviour from next line
-            chr_map[rnd_col_pos][n] = chr_map[rnd_col_pos][n + 1];   // compiler doesn't like this line
-        }
-        
-        for (int n = MAX_CHR; n > 0; n--) {
-            color_map[rnd_col_pos][n] = color_map[rnd_col_pos][n - 1];
-        }
+/**
+ * @brief Stand-in for the radio, publishes a simulated reading every DEMO_SEND_PERIOD.
+ * Solar drifts up and down, surplus over the house load goes to the immersion heater and
+ * anything left is exported. The energy task integrates the readings like real ones.
+ * 
+ */
+static void demoSenderTask(void *parameter) {
+    TickType_t lastWake = xTaskGetTickCount();
+    telemetry_t reading;
+    int32_t solar = 2340;
+    bool heating = false;                   // As logged at boot
 
-        chr_map[rnd_col_pos][0] = 0;
+    for ( ;; ) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DEMO_SEND_PERIOD));
 
-        if (color_map[rnd_col_pos][0] > 20) {
-            color_map[rnd_col_pos][0] -= 3; // Rapid fade initially brightness values
-        }
+        solar = constrain(solar + random(-300, 301), 0, 4000);
+        reading.solarPower = solar;
+        reading.waterPower = constrain(solar - DEMO_HOUSE_LOAD, 0, DEMO_HEATER_POWER);
+        reading.gridPower = DEMO_HOUSE_LOAD + reading.waterPower - solar;
+        reading.lqi = random(15, 40);
+        reading.batteryOk = true;
 
-        if (color_map[rnd_col_pos][0] > 0) {
-            color_map[rnd_col_pos][0] -= 1; // Slow fade later
-        }
+        telemetryPublish(&reading, TELEMETRY_POWER | TELEMETRY_LQI | TELEMETRY_BATTERY);
 
-        if ((random(20) == 1) && (j < MAX_COL_DOT6)) { // MAX_COL * 0.6
-            color_map[rnd_col_pos][0] = 63; // ~1 in 20 probability of a new character
+        if ((reading.waterPower > 0) != heating) {
+            heating = reading.waterPower > 0;
+            drawQueueLog(heating ? "Heating ON" : "Heating OFF");
         }
-    }        
+    }
 }
 
 /**
- * @brief Set up the screen. This will be called at program startup and when the screen
- * saver ends.  This will draw all static elements, i.e. house, sun, pylon, hot water
- * tank, menu buttons etc.
+ * @brief Integrates the latest published power, whichever task published it, into
+ * today's totals every ENERGY_SAMPLE_PERIOD and publishes the totals. The totals are
+ * checkpointed to NVS now and then, to DEMO_ENERGY_NAMESPACE while the demo sender runs
+ * so simulated kWh never reach the real record.
+ * 
  */
-static void initialiseScreen(void) {
-    tft.fillScreen(TFT_BACKGROUND);
-
-    // Define area at top of screen for date, time etc.
-    tft.fillRect(0, 20, 480, 2, TFT_BLACK);
-    tft.fillRect(0, 0, 480, 20, TFT_SKYBLUE);
+static void energyTask(void *parameter) {
+    TickType_t lastWake = xTaskGetTickCount();
+    EnergyMeter energy;
+    telemetry_t reading;
+    int32_t power[ENERGY_CHANNELS];
 
-    // Define message area at the bottom
-    tft.drawLine(0, 245, 480, 245, TFT_FOREGROUND);
-    tft.drawLine(210, 245, 210, 320, TFT_FOREGROUND);
+    energy.begin(energyClock(), TELEMETRY_DEMO ? DEMO_ENERGY_NAMESPACE : ENERGY_NAMESPACE);
 
-    // Right (>) pointing triangle 400 = point x, 50 = point y, 390 = base x, 40 = base y top, 390 = base x, 60 = base y bottom
-    // tft.fillTriangle(400, 50, 390, 40, 390, 60, TFT_BLACK);
-
-    // Left (<) pointing triangle 400 = point x, 80 = point y, 410 = base x, 70 = base y top, 410 = base x, 80 = base y bottom
-    // tft.fillTriangle(400, 80, 410, 70, 410, 90, TFT_BLACK);
-
-    //This passes our buttons and draws them on the screen
-	// drawRoundedSquare(btnA);
-	// drawRoundedSquare(btnB);
-	// drawRoundedSquare(btnC);
+    for ( ;; ) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(ENERGY_SAMPLE_PERIOD));
+
+        telemetryRead(&reading);
+        int64_t now = energyClock();
+        power[ENERGY_SOLAR] = reading.solarPower;
+        power[ENERGY_WATER] = reading.waterPower;
+        power[ENERGY_IMPORT] = max(reading.gridPower, (int32_t)0);
+        power[ENERGY_EXPORT] = max(-reading.gridPower, (int32_t)0);
+        if (energy.addSample(now, power))
+            energy.report(Serial);
+        energy.checkpoint(now);
+
+        if (reading.solarEnergy != energy.todayWh(ENERGY_SOLAR) || reading.waterEnergy != energy.todayWh(ENERGY_WATER)) {
+            reading.solarEnergy = energy.todayWh(ENERGY_SOLAR);
+            reading.waterEnergy = energy.todayWh(ENERGY_WATER);
+            telemetryPublish(&reading, TELEMETRY_ENERGY);
+        }
+    }
+}
 
-    drawSun(65, 145);
-    drawHouse(210, 130);
-    drawPylon(380, 130);
-    drawWaterTank(213, 160);
+/**
+ * @brief The display task has the SPI bus, keep it configured and CS low for everything
+ * drawn until displayBusEnd() rather than per draw call.
+ * 
+ */
+static void displayBusBegin(void) {
+    tft.startWrite();
+}
 
-    lineSprite.pushSprite(sunX, sunY+10);
-    lineSprite.pushSprite(gridX, gridY+10);
-    lineSprite.pushSprite(waterX, waterY+10);
+static void displayBusEnd(void) {
+    tft.endWrite();
+}
 
-    tft.setCursor(75, 3, 1);   // position and font
-    tft.setTextColor(TFT_BLACK, TFT_SKYBLUE);
-    tft.setTextSize(2);
-    tft.print("House Electricity Monitor v3");
+#ifdef TOUCH_LATENCY_BENCH
+/**
+ * @brief Redraw the whole screen back to back while the touch reader task keeps polling,
+ * then print how long the touch reads took.
+ * 
+ */
+static void touchLatencyBenchmark(void) {
+    int64_t start;
 
-    logSprite.pushSprite(211, 246);
+    Serial.println("Touch latency benchmark, don't touch the screen");
+    vTaskDelay(pdMS_TO_TICKS(100));     // let the reader task settle
 
-    showMessage("13:43:23", 5, 250, 1, 2);
-    showMessage("Sun 17 Mar 24", 110, 250, 1, 2);
+    benchTouchReads = 0;
+    benchTouchTime = 0;
+    benchTouchMax = 0;
+    start = esp_timer_get_time();
 
-    showMessage("Water Tank: Heating by solar", 5, 270, 1, 2);
-    showMessage("Sender Battery: OK", 5, 288, 1, 2);
+    for (int i = 0; i < BENCH_REDRAWS; i++) {
+        spiBusAcquire(SPI_CLIENT_DISPLAY);
+        tft.fillScreen(i & 1 ? TFT_BLACK : TFT_BACKGROUND);
+        spiBusRelease(SPI_CLIENT_DISPLAY);
+    }
 
-    showMessage("IP: 192.168.5.67", 5, 310, 0, 1);
-    showMessage("LQI: 23", 160, 310, 0, 1);
+#ifdef TOUCH_SEPARATE_SPI
+    Serial.print("Touch on HSPI, display on VSPI: ");
+#else
+    Serial.print("Touch and display sharing VSPI: ");
+#endif
+    Serial.printf("%d redraws in %u ms, %u touch reads, avg %u us, max %u us\n", BENCH_REDRAWS,
+        (unsigned)((esp_timer_get_time() - start) / 1000), (unsigned)benchTouchReads,
+        (unsigned)(benchTouchReads ? benchTouchTime / benchTouchReads : 0), (unsigned)benchTouchMax);
+    spiBusReport(Serial);
+}
+#endif
 
-    // Demo values
+#ifdef TASK_JITTER_BENCH
+/**
+ * @brief Time the flow animation with no load, then with the network load on the I/O
+ * core and on the display's core.
+ * 
+ */
+static void frameJitterBenchmark(void) {
+    Serial.printf("Frame jitter benchmark, display task on core %d at priority %u\n", xPortGetCoreID(),
+        (unsigned)uxTaskPriorityGet(NULL));
+    frameJitterRun("No load", -1);
+    frameJitterRun("Load on I/O core", IO_CORE);
+    frameJitterRun("Load on render core", RENDER_CORE);
+}
 
-    // Solar generation now
-    tft.setCursor(110, 85, 2);   // position and font
-    tft.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
-    tft.setTextSize(1);
-    tft.print("2.34 kW");
+/**
+ * @brief Draw JITTER_FRAMES animation ticks as the display task does, optionally with
+ * the network load pinned to a core, and print how far the ticks were from the period.
+ * 
+ * @param name Printed with the results
+ * @param core Core for the network load, -1 for none
+ */
+static void frameJitterRun(const char *name, int core) {
+    TaskHandle_t loadHandle = NULL;
+    int64_t last = 0, intervalMax = 0, intervalMin = INT64_MAX, deviation = 0, deviationMax = 0;
+    int64_t drawTime = 0, drawMax = 0;
+    TickType_t lastWake;
+
+    if (core >= 0 && xTaskCreatePinnedToCore(networkLoadTask, "netLoad", 2048, NULL, NET_LOAD_PRIORITY,
+            &loadHandle, core) != pdPASS) {
+        Serial.println("Failed to start the network load");
+        return;
+    }
 
-    // Electricity import/export values
-    tft.setCursor(280, 85, 2);   // position and font
-    tft.print("1.67 kW");
+    lastWake = xTaskGetTickCount();
+    for (int i = 0; i <= JITTER_FRAMES; i++) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(JITTER_PERIOD));
+
+        int64_t start = esp_timer_get_time();
+        spiBusAcquire(SPI_CLIENT_DISPLAY);
+        animation();
+        spiBusRelease(SPI_CLIENT_DISPLAY);
+        int64_t end = esp_timer_get_time();
+
+        if (i > 0) {        // the first tick only sets the start
+            int64_t interval = start - last;
+            int64_t off = abs(interval - JITTER_PERIOD * 1000LL);
+            intervalMin = min(intervalMin, interval);
+            intervalMax = max(intervalMax, interval);
+            deviation += off;
+            deviationMax = max(deviationMax, off);
+            drawTime += end - start;
+            drawMax = max(drawMax, end - start);
+        }
+        last = start;
+    }
 
-    // Total solar generated today
-    tft.setCursor(100, 45, 4);   // position and font
-    tft.setTextSize(1);
-    tft.print("12.67 kWh");
+    if (loadHandle != NULL)
+        vTaskDelete(loadHandle);
 
-    // Water import to heat water
-    tft.setCursor(110, 150, 2);   // position and font
-    tft.setTextSize(1);
-    tft.print("0.89 kW");
+    Serial.printf("%s: %d frames, interval %u-%u us, jitter avg %u us max %u us, draw avg %u us max %u us\n", name,
+        JITTER_FRAMES, (unsigned)intervalMin, (unsigned)intervalMax, (unsigned)(deviation / JITTER_FRAMES),
+        (unsigned)deviationMax, (unsigned)(drawTime / JITTER_FRAMES), (unsigned)drawMax);
+}
 
-    // Total saved today to heat water
-    tft.setCursor(110, 205, 1);   // position and font
-    tft.setTextSize(2);
-    tft.print("2.57 kWh");
+/**
+ * @brief Stand-in for WiFi traffic, NET_LOAD_BURST of busy CPU every NET_LOAD_PERIOD at
+ * WiFi's priority.
+ * 
+ */
+static void networkLoadTask(void *parameter) {
+    TickType_t lastWake = xTaskGetTickCount();
 
+    for ( ;; ) {
+        int64_t until = esp_timer_get_time() + NET_LOAD_BURST;
+        while (esp_timer_get_time() < until)
+            ;
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(NET_LOAD_PERIOD));
+    }
 }
+#endif
 
 /**
- * @brief Start/setup the screen saver.  Will be started by the user touching the screen
- * or after 'n' minutes of inactivity to save the screen from burn-in.
+ * @brief Bring the display task's wait time forward so it wakes by deadline.
+ * 
+ * @param wait Ticks to wait, updated if deadline is sooner
+ * @param deadline millis() time the task needs to wake up by
+ * @param now Current millis() time
  */
-static void startScreenSaver(void) {
-    screenSaverActive = true;
-            
-    tft.fillScreen(TFT_BLACK);
+static void wakeBy(TickType_t *wait, uint32_t deadline, uint32_t now) {
+    int32_t remaining = (int32_t)(deadline - now);
+    TickType_t ticks = remaining <= 0 ? 0 : pdMS_TO_TICKS(remaining);
+
+    if (ticks < *wait)
+        *wait = ticks;
+}
 
-    for (int j = 0; j < MAX_COL; j++) {
-        for (int i = 0; i < MAX_CHR; i++) {
-        chr_map[j][i] = 0;
-        color_map[j][i] = 0;
-        }
 
-        color_map[j][0] = 63;
+/**
+ * @brief Get ready to push the logo by DMA. If DMA or its buffers aren't available the
+ * logo is pushed straight away the old way.
+ * 
+ */
+static void logoBegin(void) {
+    size_t stripSize = LOGO_WIDTH * LOGO_STRIP_ROWS * sizeof(uint16_t);
+
+    logoRow = 0;
+    logoBuffers[0] = (uint16_t *)heap_caps_malloc(stripSize, MALLOC_CAP_DMA);
+    logoBuffers[1] = (uint16_t *)heap_caps_malloc(stripSize, MALLOC_CAP_DMA);
+    logoDMA = logoBuffers[0] != NULL && logoBuffers[1] != NULL && tft.initDMA();
+
+    if (!logoDMA) {
+        tft.pushImage(LOGO_X, LOGO_Y, LOGO_WIDTH, LOGO_HEIGHT, (uint16_t *)img_logo);
+        logoRow = LOGO_HEIGHT;
+        return;
     }
+
+    tft.startWrite();
 }
 
 /**
- * @brief Show a message on the screen, mainly used for time, date and mainly fixed
- * information that does not change a lot (except the time obviously!).
+ * @brief Queue the next strip of the logo. The strip is copied from flash into the buffer
+ * not used by the transfer in progress, so this only waits if the previous strip hasn't
+ * finished by the time this one is ready.
  * 
- * @param msg String to write to the display
- * @param x Pixel location horizontal
- * @param y Pixel location vertical
- * @param textSize Text size to use
- * @param font Default font to use, 1, 2 etc.
+ * @return true More strips to push
  */
-static void showMessage(String msg, int x, int y, int textSize, int font) {
-    tft.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
-    tft.setCursor(x, y, font);   // position and font
-    tft.setTextSize(textSize);
-    tft.print(msg);
+static bool logoPushStrip(void) {
+    int rows = min(LOGO_STRIP_ROWS, LOGO_HEIGHT - logoRow);
+
+    if (rows <= 0)
+        return false;
+
+    tft.pushImageDMA(LOGO_X, LOGO_Y + logoRow, LOGO_WIDTH, rows, (uint16_t *)img_logo + logoRow * LOGO_WIDTH,
+        logoBuffers[(logoRow / LOGO_STRIP_ROWS) & 1]);
+    logoRow += rows;
+
+    return logoRow < LOGO_HEIGHT;
 }
 
 /**
- * @brief Write cLog logging to the log screen area.
+ * @brief Wait for the last logo strip to go and free the buffers.
  * 
  */
-static void updateLog(const char *msg) {
-    int y = 3; // top of log area
-
-    // Add time to message then add to CLOG
-    CLOG(myLog1.add(), "18:12:32 %s", msg);
-
-    logSprite.fillSprite(TFT_BACKGROUND);
-    logSprite.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
-    logSprite.setTextFont(0);
-    for (uint8_t i = 0; i < myLog1.numEntries; i++, y+=10) {
-        logSprite.setCursor(5, y);
-        logSprite.print(myLog1.get(i));
+static void logoEnd(void) {
+    if (logoDMA) {
+        tft.dmaWait();
+        tft.endWrite();
+        tft.deInitDMA();
     }
 
-    logSprite.pushSprite(211, 246);
+    free(logoBuffers[0]);
+    free(logoBuffers[1]);
+    logoBuffers[0] = logoBuffers[1] = NULL;
 }
 
-
 /**
- * @brief Draw a house where xy is the bottom left of the house
+ * @brief Record the end of a boot stage for the boot profile.
  * 
- * @param x Bottom left x of house
- * @param y Bottom left y of house
+ * @param name Stage that has just finished, NULL to start the profile
  */
-static void drawHouse(int x, int y) {
-    tft.drawLine(x, y, x+36, y, TFT_FOREGROUND);      // Bottom
-    tft.drawLine(x, y, x, y-30, TFT_FOREGROUND);      // Left wall
-    tft.drawLine(x+36, y, x+36, y-30, TFT_FOREGROUND);      // Right wall
-    tft.drawLine(x-2, y-28, x+18, y-45, TFT_FOREGROUND);      // Left angled roof
-    tft.drawLine(x+38, y-28, x+18, y-45, TFT_FOREGROUND);      // Right angled roof
-
-    tft.drawRect(x+5, y-28, 8, 8, TFT_FOREGROUND);   // Left top window
-    tft.drawRect(x+23, y-28, 8, 8, TFT_FOREGROUND);   // Right top window
-   
-    tft.drawRect(x+15, y-13, 8, 13, TFT_FOREGROUND);   // Door
+static void bootStage(const char *name) {
+    if (name == NULL)
+        bootStageCount = 0;
+    if (bootStageCount < BOOT_STAGES_MAX) {
+        bootStages[bootStageCount].name = name == NULL ? "start" : name;
+        bootStages[bootStageCount].time = esp_timer_get_time();
+        bootStageCount++;
+    }
 }
 
 /**
- * @brief Draw an electricity pylon
+ * @brief Print how long each boot stage took and when it finished.
  * 
- * @param x Bottom left x position of pylon
- * @param y Bottom left y position of pylon
  */
-static void drawPylon(int x, int y) {
-    tft.drawLine(x, y, x+5, y-25, TFT_FOREGROUND);      // left foot
-    tft.drawLine(x+5, y-25, x+5, y-40, TFT_FOREGROUND);      // left straight
-    tft.drawLine(x+5, y-40, x+10, y-50, TFT_FOREGROUND);      // left top angle
-
-    tft.drawLine(x+20, y, x+15, y-25, TFT_FOREGROUND);      // right foot
-    tft.drawLine(x+15, y-25, x+15, y-40, TFT_FOREGROUND);      // right straight
-    tft.drawLine(x+15, y-40, x+10, y-50, TFT_FOREGROUND);      // right top angle
-
-    // lines across starting at bottom
-    tft.drawLine(x+1, y-5, x+19, y-5, TFT_FOREGROUND);      
-    tft.drawLine(x+3, y-15, x+18, y-15, TFT_FOREGROUND);  
-
-    tft.drawLine(x-5, y-25, x+25, y-25, TFT_FOREGROUND);    // bottom wider line across
-    tft.drawLine(x+5, y-30, x+15, y-30, TFT_FOREGROUND);
-    tft.drawLine(x-5, y-25, x+5, y-30, TFT_FOREGROUND);    // angle left
-    tft.drawLine(x+25, y-25, x+15, y-30, TFT_FOREGROUND);    // angle right
-
-    tft.drawLine(x-5, y-35, x+25, y-35, TFT_FOREGROUND);    // top wider line across
-    tft.drawLine(x+5, y-40, x+15, y-40, TFT_FOREGROUND);
-    tft.drawLine(x-5, y-35, x+5, y-40, TFT_FOREGROUND);    // angle left
-    tft.drawLine(x+25, y-35, x+15, y-40, TFT_FOREGROUND);    // angle right
-
-    // cross sections starting at bottom
-    tft.drawLine(x+3, y-5, x+18, y-15, TFT_FOREGROUND);
-    tft.drawLine(x+18, y-5, x+3, y-15, TFT_FOREGROUND);
-
-    tft.drawLine(x+3, y-15, x+15, y-25, TFT_FOREGROUND);
-    tft.drawLine(x+18, y-15, x+5, y-25, TFT_FOREGROUND);
-
-    tft.drawLine(x+5, y-25, x+15, y-30, TFT_FOREGROUND);
-    tft.drawLine(x+15, y-25, x+5, y-30, TFT_FOREGROUND);
-
-    tft.drawLine(x+5, y-30, x+15, y-35, TFT_FOREGROUND);
-    tft.drawLine(x+15, y-30, x+5, y-35, TFT_FOREGROUND);
-
-    tft.drawLine(x+5, y-35, x+15, y-40, TFT_FOREGROUND);
-    tft.drawLine(x+15, y-35, x+5, y-40, TFT_FOREGROUND);
-
-    // dots at end of pylon
-    tft.drawLine(x-5, y-34, x-5, y-33, TFT_FOREGROUND); // top left
-    tft.drawLine(x+25, y-34, x+25, y-33, TFT_FOREGROUND); // top right
-    tft.drawLine(x-5, y-24, x-5, y-23, TFT_FOREGROUND); // bottom left
-    tft.drawLine(x+25, y-24, x+25, y-23, TFT_FOREGROUND); // bottom right
+static void printBootProfile(void) {
+    Serial.println("Boot profile:       stage ms  at ms");
+    for (uint8_t i = 1; i < bootStageCount; i++) {
+        int64_t stage = bootStages[i].time - bootStages[i - 1].time;
+        Serial.printf("  %-16s %5u.%u %6u\n", bootStages[i].name, (unsigned)(stage / 1000), (unsigned)(stage / 100) % 10,
+            (unsigned)(bootStages[i].time / 1000));
+    }
+    if (bootStageCount > 1) {
+        int64_t total = bootStages[bootStageCount - 1].time - bootStages[0].time;
+        Serial.printf("  %-16s %5u.%u\n", "total", (unsigned)(total / 1000), (unsigned)(total / 100) % 10);
+    }
 }
 
+
 /**
- * @brief Display the sun
+ * @brief Touch screen has been touched! Tap to start/stop the screen saver.
  * 
- * @param x Display x coordinates
- * @param y Display y coordinates
+ * @param sample Touch sample from the touch reader task
  */
-static void drawSun(int x, int y) {
-    int scale = 12;  // 6
-
-    int linesize = 3;
-    int dxo, dyo, dxi, dyi;
-
-    tft.fillCircle(x, y, scale, TFT_RED);
-
-    for (float i = 0; i < 360; i = i + 45) {
-        dxo = 2.2 * scale * cos((i - 90) * 3.14 / 180);
-        dxi = dxo * 0.6;
-        dyo = 2.2 * scale * sin((i - 90) * 3.14 / 180);
-        dyi = dyo * 0.6;
-        if (i == 0 || i == 180) {
-            tft.drawLine(dxo + x - 1, dyo + y, dxi + x - 1, dyi + y, TFT_RED);
-            tft.drawLine(dxo + x + 0, dyo + y, dxi + x + 0, dyi + y, TFT_RED);
-            tft.drawLine(dxo + x + 1, dyo + y, dxi + x + 1, dyi + y, TFT_RED);
-        }
-        if (i == 90 || i == 270) {
-            tft.drawLine(dxo + x, dyo + y - 1, dxi + x, dyi + y - 1, TFT_RED);
-            tft.drawLine(dxo + x, dyo + y + 0, dxi + x, dyi + y + 0, TFT_RED);
-            tft.drawLine(dxo + x, dyo + y + 1, dxi + x, dyi + y + 1, TFT_RED);
-        }
-        if (i == 45 || i == 135 || i == 225 || i == 315) {
-            tft.drawLine(dxo + x - 1, dyo + y, dxi + x - 1, dyi + y, TFT_RED);
-            tft.drawLine(dxo + x + 0, dyo + y, dxi + x + 0, dyi + y, TFT_RED);
-            tft.drawLine(dxo + x + 1, dyo + y, dxi + x + 1, dyi + y, TFT_RED);
+static void touch(const touchSample_t *sample) {
+    static const char *gestureNames[] = {"tap", "long press", "swipe left", "swipe right", "swipe up", "swipe down"};
+    touchGesture_t gesture;
+
+    if (!touchGestures.update(sample->x, sample->y, sample->time, sample->down, &gesture))
+        return;
+
+    t_x = gesture.x;
+    t_y = gesture.y;
+
+    if (TOUCH_LOG_GESTURES) {
+        Serial.printf("Touch %s at %u,%u, %u ms after first sample, handled after %u ms\n", gestureNames[gesture.type],
+            gesture.x, gesture.y, (unsigned)(gesture.time - gesture.start), (unsigned)(millis() - gesture.start));
+    }
+
+    if (gesture.type == TOUCH_LONG_PRESS)
+        displayNotify(DISPLAY_EVENT_STATS);
+
+    // Any touch puts a shifted picture back, the page under it is still up to date
+    if (pixelShifting() && gesture.type != TOUCH_LONG_PRESS) {
+        stopPixelShift();
+        inactiveRunTime = millis();
+        if (gesture.type == TOUCH_TAP) {
+            updateLog("Pixel shift stopped by user");
+            return;
         }
     }
-}
 
-static void drawWaterTank(int x, int y) {
-//350, 160
-    tft.drawRoundRect(x, y, 22, 33, 6, TFT_FOREGROUND);
-    tft.fillRoundRect(x+1, y+1, 20, 31, 6, TFT_WATERTANK_HOT);
+    // Swipe the page along, next page from the right
+    if (gesture.type == TOUCH_SWIPE_LEFT && !screenSaverActive)
+        switchPage((currentPage() + 1) % PAGE_COUNT);
+    if (gesture.type == TOUCH_SWIPE_RIGHT && !screenSaverActive)
+        switchPage((currentPage() + PAGE_COUNT - 1) % PAGE_COUNT);
 
-    // shower hose
-    tft.drawLine(x+11, y, x+11, y-5, TFT_FOREGROUND);
-    tft.drawLine(x+11, y-5, x+35, y-5, TFT_FOREGROUND);
-    tft.drawLine(x+35, y-5, x+35, y+5, TFT_FOREGROUND);
-    tft.drawLine(x+30, y+6, x+40, y+6, TFT_FOREGROUND);
-    tft.drawLine(x+31, y+7, x+39, y+7, TFT_FOREGROUND);
+    if (gesture.type == TOUCH_TAP) {
+        if (!screenSaverActive && gesture.y < PAGE_TAB_HEIGHT) {
+            switchPage(gesture.x / PAGE_TAB_WIDTH);
+        } else if (!screenSaverActive) {
+            updateLog("Screen saver started by user");
+            startScreenSaver();
+        } else if (screenSaverActive) {
+            Serial.println("Stop screen saver");
+            screenSaverActive = false;
+            inactiveRunTime = millis();     // reset inactivity timer to now
+            initialiseScreen();
+            updateLog("Screen saver stopped by user");
+        }
+    }
+}
 
-    // water
-    tft.drawLine(x+31, y+8, x+27, y+15, TFT_WATERTANK_HOT); // left
-    tft.drawLine(x+33, y+8, x+30, y+15, TFT_WATERTANK_HOT); // left
+/**
+ * @brief Show another page and print how long the switch took.
+ * 
+ * @param page PAGE_xxx
+ */
+static void switchPage(uint8_t page) {
+    uint32_t elapsed;
 
-    tft.drawLine(x+35, y+8, x+35, y+15, TFT_WATERTANK_HOT); // middle
+    if (page >= PAGE_COUNT || page == currentPage())
+        return;
 
-    tft.drawLine(x+37, y+8, x+39, y+15, TFT_WATERTANK_HOT); // right
-    tft.drawLine(x+39, y+8, x+42, y+15, TFT_WATERTANK_HOT); // right
+    elapsed = showPage(page);
+    inactiveRunTime = millis();     // a page change is activity
+    Serial.printf("Page %u shown in %u.%02u ms%s\n", (unsigned)page, (unsigned)(elapsed / 1000),
+        (unsigned)(elapsed % 1000 / 10), elapsed > PAGE_SWITCH_TARGET * 1000 ? ", over target" : "");
 }
-
-// Not used or tested but saved as could be useful one day!
-//
-// static void print_stats(void)
-// {
-//     char *str = (char *)malloc(sizeof(char) * 2000);
-//     memset(str, 0, 2000);
-//     char *pcWriteBuffer = str;
- 
-//     TaskStatus_t *pxTaskStatusArray;
- 
-//     volatile UBaseType_t uxArraySize, x;
-//     unsigned long ulStatsAsPercentage;
-//     uint32_t ulTotalRunTime;
- 
-//    /* Make sure the write buffer does not contain a string. */
-//    *pcWriteBuffer = 0x00;
- 
-//    /* Take a snapshot of the number of tasks in case it changes while this
-//    function is executing. */
-//    uxArraySize = uxTaskGetNumberOfTasks();
- 
-//    /* Allocate a TaskStatus_t structure for each task.  An array could be
-//    allocated statically at compile time. */
-//    Serial.printf("sizeof TaskStatus_t: %d\n", sizeof(TaskStatus_t));
-//    pxTaskStatusArray = (TaskStatus_t*)pvPortMalloc( uxArraySize * sizeof(TaskStatus_t));
-//    memset(pxTaskStatusArray, 0, uxArraySize * sizeof(TaskStatus_t));
- 
-//    if( pxTaskStatusArray != NULL )
-//    {
-//       /* Generate raw status information about each task. */
-//       Serial.printf("Array size before: %d\n", uxArraySize);
-//       uxArraySize = uxTaskGetSystemState( pxTaskStatusArray,
-//                                  uxArraySize,
-//                                  &ulTotalRunTime );
-//       Serial.printf("Array size after: %d\n", uxArraySize);
-//       Serial.printf("Total runtime: %d\n", ulTotalRunTime);
- 
-//       /* For percentage calculations. */
-//       ulTotalRunTime /= 100UL;
- 
-//       /* Astatic void divide by zero errors. */
-//       if( ulTotalRunTime > 0 )
-//       {
-//          /* For each populated position in the pxTaskStatusArray array,
-//          format the raw data as human readable ASCII data. */
-//          Serial.printf("  name        runtime      pct     core         prio\n");
-//          for( int x = 0; x < uxArraySize; x++ )
-//          {
-//             TaskStatus_t *taskStatus;
-//             static void *tmp = &pxTaskStatusArray[x];
-//             static void *hmm = tmp + (4 * x);
-//             taskStatus = (TaskStatus_t*)hmm;
- 
-//                 // Serial.printf("Name: %.5s, ulRunTimeCounter: %d\n", taskStatus->pcTaskName , taskStatus->ulRunTimeCounter);
-//             /* What percentage of the total run time has the task used?
-//             This will always be rounded down to the nearest integer.
-//             ulTotalRunTimeDiv100 has already been divided by 100. */
-//             ulStatsAsPercentage =
-//                   taskStatus->ulRunTimeCounter / ulTotalRunTime;
- 
-//             if( ulStatsAsPercentage > 0UL )
-//             {
-//                sprintf( pcWriteBuffer, "%30s %10lu %10lu%% %5d %5d\n",
-//                                  taskStatus->pcTaskName,
-//                                  taskStatus->ulRunTimeCounter,
-//                                  ulStatsAsPercentage,
-//                                 *((int *)(&taskStatus->usStackHighWaterMark)+1),
-//                                 taskStatus->uxBasePriority);
-//             }
-//             else
-//             {
-//                /* If the percentage is zero here then the task has
-//                consumed less than 1% of the total run time. */
-//                sprintf( pcWriteBuffer, "%30s %10lu %10s  %5d %5d\n",
-//                                  taskStatus->pcTaskName,
-//                                  taskStatus->ulRunTimeCounter,
-//                                  "<1%",
-//                                  *((uint32_t *)(&taskStatus->usStackHighWaterMark)+1),
-//                                  taskStatus->uxBasePriority);
-//             }
- 
-//             pcWriteBuffer += strlen( ( char * ) pcWriteBuffer );
-//             // Serial.printf("len: %d, idx: %d\n", pcWriteBuffer - str, x);
-//          }
-//          Serial.print(str);
-//       }
- 
-//       /* The array is no longer needed, free the memory it consumes. */
-//       vPortFree( pxTaskStatusArray );
-//       free(str);
-//    }
-// }
\ No newline at end of file
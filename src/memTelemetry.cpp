@@ -0,0 +1,155 @@
+/*
+    Memory and stack telemetry, see memTelemetry.h.
+*/
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "memTelemetry.h"
+
+#define TASK_NAME_LENGTH 12
+
+static memSample_t samples[MEM_TELEMETRY_SAMPLES];
+static uint32_t sampleCount = 0;        // Samples taken, samples[] holds the last MEM_TELEMETRY_SAMPLES
+static char taskNames[MEM_TELEMETRY_TASKS][TASK_NAME_LENGTH];
+static uint8_t taskCount = 0;
+static TaskStatus_t taskList[MEM_TELEMETRY_TASKS + 8];
+static portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t telemetryTaskHandle = NULL;
+static uint32_t samplePeriod;
+static uint32_t blockWarning;
+static bool blockWarned = false;
+
+static void telemetryTask(void *parameter);
+static void takeSample(void);
+static int taskSlot(const char *name);
+
+
+/**
+ * @brief Start the sampler task. The first sample is taken straight away.
+ *
+ * @param period Time between samples (ms)
+ * @param warnBlock Warn when the largest free block drops below this, e.g. the biggest sprite (bytes)
+ * @return true Sampler running
+ */
+bool memTelemetryBegin(uint32_t period, uint32_t warnBlock) {
+    if (telemetryTaskHandle != NULL)
+        return true;
+
+    samplePeriod = period;
+    blockWarning = warnBlock;
+
+    return xTaskCreatePinnedToCore(telemetryTask, "memTelemetry", MEM_TELEMETRY_TASK_STACK, NULL,
+        MEM_TELEMETRY_TASK_PRIORITY, &telemetryTaskHandle, MEM_TELEMETRY_TASK_CORE) == pdPASS;
+}
+
+/**
+ * @brief Print the ring, oldest sample first. One line per sample: time, free heap,
+ * minimum free heap, largest block, fragmentation and the free stack of each task.
+ *
+ * @param out Where to print, e.g. Serial
+ */
+void memTelemetryDump(Print &out) {
+    uint32_t count, first;
+    memSample_t sample;
+    char names[MEM_TELEMETRY_TASKS][TASK_NAME_LENGTH];
+    uint8_t tasks;
+
+    // The sampler adds tasks as it sees them, columns added after this are left out
+    taskENTER_CRITICAL(&ringLock);
+    count = sampleCount;
+    tasks = taskCount;
+    memcpy(names, taskNames, tasks * TASK_NAME_LENGTH);
+    taskEXIT_CRITICAL(&ringLock);
+
+    first = count > MEM_TELEMETRY_SAMPLES ? count - MEM_TELEMETRY_SAMPLES : 0;
+    out.printf("Memory telemetry, %u samples every %u ms, free stack in bytes\n", (unsigned)(count - first), (unsigned)samplePeriod);
+    out.printf("%6s %7s %7s %7s %4s", "time", "free", "min", "block", "frag");
+    for (uint8_t t = 0; t < tasks; t++)
+        out.printf(" %.*s", 6, names[t]);
+    out.println();
+
+    for (uint32_t n = first; n < count; n++) {
+        taskENTER_CRITICAL(&ringLock);
+        sample = samples[n % MEM_TELEMETRY_SAMPLES];
+        taskEXIT_CRITICAL(&ringLock);
+
+        uint32_t frag = sample.freeHeap ? 100 - (uint32_t)((uint64_t)sample.largestBlock * 100 / sample.freeHeap) : 0;
+        out.printf("%6u %7u %7u %7u %3u%%", (unsigned)sample.time, (unsigned)sample.freeHeap, (unsigned)sample.minFreeHeap,
+            (unsigned)sample.largestBlock, (unsigned)frag);
+        for (uint8_t t = 0; t < tasks; t++)
+            out.printf(" %6u", (unsigned)sample.stackFree[t]);
+        out.println();
+    }
+}
+
+/**
+ * @brief Sampler task, one sample every samplePeriod.
+ *
+ */
+static void telemetryTask(void *parameter) {
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for ( ;; ) {
+        takeSample();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(samplePeriod));
+    }
+}
+
+/**
+ * @brief Take a sample into the ring, only the sampler task writes the ring.
+ */
+static void takeSample(void) {
+    memSample_t sample;
+    UBaseType_t count;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.time = millis() / 1000;
+    sample.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    sample.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    count = uxTaskGetSystemState(taskList, sizeof(taskList) / sizeof(taskList[0]), NULL);
+    for (UBaseType_t i = 0; i < count; i++) {
+        int slot = taskSlot(taskList[i].pcTaskName);
+        if (slot >= 0)
+            sample.stackFree[slot] = min(taskList[i].usStackHighWaterMark, (configSTACK_DEPTH_TYPE)UINT16_MAX);
+    }
+
+    taskENTER_CRITICAL(&ringLock);
+    samples[sampleCount % MEM_TELEMETRY_SAMPLES] = sample;
+    sampleCount++;
+    taskEXIT_CRITICAL(&ringLock);
+
+    if (blockWarning > 0 && sample.largestBlock < blockWarning && !blockWarned) {
+        Serial.printf("Memory: largest free block %u bytes, below %u, sprite allocations may fail\n",
+            (unsigned)sample.largestBlock, (unsigned)blockWarning);
+    }
+    blockWarned = sample.largestBlock < blockWarning;
+}
+
+/**
+ * @brief Column of a task in the samples, tasks get a column the first time they are seen.
+ * Only the sampler task adds columns, under ringLock so memTelemetryDump() sees whole names.
+ *
+ * @return int Column, -1 if all MEM_TELEMETRY_TASKS columns are taken
+ */
+static int taskSlot(const char *name) {
+    for (uint8_t t = 0; t < taskCount; t++) {
+        if (strncmp(taskNames[t], name, TASK_NAME_LENGTH - 1) == 0)
+            return t;
+    }
+
+    if (taskCount == MEM_TELEMETRY_TASKS)
+        return -1;
+
+    taskENTER_CRITICAL(&ringLock);
+    strncpy(taskNames[taskCount], name, TASK_NAME_LENGTH - 1);
+    taskNames[taskCount][TASK_NAME_LENGTH - 1] = '\0';
+    int slot = taskCount++;
+    taskEXIT_CRITICAL(&ringLock);
+
+    return slot;
+}
@@ -0,0 +1,311 @@
+/*
+    Cache of the static layer of each page, see pageCache.h
+*/
+
+#include "esp_heap_caps.h"
+#include "pageCache.h"
+
+// Span of a row to send, as one address window
+typedef struct {
+    int16_t start;
+    int16_t end;        // exclusive, start == end for none
+} pageSpan_t;
+
+// Address window last set, it runs to the bottom of the screen so the same span on the
+// next row carries on in it
+typedef struct {
+    int16_t start;
+    int16_t end;
+    int16_t nextY;      // Row the window carries on at, -1 for none
+} pageWindow_t;
+
+static uint16_t line[PAGE_CACHE_LINE];  // A span's pixels, expanded from its runs
+
+static uint8_t rowDirty(int32_t y, const pageRect_t *dirty, uint8_t dirtyCount, int16_t spans[][2]);
+static void sendSpan(SpiProfiledTFT *tft, int32_t y, const pageRun_t *row, pageSpan_t *pending, pageWindow_t *window, int32_t x, int32_t length, uint32_t *pixels);
+static void flushSpan(SpiProfiledTFT *tft, int32_t y, const pageRun_t *row, pageSpan_t *pending, pageWindow_t *window, uint32_t *pixels);
+
+PageCache::PageCache(SpiProfiledTFT *tft) : tft(tft) {
+    for (uint8_t p = 0; p < PAGE_CACHE_PAGES; p++) {
+        runs[p] = NULL;
+        rowStart[p] = NULL;
+        runCount[p] = 0;
+    }
+}
+
+/**
+ * @brief Draw a page's static layer and cache it. CPU only, the page is drawn into a
+ * PAGE_CACHE_BAND row sprite once per band and nothing is sent to the panel.
+ * 
+ * @param page Page number, less than PAGE_CACHE_PAGES
+ * @param draw Draws the static layer, on whatever it is given, in screen coordinates
+ * @return true Cached, false if there isn't the memory, or in internal RAM it would leave
+ * less than PAGE_CACHE_RESERVE
+ */
+bool PageCache::capture(uint8_t page, pageDraw_t draw) {
+    TFT_eSprite band(tft);
+    int32_t width = tft->width(), height = tft->height();
+    uint32_t capacity = 0;
+    uint32_t caps = MALLOC_CAP_SPIRAM;
+    bool ok = true;
+
+    if (page >= PAGE_CACHE_PAGES)
+        return false;
+
+    free(runs[page]);
+    free(rowStart[page]);
+    runs[page] = NULL;
+    runCount[page] = 0;
+
+    rowStart[page] = (uint32_t *)heap_caps_malloc((height + 1) * sizeof(uint32_t), caps);
+    if (rowStart[page] == NULL) {
+        caps = MALLOC_CAP_8BIT;     // no PSRAM
+        if (heap_caps_get_largest_free_block(caps) >= PAGE_CACHE_RESERVE)
+            rowStart[page] = (uint32_t *)heap_caps_malloc((height + 1) * sizeof(uint32_t), caps);
+    }
+    if (rowStart[page] == NULL || band.createSprite(width, PAGE_CACHE_BAND) == NULL) {
+        free(rowStart[page]);
+        rowStart[page] = NULL;
+        return false;
+    }
+
+    for (int32_t top = 0; top < height && ok; top += PAGE_CACHE_BAND) {
+        band.setViewport(0, -top, width, top + PAGE_CACHE_BAND);   // datum moves the band to the top
+        draw(&band);
+        band.resetViewport();
+
+        for (int32_t row = 0; row < PAGE_CACHE_BAND && top + row < height && ok; row++) {
+            rowStart[page][top + row] = runCount[page];
+            for (int32_t x = 0; x < width && ok; ) {
+                uint16_t colour = band.readPixel(x, row);
+                int32_t length = 1;
+
+                while (x + length < width && band.readPixel(x + length, row) == colour)
+                    length++;
+                ok = addRun(page, &capacity, caps, colour, length);
+                x += length;
+            }
+        }
+    }
+    band.deleteSprite();
+
+    if (ok) {
+        rowStart[page][height] = runCount[page];
+        pageRun_t *fitted = (pageRun_t *)heap_caps_realloc(runs[page], runCount[page] * sizeof(pageRun_t), caps);
+        if (fitted != NULL)
+            runs[page] = fitted;
+
+        // Without PSRAM only keep the page if it leaves enough internal RAM
+        if (caps == MALLOC_CAP_8BIT && heap_caps_get_largest_free_block(caps) < PAGE_CACHE_RESERVE)
+            ok = false;
+    }
+
+    if (!ok) {
+        free(runs[page]);
+        free(rowStart[page]);
+        runs[page] = NULL;
+        rowStart[page] = NULL;
+        runCount[page] = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Restore a page's static layer to the screen. Only the pixels that differ from
+ * the static layer of the page on the screen now, or where its live content is, are sent.
+ * 
+ * @param page Page to show
+ * @param from Page on the screen now, PAGE_NONE (or not cached) to send everything
+ * @param dirty Where the live content of the page on the screen is
+ * @param dirtyCount Number of dirty areas, at most PAGE_DIRTY_MAX
+ * @return uint32_t Pixels sent
+ */
+uint32_t PageCache::restore(uint8_t page, uint8_t from, const pageRect_t *dirty, uint8_t dirtyCount) {
+    int32_t width = tft->width(), height = tft->height();
+    int16_t spans[PAGE_DIRTY_MAX][2];
+    pageWindow_t window = {0, 0, -1};
+    uint32_t pixels = 0;
+
+    if (!cached(page) || width > PAGE_CACHE_LINE)
+        return 0;
+    if (!cached(from))
+        from = PAGE_NONE;
+    dirtyCount = min(dirtyCount, (uint8_t)PAGE_DIRTY_MAX);
+
+    for (int32_t y = 0; y < height; y++) {
+        const pageRun_t *row = &runs[page][rowStart[page][y]];
+        pageSpan_t pending = {0, 0};
+
+        if (from == PAGE_NONE) {
+            sendSpan(tft, y, row, &pending, &window, 0, width, &pixels);
+            flushSpan(tft, y, row, &pending, &window, &pixels);
+            continue;
+        }
+
+        const pageRun_t *next = row;
+        const pageRun_t *old = &runs[from][rowStart[from][y]];
+        int32_t nextLeft = next->length, oldLeft = old->length;
+        uint8_t spanCount = rowDirty(y, dirty, dirtyCount, spans);
+        uint8_t span = 0;
+
+        // Walk both rows together a piece at a time, each piece one colour in both
+        for (int32_t x = 0; x < width; ) {
+            int32_t length = min(nextLeft, oldLeft);
+
+            if (next->colour != old->colour) {
+                sendSpan(tft, y, row, &pending, &window, x, length, &pixels);
+            } else {
+                // Same colour in both, only send where the old page's live content is
+                while (span < spanCount && spans[span][1] <= x)
+                    span++;
+                for (uint8_t s = span; s < spanCount && spans[s][0] < x + length; s++) {
+                    int32_t start = max((int32_t)spans[s][0], x);
+                    int32_t end = min((int32_t)spans[s][1], x + length);
+                    sendSpan(tft, y, row, &pending, &window, start, end - start, &pixels);
+                }
+            }
+
+            x += length;
+            nextLeft -= length;
+            oldLeft -= length;
+            if (nextLeft == 0 && x < width)
+                nextLeft = (++next)->length;
+            if (oldLeft == 0 && x < width)
+                oldLeft = (++old)->length;
+        }
+        flushSpan(tft, y, row, &pending, &window, &pixels);
+    }
+
+    return pixels;
+}
+
+/**
+ * @brief Memory used by a page in the cache.
+ * 
+ * @return size_t Bytes
+ */
+size_t PageCache::size(uint8_t page) {
+    if (!cached(page))
+        return 0;
+
+    return runCount[page] * sizeof(pageRun_t) + (tft->height() + 1) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Add a run to a page being captured, growing the run buffer as needed.
+ * 
+ * @return true Added, false out of memory
+ */
+bool PageCache::addRun(uint8_t page, uint32_t *capacity, uint32_t caps, uint16_t colour, uint16_t length) {
+    if (runCount[page] == *capacity) {
+        uint32_t grown = *capacity == 0 ? 1024 : *capacity * 2;
+        pageRun_t *buffer = (pageRun_t *)heap_caps_realloc(runs[page], grown * sizeof(pageRun_t), caps);
+
+        if (buffer == NULL)
+            return false;
+        runs[page] = buffer;
+        *capacity = grown;
+    }
+
+    runs[page][runCount[page]].colour = colour;
+    runs[page][runCount[page]].length = length;
+    runCount[page]++;
+
+    return true;
+}
+
+/**
+ * @brief The dirty areas crossing a row, as sorted spans with the overlaps merged.
+ * 
+ * @param spans Filled in with start and end (exclusive) x of each span
+ * @return uint8_t Number of spans
+ */
+static uint8_t rowDirty(int32_t y, const pageRect_t *dirty, uint8_t dirtyCount, int16_t spans[][2]) {
+    uint8_t count = 0;
+
+    for (uint8_t d = 0; d < dirtyCount; d++) {
+        if (y < dirty[d].y || y >= dirty[d].y + dirty[d].h || dirty[d].w <= 0)
+            continue;
+
+        // Insertion sort by start
+        uint8_t i = count++;
+        for (; i > 0 && spans[i - 1][0] > dirty[d].x; i--) {
+            spans[i][0] = spans[i - 1][0];
+            spans[i][1] = spans[i - 1][1];
+        }
+        spans[i][0] = dirty[d].x;
+        spans[i][1] = dirty[d].x + dirty[d].w;
+    }
+
+    // Merge overlapping spans
+    uint8_t merged = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (merged > 0 && spans[i][0] <= spans[merged - 1][1]) {
+            spans[merged - 1][1] = max(spans[merged - 1][1], spans[i][1]);
+        } else {
+            spans[merged][0] = spans[i][0];
+            spans[merged][1] = spans[i][1];
+            merged++;
+        }
+    }
+
+    return merged;
+}
+
+/**
+ * @brief Queue pixels to send, joined on to the pending span if they are no more than
+ * PAGE_CACHE_GAP pixels after it.
+ * 
+ * @param row First run of the row in the page being restored
+ */
+static void sendSpan(SpiProfiledTFT *tft, int32_t y, const pageRun_t *row, pageSpan_t *pending, pageWindow_t *window, int32_t x, int32_t length, uint32_t *pixels) {
+    if (length <= 0)
+        return;
+
+    if (pending->end > pending->start && x - pending->end <= PAGE_CACHE_GAP) {
+        pending->end = max((int32_t)pending->end, x + length);
+        return;
+    }
+
+    flushSpan(tft, y, row, pending, window, pixels);
+    pending->start = x;
+    pending->end = x + length;
+}
+
+/**
+ * @brief Send the pending span: the page's runs across it are expanded into the line
+ * buffer and sent with one pushPixels(). A new address window is only set if the span
+ * isn't the one sent on the row above, which carries on in the window already set.
+ * 
+ */
+static void flushSpan(SpiProfiledTFT *tft, int32_t y, const pageRun_t *row, pageSpan_t *pending, pageWindow_t *window, uint32_t *pixels) {
+    int32_t x = 0;
+    uint16_t *out = line;
+
+    if (pending->end <= pending->start)
+        return;
+
+    while (x + row->length <= pending->start)
+        x += (row++)->length;
+
+    for (int32_t at = pending->start; at < pending->end; x += (row++)->length) {
+        int32_t length = min(x + (int32_t)row->length, (int32_t)pending->end) - at;
+
+        for (int32_t i = 0; i < length; i++)
+            *out++ = row->colour;
+        at += length;
+    }
+
+    if (window->start != pending->start || window->end != pending->end || window->nextY != y) {
+        tft->setAddrWindow(pending->start, y, pending->end - pending->start, tft->height() - y);
+        window->start = pending->start;
+        window->end = pending->end;
+    }
+    window->nextY = y + 1;
+    tft->pushPixels(line, pending->end - pending->start);
+
+    *pixels += pending->end - pending->start;
+    pending->start = pending->end = 0;
+}
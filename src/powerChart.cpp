@@ -0,0 +1,211 @@
+/*
+    Scrolling power history chart, see powerChart.h
+*/
+
+#include "powerChart.h"
+
+static const uint16_t seriesColours[CHART_SERIES] = {TFT_YELLOW, TFT_RED, TFT_SKYBLUE};
+
+static int32_t columnRange(const chartColumn_t *column);
+
+PowerChart::PowerChart(TFT_eSPI *tft) : sprite(tft) {
+    head = count = samples = 0;
+    samplesPerColumn = 1;
+    range = CHART_RANGE_STEP;
+    scrolled = true;
+}
+
+/**
+ * @brief Create the chart sprite, CHART_WIDTH x CHART_HEIGHT at 16 bits.
+ * 
+ * @param samplesPerColumn Samples folded into each column, the history is
+ * CHART_WIDTH * samplesPerColumn samples long
+ * @return true Sprite created
+ */
+bool PowerChart::begin(uint16_t samplesPerColumn) {
+    this->samplesPerColumn = max(samplesPerColumn, (uint16_t)1);
+
+    if (sprite.createSprite(CHART_WIDTH, CHART_HEIGHT) == NULL)
+        return false;
+
+    render();
+    return true;
+}
+
+/**
+ * @brief Add a sample to the column being filled and render that column. The column is
+ * finished, and the chart moves on a column, after samplesPerColumn samples.
+ * 
+ * The range grows to fit the sample, and shrinks to fit the columns left when the column
+ * that needed it scrolls off.
+ * 
+ * @param solar W generated
+ * @param grid W, positive importing, negative exporting
+ * @param water W into the immersion heater
+ * @return true The range changed and the whole chart was redrawn
+ */
+bool PowerChart::addSample(int32_t solar, int32_t grid, int32_t water) {
+    int32_t values[CHART_SERIES] = {solar, grid, water};
+    int32_t newRange = range;
+
+    // A new column replaces the oldest once the ring is full, it may have set the range
+    if (samples == 0 && count == CHART_WIDTH && columnRange(&columns[head]) == range) {
+        newRange = CHART_RANGE_STEP;
+        for (uint16_t i = 0; i < CHART_WIDTH; i++) {
+            if (i != head)
+                newRange = max(newRange, columnRange(&columns[i]));
+        }
+    }
+
+    for (uint8_t s = 0; s < CHART_SERIES; s++) {
+        int16_t value = constrain(values[s], INT16_MIN, INT16_MAX);
+
+        if (samples == 0 || value < current.min[s])
+            current.min[s] = value;
+        if (samples == 0 || value > current.max[s])
+            current.max[s] = value;
+    }
+    newRange = max(newRange, columnRange(&current));
+
+    bool rescaled = newRange != range;
+    range = newRange;
+    scrolled = samples == 0 || rescaled;  // a new column on the right, or every column
+    samples++;
+
+    if (sprite.created()) {
+        if (rescaled)
+            render();
+        else
+            renderColumn(head, &current);
+    }
+
+    if (samples == samplesPerColumn) {
+        columns[head] = current;
+        head = (head + 1) % CHART_WIDTH;
+        count = min((uint16_t)(count + 1), (uint16_t)CHART_WIDTH);
+        samples = 0;
+    }
+
+    return rescaled;
+}
+
+/**
+ * @brief Push the chart with the newest column on the right, in two parts so the ring
+ * doesn't need to be moved.
+ * 
+ * @param x Screen x of the left of the chart
+ * @param y Screen y of the top of the chart
+ */
+void PowerChart::push(int32_t x, int32_t y) {
+    uint16_t oldest = (rightColumn() + 1) % CHART_WIDTH;
+
+    if (!sprite.created())
+        return;
+
+    if (oldest == 0) {
+        sprite.pushSprite(x, y);
+    } else {
+        sprite.pushSprite(x, y, oldest, 0, CHART_WIDTH - oldest, CHART_HEIGHT);
+        sprite.pushSprite(x + CHART_WIDTH - oldest, y, 0, 0, oldest, CHART_HEIGHT);
+    }
+}
+
+/**
+ * @brief Push what the last sample changed. Usually that is only the rightmost column,
+ * the whole chart when the sample started a new column (the chart scrolls) or grew the
+ * range. The chart must have been pushed in full since the sample before, e.g. when the
+ * page was drawn.
+ * 
+ * @param x Screen x of the left of the chart
+ * @param y Screen y of the top of the chart
+ */
+void PowerChart::pushLatest(int32_t x, int32_t y) {
+    if (!sprite.created())
+        return;
+
+    if (scrolled)
+        push(x, y);
+    else
+        sprite.pushSprite(x + CHART_WIDTH - 1, y, rightColumn(), 0, 1, CHART_HEIGHT);
+}
+
+/**
+ * @brief Sprite column shown on the right, the one being filled or the last finished.
+ * 
+ */
+uint16_t PowerChart::rightColumn(void) {
+    return samples > 0 ? head : (head + CHART_WIDTH - 1) % CHART_WIDTH;
+}
+
+/**
+ * @brief Render every column, only needed when the range changes.
+ * 
+ */
+void PowerChart::render(void) {
+    for (uint16_t i = 0; i < CHART_WIDTH; i++) {
+        // Finished columns are the count before head, the one at head may be in progress
+        bool finished = (uint16_t)((head + CHART_WIDTH - 1 - i) % CHART_WIDTH) < count;
+
+        if (i == head && samples > 0)
+            renderColumn(i, &current);
+        else
+            renderColumn(i, finished ? &columns[i] : NULL);
+    }
+}
+
+/**
+ * @brief Render one column into the sprite, each series as a bar from its min to its max.
+ * 
+ * @param index Sprite column
+ * @param column Column to draw, NULL for an empty column
+ */
+void PowerChart::renderColumn(uint16_t index, const chartColumn_t *column) {
+    sprite.drawFastVLine(index, 0, CHART_HEIGHT, CHART_BACKGROUND);
+
+    // Dotted line every CHART_RANGE_STEP, solid at 0 W
+    if (index % 4 == 0) {
+        for (int32_t watts = CHART_RANGE_STEP; watts <= range; watts += CHART_RANGE_STEP)
+            sprite.drawPixel(index, toY(watts), CHART_LINE_COLOUR);
+    }
+    sprite.drawPixel(index, CHART_ZERO_Y, CHART_LINE_COLOUR);
+
+    if (column == NULL)
+        return;
+
+    // Water first so solar and grid, usually larger, don't hide it
+    for (int8_t s = CHART_SERIES - 1; s >= 0; s--) {
+        int16_t top = toY(column->max[s]);
+        int16_t bottom = toY(column->min[s]);
+
+        if (column->max[s] == 0 && column->min[s] == 0)
+            continue;       // idle, leave the 0 W line showing
+        sprite.drawFastVLine(index, top, bottom - top + 1, seriesColours[s]);
+    }
+}
+
+/**
+ * @brief Range a column needs, its largest value or three times its largest export as
+ * export has a third of the height, rounded up to a CHART_RANGE_STEP.
+ * 
+ * @return int32_t W, at least CHART_RANGE_STEP
+ */
+static int32_t columnRange(const chartColumn_t *column) {
+    int32_t needed = CHART_RANGE_STEP;
+
+    for (uint8_t s = 0; s < CHART_SERIES; s++) {
+        needed = max(needed, (int32_t)column->max[s]);
+        needed = max(needed, -(int32_t)column->min[s] * (CHART_ZERO_Y) / (CHART_HEIGHT - CHART_ZERO_Y));
+    }
+
+    return (needed + CHART_RANGE_STEP - 1) / CHART_RANGE_STEP * CHART_RANGE_STEP;
+}
+
+/**
+ * @brief Sprite row for a power.
+ * 
+ */
+int16_t PowerChart::toY(int32_t watts) {
+    int32_t y = CHART_ZERO_Y - watts * CHART_ZERO_Y / range;
+
+    return constrain(y, 0, CHART_HEIGHT - 1);
+}
@@ -0,0 +1,1346 @@
+/*
+    Monitor screen drawing, see screen.h.
+*/
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "TFT_eSPI.h"
+#include "fontPartition.h"
+#include "spiProfiler.h"
+#include "fastRandom.h"
+#include "telemetry.h"
+#include "powerChart.h"
+#include "pageCache.h"
+#include "screen.h"
+
+/*
+    CLOG_ENABLE Needs to be defined before cLog.h is included.  
+    
+    Using cLog's linked list to hold log messages which will be displayed in the log
+    area as required. Can display up to 7 messages each up to 43 characters wide. New
+    messages will replace older ones and the screen will then be updated.
+*/ 
+
+#define CLOG_ENABLE true
+#include "cLog.h"
+
+SpiProfiledTFT tft = SpiProfiledTFT();  // TFT object, counted by the SPI profiler
+
+SpiProfiledSprite lineSprite = SpiProfiledSprite(&tft);    // Sprite object
+SpiProfiledSprite rightArrowSprite = SpiProfiledSprite(&tft);    // Sprite object
+SpiProfiledSprite leftArrowSprite = SpiProfiledSprite(&tft);    // Sprite object
+SpiProfiledSprite fillFrameSprite = SpiProfiledSprite(&tft);    // Sprite object
+SpiProfiledSprite logSprite = SpiProfiledSprite(&tft);    // Sprite object for log area
+SpiProfiledSprite valueSprite = SpiProfiledSprite(&tft);  // Smooth font sprite for the kW values
+SpiProfiledSprite totalSprite = SpiProfiledSprite(&tft);  // Smooth font sprite for the daily kWh total
+
+// Smooth fonts, loaded once into the value sprites and left loaded
+#define VALUE_FONT "value"          // Name of the kW font in the font partition
+#define TOTAL_FONT "total"          // Name of the kWh total font in the font partition
+#define VALUE_GLYPHS "0123456789.- kWh"
+#define VALUE_SPRITE_WIDTH 100
+#define TOTAL_SPRITE_WIDTH 150
+#define VALUE_HEIGHT 30             // Tallest a value gets, smooth or built-in font
+bool smoothFonts = false;           // true when the font partition fonts are loaded
+HotGlyphCache valueGlyphs;
+HotGlyphCache totalGlyphs;
+
+valueField_t solarNowField = {110, 85, 2, 1, false, 0};
+valueField_t gridNowField = {280, 85, 2, 1, false, 0};
+valueField_t solarTodayField = {100, 45, 4, 1, true, 0};
+valueField_t waterNowField = {110, 150, 2, 1, false, 0};
+valueField_t waterTodayField = {110, 205, 1, 2, true, 0};
+//
+
+// Power history chart, right of the water tank and larger on the history page
+#define CHART_X 280
+#define CHART_Y 155
+#define HISTORY_CHART_X 30
+#define HISTORY_CHART_Y 70
+#define HISTORY_TOTAL_X 270
+PowerChart powerChart(&tft);
+//
+
+// Pages, the static layer of each is cached and restored when the page is shown
+#define LOG_PAGE_X 10
+#define LOG_PAGE_Y 35
+#define LOG_PAGE_WIDTH 460
+#define LOG_PAGE_LINE 22
+#define SETTINGS_INFO_Y 200
+static const char *pageNames[PAGE_COUNT] = {"Dashboard", "History", "Log", "Settings"};
+static uint8_t page = PAGE_DASHBOARD;      // Page on the screen
+static PageCache pageCache(&tft);
+//
+
+// Screen Saver 
+#define TEXT_HEIGHT 8     // Height of text to be printed and scrolled
+#define TEXT_WIDTH 6      // Width of text to be printed and scrolled
+
+#define LINE_HEIGHT 9     // TEXT_HEIGHT + 1
+#define COL_WIDTH 8       // TEXT_WIDTH + 2
+
+#define MAX_CHR 35        // characters per line (tft.height() / LINE_HEIGHT);
+#define MAX_COL 54        // maximum number of columns (tft.width() / COL_WIDTH);
+#define MAX_COL_DOT6 32   // MAX_COL * 0.6
+
+#define MATRIX_CHAR 0x7F          // Cell bits for the character, 0 until one is picked
+#define MATRIX_HEAD 0x80          // Cell bit for a new bright character starting to fall
+#define MATRIX_BRIGHT 63          // Green level of a new character, drawn grey
+
+// Each column scrolls two rings the opposite ways, the characters up and the brightness
+// down, so scrolling a column is moving its two heads.  The brightness is only kept as
+// where each new character started, its level is how far it has fallen since, through
+// matrixFade.  Both rings share the bytes of the column.
+static uint8_t matrixCells[MAX_COL][MAX_CHR];
+static uint8_t charHead[MAX_COL];       // Cell of the top character
+static uint8_t fadeHead[MAX_COL];       // Cell of the top brightness
+static uint8_t bottomAge[MAX_COL];      // Ticks the bottom has fallen, its head may have gone
+
+// Green level by the number of ticks since the bright head, fast then slow, 0 after
+static const uint8_t matrixFade[] = {
+    63, 59, 55, 51, 47, 43, 39, 35, 31, 27, 23, 19, 18, 17, 16, 15,
+    14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1
+};
+static FastRandom matrixRandom;
+//
+
+// Animation
+static int sunX = 100;      // Sun x y
+static int sunY = 105;
+static int gridX = 260;
+static int gridY = 105;
+static int waterX = 105;
+static int waterY = 170;
+static int width = 83;    // Width of drawing space minus width of arrow 
+#define LANE_WIDTH 95       // Line the arrows run along
+#define LANE_HEIGHT 21      // Height of an arrow
+#define ARROW_WIDTH 12      // Including the column of line the arrow leaves behind
+#define ARROW_FRACTION_BITS 8       // Arrow positions are fixed point, 1/256 pixel
+#define ARROW_SPEED_PER_KW 256      // 1 pixel a tick for each kW flowing
+#define ARROW_MIN_SPEED 32          // 1/8 pixel a tick, so a trickle still moves
+#define ARROW_MAX_STEP 4            // Pixels a tick at most
+#define ARROW_TRAIL (ARROW_MAX_STEP - 1)    // Extra columns of line behind the arrow sprites
+
+// What animationStep() left for animationDraw() to do in a lane
+#define ARROW_NONE 0                // Still within the same pixel
+#define ARROW_MOVE 1                // Draw the arrow at its new pixel
+#define ARROW_CLEAR 2               // Off the end, clear it from where it was drawn
+
+// Flow animation lane, the arrow's speed follows the power flowing
+typedef struct {
+    int x;                  // Left of the lane
+    int y;                  // Top of the lane
+    bool left;              // Arrow runs right to left
+    int32_t position;       // Arrow x, fixed point with ARROW_FRACTION_BITS
+    int16_t drawn;          // Arrow x on the screen
+    bool visible;           // Arrow is on the screen at drawn
+    uint8_t pending;        // ARROW_xxx
+} flowLane_t;
+
+static flowLane_t sunLane = {sunX, sunY, false, (sunX + 40) << ARROW_FRACTION_BITS, 0, false, ARROW_NONE};
+static flowLane_t gridImportLane = {gridX, gridY, true, (gridX + width) << ARROW_FRACTION_BITS, 0, false, ARROW_NONE};
+static flowLane_t gridExportLane = {gridX, gridY, false, gridX << ARROW_FRACTION_BITS, 0, false, ARROW_NONE};
+static flowLane_t waterLane = {waterX, waterY, false, (waterX + 15) << ARROW_FRACTION_BITS, 0, false, ARROW_NONE};    // not level with the sun's
+//
+
+// Clog init
+const uint16_t maxEntries = 7;
+const uint16_t maxEntryChars = 44;
+CLOG_NEW myLog1(maxEntries, maxEntryChars, NO_TRIGGER, WRAP);
+//
+
+// Flow animation lanes, only set from a telemetry snapshot by showTelemetry() between
+// frames, so animation() and initialiseScreen() never see a half updated set
+static bool solarGeneration = true;
+static bool gridImport = true;
+static bool gridExport = false;
+static bool waterHeating = true;
+bool screenSaverActive = false;     // Is the screen saver active or not
+static bool shifting = false;       // Pixel shift screen saver running
+static uint8_t shiftStep = 0;       // Where in the pixel shift cycle the screen is
+
+// Values on the screen, the demo values until the first telemetry arrives
+static telemetry_t shown = {2340, 1670, 890, 12670, 2570, 23, true};
+
+static void showDashboard(void);
+static void showHistory(void);
+static void showLog(void);
+static void showSettings(void);
+static void showTotals(void);
+static void drawLogLines(void);
+static void showField(const char *text, int x, int y, int font, int16_t *lastWidth);
+static uint8_t dashboardDirty(pageRect_t *rects);
+static uint8_t historyDirty(pageRect_t *rects);
+static uint8_t logDirty(pageRect_t *rects);
+static uint8_t settingsDirty(pageRect_t *rects);
+static int16_t valueHeight(valueField_t *field);
+static void drawTelemetry(uint32_t fields);
+static void drawChartRange(int x, int y);
+static void formatKilo(char *text, size_t size, int32_t value, const char *unit);
+static bool stepArrow(flowLane_t *lane, int32_t power);
+static bool drawArrow(flowLane_t *lane);
+static void clearLane(flowLane_t *lane);
+static void setScrollStart(int16_t offset);
+static void drawPageFrame(TFT_eSPI *gfx, uint8_t active);
+static void drawDashboardLayer(TFT_eSPI *gfx);
+static void drawHistoryLayer(TFT_eSPI *gfx);
+static void drawLogLayer(TFT_eSPI *gfx);
+static void drawSettingsLayer(TFT_eSPI *gfx);
+static void drawText(TFT_eSPI *gfx, const char *text, int x, int y, int textSize, int font);
+static void drawHouse(TFT_eSPI *gfx, int x, int y);
+static void drawPylon(TFT_eSPI *gfx, int x, int y);
+static void drawSun(TFT_eSPI *gfx, int x, int y);
+static void drawWaterTank(TFT_eSPI *gfx, int x, int y);
+
+typedef struct {
+    pageDraw_t drawLayer;                   // Static layer, drawn once into the page cache
+    void (*show)(void);                     // Live content, drawn over the static layer
+    uint8_t (*dirty)(pageRect_t *rects);    // Where the live content is on the screen now
+} page_t;
+
+static const page_t pages[PAGE_COUNT] = {
+    {drawDashboardLayer, showDashboard, dashboardDirty},
+    {drawHistoryLayer, showHistory, historyDirty},
+    {drawLogLayer, showLog, logDirty},
+    {drawSettingsLayer, showSettings, settingsDirty}
+};
+
+// Width of the text last drawn in each field of the other pages, as valueField_t
+static int16_t totalWidths[2];
+static int16_t logWidths[maxEntries];
+static int16_t settingsWidths[2];
+
+
+/**
+ * @brief Create the sprites used by the animations and log area. CPU only, so it can run
+ * while the logo DMA is in progress.
+ * 
+ */
+void createSprites(void) {
+    logSprite.createSprite(270, 75);
+    logSprite.fillSprite(TFT_BACKGROUND);
+
+    if (!powerChart.begin(CHART_SAMPLES_PER_COLUMN))
+        Serial.println("Failed to create the power chart sprite");
+
+    // Sprites for animations
+    lineSprite.createSprite(LANE_WIDTH, 1);
+    rightArrowSprite.createSprite(ARROW_TRAIL + ARROW_WIDTH, LANE_HEIGHT);
+    leftArrowSprite.createSprite(ARROW_WIDTH + ARROW_TRAIL, LANE_HEIGHT);
+    fillFrameSprite.createSprite(ARROW_WIDTH, LANE_HEIGHT);
+    lineSprite.fillSprite(TFT_BACKGROUND);
+    rightArrowSprite.fillSprite(TFT_BACKGROUND);
+    leftArrowSprite.fillSprite(TFT_BACKGROUND);
+    fillFrameSprite.fillSprite(TFT_BACKGROUND);
+
+    lineSprite.drawLine(0, 0, 95, 0, TFT_LIGHTGREY);
+
+    // The line behind each arrow clears where it was, however far it moved
+    rightArrowSprite.fillTriangle(ARROW_TRAIL + 11, 10, ARROW_TRAIL + 1, 0, ARROW_TRAIL + 1, 20, TFT_GREEN_ENERGY);  // > small right pointing sideways triangle
+    rightArrowSprite.drawFastHLine(0, 10, ARROW_TRAIL + 1, TFT_LIGHTGREY);
+
+    leftArrowSprite.fillTriangle(0, 10, 10, 0, 10, 20, TFT_RED);  // < small left pointing sideways triangle
+    leftArrowSprite.drawFastHLine(11, 10, ARROW_TRAIL + 1, TFT_LIGHTGREY);
+
+    fillFrameSprite.drawLine(0, 10, 11, 10, TFT_LIGHTGREY);
+}
+
+/**
+ * @brief Map the font partition and load the value fonts into their sprites. The fonts
+ * stay loaded so the glyph metrics are parsed once at boot, not on every draw.
+ * 
+ * @return true Smooth fonts available
+ * @return false Use the built-in fonts
+ */
+bool loadSmoothFonts(void) {
+    const uint8_t *valueFont;
+    const uint8_t *totalFont;
+
+    if (!fontPartitionBegin())
+        return false;
+
+    valueFont = fontPartitionFind(VALUE_FONT);
+    totalFont = fontPartitionFind(TOTAL_FONT);
+    if (valueFont == NULL || totalFont == NULL) {
+        Serial.println("Value fonts missing from font partition");
+        return false;
+    }
+
+    valueSprite.loadFont(valueFont);
+    totalSprite.loadFont(totalFont);
+
+    if (valueSprite.createSprite(VALUE_SPRITE_WIDTH, valueSprite.gFont.yAdvance) == NULL ||
+        totalSprite.createSprite(TOTAL_SPRITE_WIDTH, totalSprite.gFont.yAdvance) == NULL) {
+        Serial.println("Failed to create value sprites");
+        valueSprite.unloadFont();
+        totalSprite.unloadFont();
+        valueSprite.deleteSprite();
+        totalSprite.deleteSprite();
+        return false;
+    }
+
+    valueSprite.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+    totalSprite.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+
+    valueGlyphs.build(&valueSprite, VALUE_GLYPHS);
+    totalGlyphs.build(&totalSprite, VALUE_GLYPHS);
+
+    return true;
+}
+
+/**
+ * @brief Draw the static layer of every page into the page cache. CPU only, so it can run
+ * while the logo DMA is in progress. A page that doesn't fit, or without PSRAM would leave
+ * less than PAGE_CACHE_RESERVE of internal RAM, is drawn from primitives each time it is
+ * shown instead.
+ * 
+ * @return true All pages cached
+ */
+bool createPages(void) {
+    size_t bytes = 0;
+    bool ok = true;
+
+    for (uint8_t p = 0; p < PAGE_COUNT; p++) {
+        if (!pageCache.capture(p, pages[p].drawLayer)) {
+            Serial.printf("Not caching the %s page, not enough memory\n", pageNames[p]);
+            ok = false;
+        }
+        bytes += pageCache.size(p);
+    }
+    Serial.printf("Page cache %u bytes, largest free internal block %u bytes\n", (unsigned)bytes,
+        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    return ok;
+}
+
+/**
+ * @brief Set up the screen. This will be called at program startup and when the screen
+ * saver ends.  The whole of the current page's static layer (background, tabs, house,
+ * sun, pylon, hot water tank etc.) is restored from the page cache and its live content
+ * drawn over it.
+ */
+void initialiseScreen(void) {
+    SPI_PROFILE("initialiseScreen");
+
+    if (pageCache.cached(page))
+        pageCache.restore(page, PAGE_NONE, NULL, 0);
+    else
+        pages[page].drawLayer(&tft);
+
+    pages[page].show();
+}
+
+/**
+ * @brief Switch to another page. Only the pixels of the new page's static layer that
+ * differ from the old page's, or where the old page's live content is, are sent before
+ * the new page draws its live content. Ignored while the screen saver is running.
+ * 
+ * @param newPage PAGE_xxx
+ * @return uint32_t Time taken in us, 0 if the page wasn't changed
+ */
+uint32_t showPage(uint8_t newPage) {
+    SPI_PROFILE("showPage");
+    int64_t start = esp_timer_get_time();
+    uint8_t from = page;
+
+    if (newPage >= PAGE_COUNT || newPage == page || screenSaverActive)
+        return 0;
+
+    page = newPage;
+    if (pageCache.cached(page)) {
+        pageRect_t dirty[PAGE_DIRTY_MAX];
+        pageCache.restore(page, from, dirty, pages[from].dirty(dirty));
+    }
+    else
+        pages[page].drawLayer(&tft);
+
+    pages[page].show();
+
+    return (uint32_t)(esp_timer_get_time() - start);
+}
+
+/**
+ * @brief The page on the screen, or that will be when the screen saver ends.
+ * 
+ * @return uint8_t PAGE_xxx
+ */
+uint8_t currentPage(void) {
+    return page;
+}
+
+/**
+ * @brief Add the values on the screen to the power chart, called every CHART_SAMPLE_PERIOD.
+ * Only the new column is drawn, and only on the pages that show the chart. While the
+ * screen saver is running the chart is kept up to date but not pushed.
+ * 
+ */
+void chartSample(void) {
+    SPI_PROFILE("chartSample");
+    bool rescaled = powerChart.addSample(shown.solarPower, shown.gridPower, shown.waterPower);
+
+    if (screenSaverActive)
+        return;
+
+    if (page == PAGE_DASHBOARD) {
+        if (rescaled)
+            drawChartRange(CHART_X, CHART_Y);
+        powerChart.pushLatest(CHART_X, CHART_Y);
+    } else if (page == PAGE_HISTORY) {
+        if (rescaled)
+            drawChartRange(HISTORY_CHART_X, HISTORY_CHART_Y);
+        powerChart.pushLatest(HISTORY_CHART_X, HISTORY_CHART_Y);
+    }
+}
+
+/**
+ * @brief Show a telemetry snapshot, only the changed fields are redrawn. The flow
+ * animation lanes follow the power values. While the screen saver is running, or another
+ * page is shown, the values are kept and drawn when the dashboard is next shown.
+ * 
+ * @param values Snapshot from telemetryTake()
+ * @param changed TELEMETRY_xxx bits of the fields that changed
+ */
+void showTelemetry(const telemetry_t *values, uint32_t changed) {
+    SPI_PROFILE("showTelemetry");
+    bool wasGenerating = solarGeneration;
+    bool wasImporting = gridImport;
+    bool wasExporting = gridExport;
+    bool wasHeating = waterHeating;
+
+    if (changed == 0)
+        return;
+
+    shown = *values;
+    solarGeneration = shown.solarPower > 0;
+    gridImport = shown.gridPower > 0;
+    gridExport = shown.gridPower < 0;
+    waterHeating = shown.waterPower > 0;
+
+    if (screenSaverActive)
+        return;
+
+    if (page == PAGE_HISTORY && (changed & TELEMETRY_ENERGY))
+        showTotals();
+    if (page != PAGE_DASHBOARD)
+        return;
+
+    // Clear the arrow left behind by a lane that has stopped or changed direction
+    if (wasGenerating && !solarGeneration)
+        clearLane(&sunLane);
+    if (gridImport != wasImporting || gridExport != wasExporting) {
+        clearLane(&gridImportLane);
+        gridExportLane.visible = false;
+    }
+    if (wasHeating && !waterHeating)
+        clearLane(&waterLane);
+
+    drawTelemetry(changed);
+}
+
+/**
+ * @brief Draw a live value such as "2.34 kW". With smooth fonts the text is rendered
+ * anti-aliased into a sprite and only the used width is pushed, one address window per
+ * value. Without them the built-in font for the field is used. Either way what is left of
+ * a longer value is cleared.
+ * 
+ * @param field Where and how to draw the value
+ * @param text Value to draw
+ */
+void drawValue(valueField_t *field, const char *text) {
+    SPI_PROFILE("drawValue");
+    if (!smoothFonts) {
+        showMessage(text, field->x, field->y, field->textSize, field->font);
+
+        // Clear what is left of a longer value
+        int16_t width = tft.getCursorX() - field->x;
+        if (width < field->lastWidth)
+            tft.fillRect(field->x + width, field->y, field->lastWidth - width, valueHeight(field), TFT_BACKGROUND);
+        field->lastWidth = width;
+        return;
+    }
+
+    SpiProfiledSprite *sprite = field->total ? &totalSprite : &valueSprite;
+    HotGlyphCache *glyphs = field->total ? &totalGlyphs : &valueGlyphs;
+    int16_t width = min((int)glyphs->textWidth(text), (int)sprite->width());
+    int16_t pushWidth = max(width, field->lastWidth);
+
+    sprite->fillRect(0, 0, pushWidth, sprite->height(), TFT_BACKGROUND);
+    sprite->setCursor(0, 0);
+    sprite->print(text);
+    sprite->pushSprite(field->x, field->y, 0, 0, pushWidth, sprite->height());
+
+    field->lastWidth = width;
+}
+
+/**
+ * @brief Time drawing the five live values at their widest, with the smooth fonts if they
+ * are loaded and with the built-in fonts, to show at boot what the smooth fonts cost in a
+ * frame. Call with the dashboard up, the values being shown are drawn again afterwards.
+ *
+ * @param smoothTime Set to the µs taken with the smooth fonts, 0 if they aren't loaded
+ * @param builtInTime Set to the µs taken with the built-in fonts
+ */
+void timeValues(uint32_t *smoothTime, uint32_t *builtInTime) {
+    valueField_t *fields[] = {&solarNowField, &gridNowField, &solarTodayField, &waterNowField, &waterTodayField};
+    const uint8_t count = sizeof(fields) / sizeof(fields[0]);
+    bool smooth = smoothFonts;
+    int64_t start;
+
+    *smoothTime = 0;
+    for (uint8_t pass = smooth ? 0 : 1; pass < 2; pass++) {
+        smoothFonts = pass == 0;
+        start = esp_timer_get_time();
+        for (uint8_t i = 0; i < count; i++)
+            drawValue(fields[i], fields[i]->total ? "-888.88 kWh" : "-88.88 kW");
+        *(pass == 0 ? smoothTime : builtInTime) = (uint32_t)(esp_timer_get_time() - start);
+
+        for (uint8_t i = 0; i < count; i++) {
+            tft.fillRect(fields[i]->x, fields[i]->y, fields[i]->lastWidth, valueHeight(fields[i]), TFT_BACKGROUND);
+            fields[i]->lastWidth = 0;
+        }
+    }
+
+    smoothFonts = smooth;
+    drawTelemetry(TELEMETRY_POWER | TELEMETRY_ENERGY);
+}
+
+/**
+ * @brief Are any of the flow animation lanes running? They only run on the dashboard.
+ * 
+ */
+bool animationActive(void) {
+    return page == PAGE_DASHBOARD && (solarGeneration || gridImport || gridExport || waterHeating);
+}
+
+/**
+ * @brief Move the arrows that show the flow of electricity on by a tick, without drawing.
+ * Solar generation, water tank heating, grid import or export. Each arrow moves at a
+ * speed in proportion to its power, in fixed point, and only needs drawing when it
+ * reaches the next pixel. The display task only takes the bus when this returns true.
+ * 
+ * @return true An arrow needs drawing, call animationDraw()
+ */
+bool animationStep(void) {
+    bool due = false;
+
+    if (solarGeneration)
+        due |= stepArrow(&sunLane, shown.solarPower);
+    if (gridImport)
+        due |= stepArrow(&gridImportLane, shown.gridPower);
+    if (gridExport)
+        due |= stepArrow(&gridExportLane, shown.gridPower);
+    if (waterHeating)
+        due |= stepArrow(&waterLane, shown.waterPower);
+
+    return due;
+}
+
+/**
+ * @brief Draw the arrows the last animationStep() moved to another pixel, or off the end.
+ * 
+ * @return true Something was drawn
+ */
+bool animationDraw(void) {
+    SPI_PROFILE("animation");
+    bool drawn = false;
+
+    if (solarGeneration)
+        drawn |= drawArrow(&sunLane);
+    if (gridImport)
+        drawn |= drawArrow(&gridImportLane);
+    if (gridExport)
+        drawn |= drawArrow(&gridExportLane);
+    if (waterHeating)
+        drawn |= drawArrow(&waterLane);
+
+    return drawn;
+}
+
+/**
+ * @brief Step and draw the flow animation, for code that draws every tick anyway.
+ * 
+ * @return true Something was drawn, false no arrow reached the next pixel this tick
+ */
+bool animation(void) {
+    return animationStep() && animationDraw();
+}
+
+/**
+ * @brief Matrix style screen saver.
+ * 
+ */
+void matrix(void) {
+    SPI_PROFILE("matrix");
+    uint8_t batch[MAX_COL * 2];     // Column and new character chance for each column
+    uint8_t age[MAX_CHR];
+
+    matrixRandom.fill(batch, sizeof(batch));
+
+    for (int j = 0; j < MAX_COL; j++) {
+        int column = 1 + FastRandom::scale(batch[j * 2], MAX_COL - 1);
+        uint8_t *cells = matrixCells[column];
+        uint8_t chars = charHead[column];
+        uint8_t fades = fadeHead[column];
+        int x = column * COL_WIDTH;
+
+        // Brightness from the bottom up, counting ticks since the last bright head
+        for (int i = MAX_CHR - 1, cell = (fades + i) % MAX_CHR; i >= 0; i--, cell = cell ? cell - 1 : MAX_CHR - 1) {
+            if (cells[cell] & MATRIX_HEAD)
+                age[i] = 0;
+            else if (i == MAX_CHR - 1)
+                age[i] = bottomAge[column];
+            else
+                age[i] = min(age[i + 1] + 1, (int)sizeof(matrixFade));
+        }
+
+        for (int i = 0, cell = chars; i < MAX_CHR; i++, cell = cell + 1 < MAX_CHR ? cell + 1 : 0) {
+            uint8_t level = age[i] < sizeof(matrixFade) ? matrixFade[age[i]] : 0;
+            tft.setTextColor(level == MATRIX_BRIGHT ? TFT_DARKGREY : level << 5, TFT_BLACK);
+
+            if ((cells[cell] & MATRIX_CHAR) == 0 || level == MATRIX_BRIGHT) {
+                uint8_t c = matrixRandom.between(31, 128);
+                cells[cell] = (cells[cell] & MATRIX_HEAD) | c;
+
+                if (i > 1) {    // and the two above
+                    int above = (cell + MAX_CHR - 1) % MAX_CHR;
+                    cells[above] = (cells[above] & MATRIX_HEAD) | c;
+                    above = (cell + MAX_CHR - 2) % MAX_CHR;
+                    cells[above] = (cells[above] & MATRIX_HEAD) | c;
+                }
+            }
+
+            tft.drawChar(cells[cell] & MATRIX_CHAR, x, (i + 1) * LINE_HEIGHT, 1);
+        }
+
+        // Characters up a line, the bottom one stays and the top is picked next time
+        uint8_t bottom = cells[(chars + MAX_CHR - 1) % MAX_CHR] & MATRIX_CHAR;
+        cells[chars] = (cells[chars] & MATRIX_HEAD) | bottom;
+        chars = (chars + 1) % MAX_CHR;
+        cells[chars] &= MATRIX_HEAD;
+        charHead[column] = chars;
+
+        // Brightness down a line, ~1 in 20 chance of a new bright character at the top
+        bottomAge[column] = age[MAX_CHR - 2];
+        fades = (fades + MAX_CHR - 1) % MAX_CHR;
+        cells[fades] &= MATRIX_CHAR;
+        if ((FastRandom::scale(batch[j * 2 + 1], 20) == 1) && (j < MAX_COL_DOT6))     // MAX_COL * 0.6
+            cells[fades] |= MATRIX_HEAD;
+        fadeHead[column] = fades;
+    }
+}
+
+/**
+ * @brief Seed the matrix screen saver's random numbers, a fixed seed draws the same
+ * frames every time.
+ * 
+ * @param seed Any value, esp_random() on the ESP32
+ */
+void matrixSeed(uint32_t seed) {
+    matrixRandom.seed(seed);
+}
+
+/**
+ * @brief Start/setup the screen saver.  Will be started by the user touching the screen
+ * or after 'n' minutes of inactivity to save the screen from burn-in.
+ */
+void startScreenSaver(void) {
+    SPI_PROFILE("startScreenSaver");
+    stopPixelShift();
+    screenSaverActive = true;
+            
+    tft.fillScreen(TFT_BLACK);
+
+    // Every column starts with a bright head at the top
+    memset(matrixCells, 0, sizeof(matrixCells));
+    for (int j = 0; j < MAX_COL; j++) {
+        charHead[j] = 0;
+        fadeHead[j] = 0;
+        bottomAge[j] = sizeof(matrixFade);
+        matrixCells[j][0] = MATRIX_HEAD;
+    }
+}
+
+/**
+ * @brief Start the pixel shift screen saver.  The dashboard stays up and keeps updating,
+ * the panel's vertical scroll moves the whole picture a pixel every PIXEL_SHIFT_PERIOD
+ * instead.  Nothing is redrawn, a move is 3 bytes on the bus.
+ * 
+ */
+void startPixelShift(void) {
+    SPI_PROFILE("startPixelShift");
+    if (shifting)
+        return;
+
+    // The whole panel is the scroll area, no fixed areas top or bottom
+    tft.startWrite();
+    tft.writecommand(0x33);     // VSCRDEF
+    tft.writedata(0);
+    tft.writedata(0);
+    tft.writedata(TFT_HEIGHT >> 8);
+    tft.writedata(TFT_HEIGHT & 0xFF);
+    tft.writedata(0);
+    tft.writedata(0);
+    tft.endWrite();
+
+    shifting = true;
+    shiftStep = 0;
+}
+
+/**
+ * @brief Move the picture on a pixel, out to PIXEL_SHIFT_RANGE one way, back and out
+ * the other way.
+ * 
+ */
+void pixelShift(void) {
+    SPI_PROFILE("pixelShift");
+    if (!shifting)
+        return;
+
+    shiftStep = (shiftStep + 1) % (PIXEL_SHIFT_RANGE * 4);
+
+    int16_t offset = shiftStep;                         // 0 .. 15 for a range of 4
+    if (offset > PIXEL_SHIFT_RANGE * 3)
+        offset -= PIXEL_SHIFT_RANGE * 4;                // -3 .. -1
+    else if (offset > PIXEL_SHIFT_RANGE)
+        offset = PIXEL_SHIFT_RANGE * 2 - offset;        // 3 .. -4
+
+    setScrollStart(offset);
+}
+
+/**
+ * @brief Put the picture back where it belongs, nothing has to be redrawn.
+ * 
+ */
+void stopPixelShift(void) {
+    SPI_PROFILE("stopPixelShift");
+    if (!shifting)
+        return;
+
+    setScrollStart(0);
+    shifting = false;
+}
+
+bool pixelShifting(void) {
+    return shifting;
+}
+
+/**
+ * @brief Show a message on the screen, mainly used for time, date and mainly fixed
+ * information that does not change a lot (except the time obviously!).
+ * 
+ * @param msg String to write to the display
+ * @param x Pixel location horizontal
+ * @param y Pixel location vertical
+ * @param textSize Text size to use
+ * @param font Default font to use, 1, 2 etc.
+ */
+void showMessage(String msg, int x, int y, int textSize, int font) {
+    SPI_PROFILE("showMessage");
+    tft.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+    tft.setCursor(x, y, font);   // position and font
+    tft.setTextSize(textSize);
+    tft.print(msg);
+}
+
+/**
+ * @brief Write cLog logging to the log screen area on the dashboard, or the log page.
+ * 
+ */
+void updateLog(const char *msg) {
+    SPI_PROFILE("updateLog");
+    int y = 3; // top of log area
+
+    // Add time to message then add to CLOG
+    CLOG(myLog1.add(), "18:12:32 %s", msg);
+
+    logSprite.fillSprite(TFT_BACKGROUND);
+    logSprite.setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+    logSprite.setTextFont(0);
+    for (uint8_t i = 0; i < myLog1.numEntries; i++, y+=10) {
+        logSprite.setCursor(5, y);
+        logSprite.print(myLog1.get(i));
+    }
+
+    if (screenSaverActive)
+        return;
+
+    if (page == PAGE_DASHBOARD)
+        logSprite.pushSprite(211, 246);
+    else if (page == PAGE_LOG)
+        drawLogLines();
+}
+
+/**
+ * @brief Draw the dashboard's live content: values, chart and log area.
+ * 
+ */
+static void showDashboard(void) {
+    sunLane.visible = false;            // static layer has just been restored
+    gridImportLane.visible = false;
+    gridExportLane.visible = false;
+    waterLane.visible = false;
+    solarNowField.lastWidth = 0;
+    gridNowField.lastWidth = 0;
+    solarTodayField.lastWidth = 0;
+    waterNowField.lastWidth = 0;
+    waterTodayField.lastWidth = 0;
+
+    // The log area is blank in the static layer, only its text needs sending
+    for (uint8_t i = 0; i < myLog1.numEntries; i++)
+        logSprite.pushSprite(216, 249 + i * 10, 5, 3 + i * 10, logSprite.textWidth(myLog1.get(i), 1), 8);
+
+    drawTelemetry(TELEMETRY_ALL);
+    drawChartRange(CHART_X, CHART_Y);
+    powerChart.push(CHART_X, CHART_Y);
+}
+
+/**
+ * @brief Draw the history page's live content: the chart and today's totals.
+ * 
+ */
+static void showHistory(void) {
+    memset(totalWidths, 0, sizeof(totalWidths));     // static layer has just been restored
+    drawChartRange(HISTORY_CHART_X, HISTORY_CHART_Y);
+    powerChart.push(HISTORY_CHART_X, HISTORY_CHART_Y);
+    showTotals();
+}
+
+/**
+ * @brief Draw the log page's live content, the log entries full width.
+ * 
+ */
+static void showLog(void) {
+    memset(logWidths, 0, sizeof(logWidths));
+    drawLogLines();
+}
+
+/**
+ * @brief Draw the settings that are only known at run time.
+ * 
+ */
+static void showSettings(void) {
+    char text[48];
+    size_t bytes = 0;
+
+    memset(settingsWidths, 0, sizeof(settingsWidths));
+    for (uint8_t p = 0; p < PAGE_COUNT; p++)
+        bytes += pageCache.size(p);
+
+    snprintf(text, sizeof(text), "Smooth fonts: %s", smoothFonts ? "loaded" : "built-in fallback");
+    showField(text, LOG_PAGE_X, SETTINGS_INFO_Y, 2, &settingsWidths[0]);
+    snprintf(text, sizeof(text), "Page cache: %u bytes", (unsigned)bytes);
+    showField(text, LOG_PAGE_X, SETTINGS_INFO_Y + LOG_PAGE_LINE, 2, &settingsWidths[1]);
+}
+
+/**
+ * @brief Draw today's totals on the history page.
+ * 
+ */
+static void showTotals(void) {
+    char text[24];
+
+    formatKilo(text, sizeof(text), shown.solarEnergy, "kWh");
+    showField(text, HISTORY_TOTAL_X, 90, 4, &totalWidths[0]);
+    formatKilo(text, sizeof(text), shown.waterEnergy, "kWh");
+    showField(text, HISTORY_TOTAL_X, 150, 4, &totalWidths[1]);
+}
+
+/**
+ * @brief Draw the log entries on the log page, one to a line.
+ * 
+ */
+static void drawLogLines(void) {
+    for (uint8_t i = 0; i < maxEntries; i++)
+        showField(i < myLog1.numEntries ? myLog1.get(i) : "", LOG_PAGE_X, LOG_PAGE_Y + i * LOG_PAGE_LINE, 2, &logWidths[i]);
+}
+
+/**
+ * @brief Show a message and clear what is left of the last one, so a shorter message
+ * leaves nothing of a longer one behind.
+ * 
+ * @param lastWidth Width of the last message, updated
+ */
+static void showField(const char *text, int x, int y, int font, int16_t *lastWidth) {
+    showMessage(text, x, y, 1, font);
+
+    int16_t width = tft.getCursorX() - x;
+    if (width < *lastWidth)
+        tft.fillRect(x + width, y, *lastWidth - width, tft.fontHeight(font), TFT_BACKGROUND);
+    *lastWidth = width;
+}
+
+/**
+ * @brief Where the dashboard's live content is: the values, flow arrows, chart,
+ * the text in the log area and the sender status.
+ * 
+ * @param rects Filled in, room for PAGE_DIRTY_MAX
+ * @return uint8_t Number of rects
+ */
+static uint8_t dashboardDirty(pageRect_t *rects) {
+    valueField_t *fields[] = {&solarNowField, &gridNowField, &solarTodayField, &waterNowField, &waterTodayField};
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        rects[count++] = {(int16_t)fields[i]->x, (int16_t)fields[i]->y, fields[i]->lastWidth, valueHeight(fields[i])};
+
+    flowLane_t *lanes[] = {&sunLane, &gridImportLane, &gridExportLane, &waterLane};
+    for (uint8_t i = 0; i < sizeof(lanes) / sizeof(lanes[0]); i++) {
+        if (lanes[i]->visible)
+            rects[count++] = {lanes[i]->drawn, (int16_t)lanes[i]->y, ARROW_WIDTH, LANE_HEIGHT};
+    }
+
+    rects[count++] = {CHART_X, CHART_Y - 10, 36, 8};        // range, "nn kW "
+    rects[count++] = {CHART_X, CHART_Y, CHART_WIDTH, CHART_HEIGHT};
+
+    for (uint8_t i = 0; i < myLog1.numEntries; i++)
+        rects[count++] = {216, (int16_t)(249 + i * 10), logSprite.textWidth(myLog1.get(i), 1), 8};
+
+    rects[count++] = {5, 288, 160, 16};         // Sender battery
+    rects[count++] = {160, 310, 60, 8};         // LQI
+
+    return count;
+}
+
+static uint8_t historyDirty(pageRect_t *rects) {
+    rects[0] = {HISTORY_CHART_X, HISTORY_CHART_Y - 10, 36, 8};
+    rects[1] = {HISTORY_CHART_X, HISTORY_CHART_Y, CHART_WIDTH, CHART_HEIGHT};
+    rects[2] = {HISTORY_TOTAL_X, 90, totalWidths[0], 26};
+    rects[3] = {HISTORY_TOTAL_X, 150, totalWidths[1], 26};
+
+    return 4;
+}
+
+static uint8_t logDirty(pageRect_t *rects) {
+    for (uint8_t i = 0; i < maxEntries; i++)
+        rects[i] = {LOG_PAGE_X, (int16_t)(LOG_PAGE_Y + i * LOG_PAGE_LINE), logWidths[i], 16};
+
+    return maxEntries;
+}
+
+static uint8_t settingsDirty(pageRect_t *rects) {
+    rects[0] = {LOG_PAGE_X, SETTINGS_INFO_Y, settingsWidths[0], 16};
+    rects[1] = {LOG_PAGE_X, SETTINGS_INFO_Y + LOG_PAGE_LINE, settingsWidths[1], 16};
+
+    return 2;
+}
+
+/**
+ * @brief Height of a live value on the screen.
+ * 
+ */
+static int16_t valueHeight(valueField_t *field) {
+    if (smoothFonts)
+        return field->total ? totalSprite.height() : valueSprite.height();
+
+    return tft.fontHeight(field->font) * field->textSize;
+}
+
+/**
+ * @brief Draw the given fields of the values on the screen.
+ * 
+ * @param fields TELEMETRY_xxx bits
+ */
+static void drawTelemetry(uint32_t fields) {
+    char text[24];
+
+    if (fields & TELEMETRY_SOLAR_POWER) {
+        formatKilo(text, sizeof(text), shown.solarPower, "kW");
+        drawValue(&solarNowField, text);        // Solar generation now
+    }
+    if (fields & TELEMETRY_GRID_POWER) {
+        formatKilo(text, sizeof(text), abs(shown.gridPower), "kW");
+        drawValue(&gridNowField, text);         // Electricity import/export, the arrows show which
+    }
+    if (fields & TELEMETRY_SOLAR_ENERGY) {
+        formatKilo(text, sizeof(text), shown.solarEnergy, "kWh");
+        drawValue(&solarTodayField, text);      // Total solar generated today
+    }
+    if (fields & TELEMETRY_WATER_POWER) {
+        formatKilo(text, sizeof(text), shown.waterPower, "kW");
+        drawValue(&waterNowField, text);        // Power into the water tank
+    }
+    if (fields & TELEMETRY_WATER_ENERGY) {
+        formatKilo(text, sizeof(text), shown.waterEnergy, "kWh");
+        drawValue(&waterTodayField, text);      // Total saved today to heat water
+    }
+    if (fields & TELEMETRY_BATTERY) {
+        snprintf(text, sizeof(text), "Sender Battery: %-3s", shown.batteryOk ? "OK" : "LOW");
+        showMessage(text, 5, 288, 1, 2);
+    }
+    if (fields & TELEMETRY_LQI) {
+        snprintf(text, sizeof(text), "LQI: %-3u", (unsigned)shown.lqi);
+        showMessage(text, 160, 310, 0, 1);
+    }
+}
+
+/**
+ * @brief Label the top of the power chart with its range.
+ * 
+ * @param x Left of the chart
+ * @param y Top of the chart
+ */
+static void drawChartRange(int x, int y) {
+    char text[16];
+
+    snprintf(text, sizeof(text), "%d kW ", (int)(powerChart.getRange() / 1000));
+    showMessage(text, x, y - 10, 1, 1);
+}
+
+/**
+ * @brief Format watts (or watt hours) as kilo with two decimals, e.g. "2.34 kW".
+ * 
+ */
+static void formatKilo(char *text, size_t size, int32_t value, const char *unit) {
+    const char *sign = value < 0 ? "-" : "";
+
+    value = abs(value);
+    snprintf(text, size, "%s%d.%02d %s", sign, (int)(value / 1000), (int)(value % 1000 / 10), unit);
+}
+
+/**
+ * @brief Move a lane's arrow on by one tick at the speed for the power, and note whether
+ * it has reached another pixel or run off the end.
+ * 
+ * @param lane Lane to move
+ * @param power W flowing, the sign is ignored
+ * @return true The lane needs drawing
+ */
+static bool stepArrow(flowLane_t *lane, int32_t power) {
+    int32_t speed = constrain(abs(power) * ARROW_SPEED_PER_KW / 1000, ARROW_MIN_SPEED, ARROW_MAX_STEP << ARROW_FRACTION_BITS);
+    int16_t x;
+
+    lane->position += lane->left ? -speed : speed;
+    x = lane->position >> ARROW_FRACTION_BITS;
+
+    // Off the end of the lane, start again from the other end once the arrow is cleared
+    if (x < lane->x || x > lane->x + width) {
+        lane->position = (lane->left ? lane->x + width : lane->x) << ARROW_FRACTION_BITS;
+        lane->pending = lane->visible ? ARROW_CLEAR : ARROW_NONE;
+    } else {
+        lane->pending = lane->visible && x == lane->drawn ? ARROW_NONE : ARROW_MOVE;
+    }
+
+    return lane->pending != ARROW_NONE;
+}
+
+/**
+ * @brief Draw what the last stepArrow() left to do in a lane. The sprite is pushed with as
+ * much of the line behind the arrow as it moved, so where it was is cleared in the same window.
+ * 
+ * @param lane Lane to draw
+ * @return true Drawn
+ */
+static bool drawArrow(flowLane_t *lane) {
+    int16_t x = lane->position >> ARROW_FRACTION_BITS;
+    int16_t moved;
+    uint8_t pending = lane->pending;
+
+    lane->pending = ARROW_NONE;
+    if (pending == ARROW_CLEAR && lane->visible) {
+        fillFrameSprite.pushSprite(lane->drawn, lane->y);
+        lane->visible = false;
+        return true;
+    }
+    if (pending != ARROW_MOVE || (lane->visible && x == lane->drawn))
+        return false;
+
+    moved = lane->visible ? abs(x - lane->drawn) : 1;
+    if (lane->left)
+        leftArrowSprite.pushSprite(x, lane->y, 0, 0, ARROW_WIDTH + moved - 1, LANE_HEIGHT);
+    else
+        rightArrowSprite.pushSprite(x - moved + 1, lane->y, ARROW_TRAIL - moved + 1, 0, ARROW_WIDTH + moved - 1, LANE_HEIGHT);
+
+    lane->drawn = x;
+    lane->visible = true;
+
+    return true;
+}
+
+/**
+ * @brief Clear a flow animation lane back to its line.
+ * 
+ * @param lane Lane to clear
+ */
+static void clearLane(flowLane_t *lane) {
+    tft.fillRect(lane->x, lane->y, lineSprite.width(), fillFrameSprite.height(), TFT_BACKGROUND);
+    lineSprite.pushSprite(lane->x, lane->y + 10);
+    lane->visible = false;
+}
+
+/**
+ * @brief Set the first line of frame memory the panel shows.  The panel's lines run
+ * across the screen in landscape, so this moves the picture left (positive) or right.
+ * 
+ * @param offset Pixels, -PIXEL_SHIFT_RANGE to PIXEL_SHIFT_RANGE
+ */
+static void setScrollStart(int16_t offset) {
+    uint16_t line = offset < 0 ? TFT_HEIGHT + offset : offset;
+
+    tft.startWrite();
+    tft.writecommand(0x37);     // VSCRSADD
+    tft.writedata(line >> 8);
+    tft.writedata(line & 0xFF);
+    tft.endWrite();
+}
+
+/**
+ * @brief Background and the tabs along the top, common to every page.
+ * 
+ * @param gfx Screen or page cache band to draw on
+ * @param active Page whose tab opens on to the page
+ */
+static void drawPageFrame(TFT_eSPI *gfx, uint8_t active) {
+    gfx->fillRect(0, 0, tft.width(), tft.height(), TFT_BACKGROUND);
+
+    // Define area at top of screen for the tabs
+    gfx->fillRect(0, 20, 480, 2, TFT_BLACK);
+    gfx->fillRect(0, 0, 480, 20, TFT_SKYBLUE);
+
+    gfx->setTextSize(1);
+    for (uint8_t p = 0; p < PAGE_COUNT; p++) {
+        int x = p * PAGE_TAB_WIDTH;
+
+        if (p == active) {
+            gfx->fillRect(x, 0, PAGE_TAB_WIDTH, PAGE_TAB_HEIGHT, TFT_BACKGROUND);
+            gfx->setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+        } else {
+            gfx->setTextColor(TFT_BLACK, TFT_SKYBLUE);
+        }
+        if (p > 0)
+            gfx->drawFastVLine(x, 0, 20, TFT_BLACK);
+
+        gfx->setCursor(x + (PAGE_TAB_WIDTH - gfx->textWidth(pageNames[p], 2)) / 2, 2, 2);
+        gfx->print(pageNames[p]);
+    }
+}
+
+/**
+ * @brief Static layer of the dashboard.
+ * 
+ */
+static void drawDashboardLayer(TFT_eSPI *gfx) {
+    drawPageFrame(gfx, PAGE_DASHBOARD);
+
+    // Define message area at the bottom
+    gfx->drawLine(0, 245, 480, 245, TFT_FOREGROUND);
+    gfx->drawLine(210, 245, 210, 320, TFT_FOREGROUND);
+
+    drawSun(gfx, 65, 145);
+    drawHouse(gfx, 210, 130);
+    drawPylon(gfx, 380, 130);
+    drawWaterTank(gfx, 213, 160);
+
+    // Flow animation lanes
+    gfx->drawFastHLine(sunX, sunY+10, LANE_WIDTH, TFT_LIGHTGREY);
+    gfx->drawFastHLine(gridX, gridY+10, LANE_WIDTH, TFT_LIGHTGREY);
+    gfx->drawFastHLine(waterX, waterY+10, LANE_WIDTH, TFT_LIGHTGREY);
+
+    drawText(gfx, "13:43:23", 5, 250, 1, 2);
+    drawText(gfx, "Sun 17 Mar 24", 110, 250, 1, 2);
+
+    drawText(gfx, "Water Tank: Heating by solar", 5, 270, 1, 2);
+
+    drawText(gfx, "IP: 192.168.5.67", 5, 310, 0, 1);
+}
+
+/**
+ * @brief Static layer of the history page, the chart's frame, legend and labels.
+ * 
+ */
+static void drawHistoryLayer(TFT_eSPI *gfx) {
+    static const char *series[] = {"Solar", "Grid", "Water"};
+    static const uint16_t colours[] = {TFT_YELLOW, TFT_RED, TFT_SKYBLUE};
+    char text[40];
+
+    drawPageFrame(gfx, PAGE_HISTORY);
+
+    snprintf(text, sizeof(text), "Power, last %u minutes",
+        (unsigned)(CHART_WIDTH * CHART_SAMPLES_PER_COLUMN * (CHART_SAMPLE_PERIOD / 1000) / 60));
+    drawText(gfx, text, HISTORY_CHART_X, 35, 1, 2);
+    gfx->drawRect(HISTORY_CHART_X - 1, HISTORY_CHART_Y - 1, CHART_WIDTH + 2, CHART_HEIGHT + 2, TFT_GREY);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        int x = HISTORY_CHART_X + i * 65;
+
+        gfx->fillRect(x, HISTORY_CHART_Y + CHART_HEIGHT + 16, 8, 8, colours[i]);
+        drawText(gfx, series[i], x + 12, HISTORY_CHART_Y + CHART_HEIGHT + 12, 1, 2);
+    }
+
+    drawText(gfx, "Solar today", HISTORY_TOTAL_X, 70, 1, 2);
+    drawText(gfx, "Water heating today", HISTORY_TOTAL_X, 130, 1, 2);
+}
+
+/**
+ * @brief Static layer of the log page.
+ * 
+ */
+static void drawLogLayer(TFT_eSPI *gfx) {
+    drawPageFrame(gfx, PAGE_LOG);
+
+    gfx->drawRect(LOG_PAGE_X - 5, LOG_PAGE_Y - 5, LOG_PAGE_WIDTH + 10, maxEntries * LOG_PAGE_LINE + 5, TFT_GREY);
+}
+
+/**
+ * @brief Static layer of the settings page. Read only for now, it shows how the monitor
+ * is set up and used.
+ * 
+ */
+static void drawSettingsLayer(TFT_eSPI *gfx) {
+    char text[48];
+
+    drawPageFrame(gfx, PAGE_SETTINGS);
+
+    gfx->setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+    gfx->setCursor(75, 40, 1);
+    gfx->setTextSize(2);
+    gfx->print("House Electricity Monitor v3");
+
+    drawText(gfx, "Swipe left or right, or tap a tab, to change page", LOG_PAGE_X, 80, 1, 2);
+    drawText(gfx, "Tap the screen to start or stop the screen saver", LOG_PAGE_X, 80 + LOG_PAGE_LINE, 1, 2);
+    drawText(gfx, "Long press for task stats on Serial", LOG_PAGE_X, 80 + 2 * LOG_PAGE_LINE, 1, 2);
+    snprintf(text, sizeof(text), "Chart: a sample every %u s, %u to a column",
+        (unsigned)(CHART_SAMPLE_PERIOD / 1000), (unsigned)CHART_SAMPLES_PER_COLUMN);
+    drawText(gfx, text, LOG_PAGE_X, 80 + 3 * LOG_PAGE_LINE, 1, 2);
+}
+
+/**
+ * @brief Fixed text on a static layer, as showMessage() but on any gfx.
+ * 
+ */
+static void drawText(TFT_eSPI *gfx, const char *text, int x, int y, int textSize, int font) {
+    gfx->setTextColor(TFT_FOREGROUND, TFT_BACKGROUND);
+    gfx->setCursor(x, y, font);
+    gfx->setTextSize(textSize);
+    gfx->print(text);
+}
+
+/**
+ * @brief Draw a house where xy is the bottom left of the house
+ * 
+ * @param x Bottom left x of house
+ * @param y Bottom left y of house
+ */
+static void drawHouse(TFT_eSPI *gfx, int x, int y) {
+    gfx->drawLine(x, y, x+36, y, TFT_FOREGROUND);      // Bottom
+    gfx->drawLine(x, y, x, y-30, TFT_FOREGROUND);      // Left wall
+    gfx->drawLine(x+36, y, x+36, y-30, TFT_FOREGROUND);      // Right wall
+    gfx->drawLine(x-2, y-28, x+18, y-45, TFT_FOREGROUND);      // Left angled roof
+    gfx->drawLine(x+38, y-28, x+18, y-45, TFT_FOREGROUND);      // Right angled roof
+
+    gfx->drawRect(x+5, y-28, 8, 8, TFT_FOREGROUND);   // Left top window
+    gfx->drawRect(x+23, y-28, 8, 8, TFT_FOREGROUND);   // Right top window
+   
+    gfx->drawRect(x+15, y-13, 8, 13, TFT_FOREGROUND);   // Door
+}
+
+/**
+ * @brief Draw an electricity pylon
+ * 
+ * @param x Bottom left x position of pylon
+ * @param y Bottom left y position of pylon
+ */
+static void drawPylon(TFT_eSPI *gfx, int x, int y) {
+    gfx->drawLine(x, y, x+5, y-25, TFT_FOREGROUND);      // left foot
+    gfx->drawLine(x+5, y-25, x+5, y-40, TFT_FOREGROUND);      // left straight
+    gfx->drawLine(x+5, y-40, x+10, y-50, TFT_FOREGROUND);      // left top angle
+
+    gfx->drawLine(x+20, y, x+15, y-25, TFT_FOREGROUND);      // right foot
+    gfx->drawLine(x+15, y-25, x+15, y-40, TFT_FOREGROUND);      // right straight
+    gfx->drawLine(x+15, y-40, x+10, y-50, TFT_FOREGROUND);      // right top angle
+
+    // lines across starting at bottom
+    gfx->drawLine(x+1, y-5, x+19, y-5, TFT_FOREGROUND);      
+    gfx->drawLine(x+3, y-15, x+18, y-15, TFT_FOREGROUND);  
+
+    gfx->drawLine(x-5, y-25, x+25, y-25, TFT_FOREGROUND);    // bottom wider line across
+    gfx->drawLine(x+5, y-30, x+15, y-30, TFT_FOREGROUND);
+    gfx->drawLine(x-5, y-25, x+5, y-30, TFT_FOREGROUND);    // angle left
+    gfx->drawLine(x+25, y-25, x+15, y-30, TFT_FOREGROUND);    // angle right
+
+    gfx->drawLine(x-5, y-35, x+25, y-35, TFT_FOREGROUND);    // top wider line across
+    gfx->drawLine(x+5, y-40, x+15, y-40, TFT_FOREGROUND);
+    gfx->drawLine(x-5, y-35, x+5, y-40, TFT_FOREGROUND);    // angle left
+    gfx->drawLine(x+25, y-35, x+15, y-40, TFT_FOREGROUND);    // angle right
+
+    // cross sections starting at bottom
+    gfx->drawLine(x+3, y-5, x+18, y-15, TFT_FOREGROUND);
+    gfx->drawLine(x+18, y-5, x+3, y-15, TFT_FOREGROUND);
+
+    gfx->drawLine(x+3, y-15, x+15, y-25, TFT_FOREGROUND);
+    gfx->drawLine(x+18, y-15, x+5, y-25, TFT_FOREGROUND);
+
+    gfx->drawLine(x+5, y-25, x+15, y-30, TFT_FOREGROUND);
+    gfx->drawLine(x+15, y-25, x+5, y-30, TFT_FOREGROUND);
+
+    gfx->drawLine(x+5, y-30, x+15, y-35, TFT_FOREGROUND);
+    gfx->drawLine(x+15, y-30, x+5, y-35, TFT_FOREGROUND);
+
+    gfx->drawLine(x+5, y-35, x+15, y-40, TFT_FOREGROUND);
+    gfx->drawLine(x+15, y-35, x+5, y-40, TFT_FOREGROUND);
+
+    // dots at end of pylon
+    gfx->drawLine(x-5, y-34, x-5, y-33, TFT_FOREGROUND); // top left
+    gfx->drawLine(x+25, y-34, x+25, y-33, TFT_FOREGROUND); // top right
+    gfx->drawLine(x-5, y-24, x-5, y-23, TFT_FOREGROUND); // bottom left
+    gfx->drawLine(x+25, y-24, x+25, y-23, TFT_FOREGROUND); // bottom right
+}
+
+/**
+ * @brief Display the sun
+ * 
+ * @param x Display x coordinates
+ * @param y Display y coordinates
+ */
+static void drawSun(TFT_eSPI *gfx, int x, int y) {
+    int scale = 12;  // 6
+
+    int linesize = 3;
+    int dxo, dyo, dxi, dyi;
+
+    gfx->fillCircle(x, y, scale, TFT_RED);
+
+    for (float i = 0; i < 360; i = i + 45) {
+        dxo = 2.2 * scale * cos((i - 90) * 3.14 / 180);
+        dxi = dxo * 0.6;
+        dyo = 2.2 * scale * sin((i - 90) * 3.14 / 180);
+        dyi = dyo * 0.6;
+        if (i == 0 || i == 180) {
+            gfx->drawLine(dxo + x - 1, dyo + y, dxi + x - 1, dyi + y, TFT_RED);
+            gfx->drawLine(dxo + x + 0, dyo + y, dxi + x + 0, dyi + y, TFT_RED);
+            gfx->drawLine(dxo + x + 1, dyo + y, dxi + x + 1, dyi + y, TFT_RED);
+        }
+        if (i == 90 || i == 270) {
+            gfx->drawLine(dxo + x, dyo + y - 1, dxi + x, dyi + y - 1, TFT_RED);
+            gfx->drawLine(dxo + x, dyo + y + 0, dxi + x, dyi + y + 0, TFT_RED);
+            gfx->drawLine(dxo + x, dyo + y + 1, dxi + x, dyi + y + 1, TFT_RED);
+        }
+        if (i == 45 || i == 135 || i == 225 || i == 315) {
+            gfx->drawLine(dxo + x - 1, dyo + y, dxi + x - 1, dyi + y, TFT_RED);
+            gfx->drawLine(dxo + x + 0, dyo + y, dxi + x + 0, dyi + y, TFT_RED);
+            gfx->drawLine(dxo + x + 1, dyo + y, dxi + x + 1, dyi + y, TFT_RED);
+        }
+    }
+}
+
+static void drawWaterTank(TFT_eSPI *gfx, int x, int y) {
+//350, 160
+    gfx->drawRoundRect(x, y, 22, 33, 6, TFT_FOREGROUND);
+    gfx->fillRoundRect(x+1, y+1, 20, 31, 6, TFT_WATERTANK_HOT);
+
+    // shower hose
+    gfx->drawLine(x+11, y, x+11, y-5, TFT_FOREGROUND);
+    gfx->drawLine(x+11, y-5, x+35, y-5, TFT_FOREGROUND);
+    gfx->drawLine(x+35, y-5, x+35, y+5, TFT_FOREGROUND);
+    gfx->drawLine(x+30, y+6, x+40, y+6, TFT_FOREGROUND);
+    gfx->drawLine(x+31, y+7, x+39, y+7, TFT_FOREGROUND);
+
+    // water
+    gfx->drawLine(x+31, y+8, x+27, y+15, TFT_WATERTANK_HOT); // left
+    gfx->drawLine(x+33, y+8, x+30, y+15, TFT_WATERTANK_HOT); // left
+
+    gfx->drawLine(x+35, y+8, x+35, y+15, TFT_WATERTANK_HOT); // middle
+
+    gfx->drawLine(x+37, y+8, x+39, y+15, TFT_WATERTANK_HOT); // right
+    gfx->drawLine(x+39, y+8, x+42, y+15, TFT_WATERTANK_HOT); // right
+}
@@ -0,0 +1,160 @@
+/*
+    SPI bus arbitration, see spiBus.h
+*/
+
+#include "esp_timer.h"
+#include "spiBus.h"
+
+typedef struct {
+    uint32_t acquired;          // Times the bus was acquired
+    uint32_t deferred;          // Times a gap client was held back for a reservation
+    int64_t holdTime;           // µs the bus was held, transfers and the client's CPU work
+    int64_t waitTime;           // µs spent waiting to acquire the bus
+    int64_t maxWait;            // Longest single wait (µs)
+} spiClientStats_t;
+
+static const spiClientConfig_t *busClients = NULL;
+static SemaphoreHandle_t busMutex = NULL;
+static EventGroupHandle_t busReleased = NULL;      // Bit n set when client n releases the bus
+static portMUX_TYPE reservationLock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t reservedAt[SPI_CLIENT_COUNT];   // Behind reservationLock, a 64 bit access isn't atomic on the Xtensa
+static int64_t holdStart[SPI_CLIENT_COUNT];
+static spiClientStats_t busStats[SPI_CLIENT_COUNT];
+static int64_t statsStart = 0;
+
+static int reservationBefore(spiClient_t client, int64_t until);
+
+/**
+ * @brief Set up the bus manager.
+ * 
+ * @param clients Array of SPI_CLIENT_COUNT client configurations, must stay valid
+ * @return true OK
+ */
+bool spiBusBegin(const spiClientConfig_t *clients) {
+    busClients = clients;
+    busMutex = xSemaphoreCreateMutex();
+    busReleased = xEventGroupCreate();
+    statsStart = esp_timer_get_time();
+
+    return busMutex != NULL && busReleased != NULL;
+}
+
+/**
+ * @brief Wait for and take the bus. A client with a gapTime also waits for any reservation
+ * it would overlap, for at most SPI_BUS_MAX_DEFER.
+ * 
+ * @param client Client wanting the bus
+ */
+void spiBusAcquire(spiClient_t client) {
+    int64_t start = esp_timer_get_time();
+    int64_t now, wait;
+    int other;
+
+    xSemaphoreTake(busMutex, portMAX_DELAY);
+
+    if (busClients[client].gapTime != 0) {
+        for ( ;; ) {
+            now = esp_timer_get_time();
+            other = reservationBefore(client, now + busClients[client].gapTime);
+            if (other < 0 || now - start >= SPI_BUS_MAX_DEFER)
+                break;
+
+            // Let the reserving client have the bus first
+            busStats[client].deferred++;
+            xEventGroupClearBits(busReleased, 1 << other);
+            xSemaphoreGive(busMutex);
+            wait = SPI_BUS_MAX_DEFER - (now - start);
+            xEventGroupWaitBits(busReleased, 1 << other, pdTRUE, pdFALSE, pdMS_TO_TICKS(wait / 1000) + 1);
+            xSemaphoreTake(busMutex, portMAX_DELAY);
+        }
+    }
+
+    now = esp_timer_get_time();
+    spiBusReserve(client, 0);   // had our turn
+    holdStart[client] = now;
+    busStats[client].acquired++;
+    busStats[client].waitTime += now - start;
+    if (now - start > busStats[client].maxWait)
+        busStats[client].maxWait = now - start;
+
+    if (busClients[client].begin != NULL)
+        busClients[client].begin();
+}
+
+/**
+ * @brief Give the bus back.
+ * 
+ * @param client Client holding the bus
+ */
+void spiBusRelease(spiClient_t client) {
+    if (busClients[client].end != NULL)
+        busClients[client].end();
+
+    busStats[client].holdTime += esp_timer_get_time() - holdStart[client];
+    xSemaphoreGive(busMutex);
+    xEventGroupSetBits(busReleased, 1 << client);
+}
+
+/**
+ * @brief Tell the bus manager when the client will next want the bus, gap clients will
+ * keep out of the way.
+ * 
+ * @param client Client making the reservation
+ * @param at esp_timer_get_time() time the bus is wanted, 0 for no reservation
+ */
+void spiBusReserve(spiClient_t client, int64_t at) {
+    taskENTER_CRITICAL(&reservationLock);
+    reservedAt[client] = at;
+    taskEXIT_CRITICAL(&reservationLock);
+}
+
+/**
+ * @brief Print the time the bus was held and per client statistics since the last report.
+ * 
+ * @param out Where to print, e.g. Serial
+ */
+void spiBusReport(Print &out) {
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - statsStart;
+    int64_t held = 0;
+
+    if (elapsed <= 0)
+        return;
+
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++)
+        held += busStats[i].holdTime;
+
+    out.printf("SPI bus: held %u.%u%% of the time, transfers and the holder's CPU work\n", (unsigned)(held * 100 / elapsed),
+        (unsigned)(held * 1000 / elapsed) % 10);
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++) {
+        spiClientStats_t *stats = &busStats[i];
+
+        out.printf("  %-8s %6u uses, held %u.%u%%, wait avg %u us max %u us, deferred %u\n", busClients[i].name,
+            (unsigned)stats->acquired, (unsigned)(stats->holdTime * 100 / elapsed), (unsigned)(stats->holdTime * 1000 / elapsed) % 10,
+            (unsigned)(stats->acquired ? stats->waitTime / stats->acquired : 0), (unsigned)stats->maxWait, (unsigned)stats->deferred);
+        memset(stats, 0, sizeof(spiClientStats_t));
+    }
+
+    statsStart = now;
+}
+
+/**
+ * @brief Find another client with a reservation before the given time which it hasn't
+ * taken up yet.
+ * 
+ * @return int Client number, -1 if none
+ */
+static int reservationBefore(spiClient_t client, int64_t until) {
+    int found = -1;
+
+    taskENTER_CRITICAL(&reservationLock);
+    for (int i = 0; i < SPI_CLIENT_COUNT; i++) {
+        if (i != client && reservedAt[i] != 0 && reservedAt[i] < until) {
+            found = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&reservationLock);
+
+    return found;
+}
@@ -0,0 +1,291 @@
+/*
+    Per-frame SPI profiler, see spiProfiler.h.
+*/
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "spiProfiler.h"
+
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 27000000      // Normally set by the TFT_eSPI user setup
+#endif
+
+#define SPI_PROFILE_DEPTH 8         // Deepest nesting of sites
+
+static TFT_eSPI *profiledTft = NULL;
+static spiProfileSite_t sites[SPI_PROFILE_SITES];
+static uint8_t siteCount = 0;
+static uint32_t overflows = 0;      // Calls from sites that didn't fit in sites[]
+static uint32_t countedWindows = 0; // Sent through SpiProfiledTFT and SpiProfiledSprite
+static uint32_t countedPixels = 0;
+
+static int8_t siteStack[SPI_PROFILE_DEPTH];
+static uint8_t depth = 0;
+static spiProfileCounters_t mark;   // Counters when the current site was last charged
+
+static spiProfileFrame_t frames[SPI_PROFILE_HISTORY];
+static uint32_t frameCount = 0;
+static bool frameDrawn = false;     // A site was entered during the current frame
+static spiProfileCounters_t frameTotal;
+static spiProfileCounters_t frameMax;
+static spiProfileCounters_t frameCurrent;
+
+static void readCounters(spiProfileCounters_t *counters);
+static int8_t currentSite(void);
+static void charge(int8_t site);
+static void addCounters(spiProfileCounters_t *total, const spiProfileCounters_t *add);
+static void maxCounters(spiProfileCounters_t *peak, const spiProfileCounters_t *value);
+static uint32_t busTime(uint64_t bytes);
+static void printCounters(Print &out, const char *name, uint32_t calls, const spiProfileCounters_t *counters);
+
+
+/**
+ * @brief Start profiling the given panel.
+ *
+ * @param tft Panel the screen code draws on
+ */
+void spiProfilerBegin(TFT_eSPI *tft) {
+    profiledTft = tft;
+    spiProfileReset();
+}
+
+/**
+ * @brief Clear all sites and frames.
+ */
+void spiProfileReset(void) {
+    memset(sites, 0, sizeof(sites));
+    siteCount = 0;
+    overflows = 0;
+    depth = 0;
+    frameCount = 0;
+    frameDrawn = false;
+    memset(&frameTotal, 0, sizeof(frameTotal));
+    memset(&frameMax, 0, sizeof(frameMax));
+    memset(&frameCurrent, 0, sizeof(frameCurrent));
+    readCounters(&mark);
+}
+
+/**
+ * @brief Charge what was drawn since the last call to the current site and make the
+ * given site current.
+ *
+ * @param site Call site name, a string literal
+ */
+void spiProfileEnter(const char *site) {
+    int8_t index;
+
+    if (profiledTft == NULL)
+        return;
+
+    charge(currentSite());
+
+    for (index = 0; index < siteCount; index++) {
+        if (sites[index].name == site || strcmp(sites[index].name, site) == 0)
+            break;
+    }
+    if (index == siteCount) {
+        if (siteCount < SPI_PROFILE_SITES) {
+            sites[siteCount++].name = site;
+        } else {
+            overflows++;
+            index = -1;
+        }
+    }
+
+    if (index >= 0)
+        sites[index].calls++;
+    if (depth < SPI_PROFILE_DEPTH)
+        siteStack[depth] = index;
+    depth++;
+    frameDrawn = true;
+}
+
+/**
+ * @brief Charge what was drawn since the last call to the current site and return to
+ * the site that entered it.
+ */
+void spiProfileLeave(void) {
+    if (profiledTft == NULL || depth == 0)
+        return;
+
+    charge(currentSite());
+    depth--;
+}
+
+/**
+ * @brief Close the current frame. Frames where no site was entered are not counted.
+ */
+void spiProfileFrameEnd(void) {
+    spiProfileFrame_t *frame;
+
+    if (profiledTft == NULL)
+        return;
+
+    charge(currentSite());
+    if (!frameDrawn)
+        return;
+
+    frame = &frames[frameCount % SPI_PROFILE_HISTORY];
+    frame->number = frameCount++;
+    frame->total = frameCurrent;
+
+    addCounters(&frameTotal, &frameCurrent);
+    maxCounters(&frameMax, &frameCurrent);
+    memset(&frameCurrent, 0, sizeof(frameCurrent));
+    frameDrawn = false;
+}
+
+/**
+ * @brief Count windows and pixels sent to the panel, called by SpiProfiledTFT and
+ * SpiProfiledSprite on the ESP32.
+ *
+ * @param windows Address windows set
+ * @param pixels Pixels sent
+ */
+void spiProfileCount(uint32_t windows, uint32_t pixels) {
+    countedWindows += windows;
+    countedPixels += pixels;
+}
+
+/**
+ * @brief Print the sites, most bus traffic (or time if there are no SPI counts) first,
+ * and the frame averages and maxima. Call spiProfileReset() to start a new period.
+ *
+ * @param out Where to print, e.g. Serial or a file on the host
+ * @param listFrames Also list the last SPI_PROFILE_HISTORY frames
+ */
+void spiProfileReport(Print &out, bool listFrames) {
+    uint8_t order[SPI_PROFILE_SITES];
+    spiProfileCounters_t average;
+
+    if (profiledTft == NULL)
+        return;
+
+    for (uint8_t i = 0; i < siteCount; i++)
+        order[i] = i;
+    for (uint8_t i = 1; i < siteCount; i++) {
+        for (uint8_t j = i; j > 0; j--) {
+            spiProfileCounters_t *a = &sites[order[j - 1]].total;
+            spiProfileCounters_t *b = &sites[order[j]].total;
+            if (a->bytes > b->bytes || (a->bytes == b->bytes && a->time >= b->time))
+                break;
+            uint8_t swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+
+#ifdef HOST_SIM
+    out.printf("SPI profile, %u frames at %u MHz\n", (unsigned)frameCount, (unsigned)(SPI_FREQUENCY / 1000000));
+#else
+    out.printf("SPI profile, %u frames at %u MHz, counts estimated from the calls\n", (unsigned)frameCount, (unsigned)(SPI_FREQUENCY / 1000000));
+#endif
+    out.printf("  %-16s %7s %8s %9s %9s %9s\n", "site", "calls", "windows", "pixels", "bus us", "time us");
+    for (uint8_t i = 0; i < siteCount; i++)
+        printCounters(out, sites[order[i]].name, sites[order[i]].calls, &sites[order[i]].total);
+    if (overflows)
+        out.printf("  %u calls from sites that did not fit, raise SPI_PROFILE_SITES\n", (unsigned)overflows);
+
+    if (frameCount > 0) {
+        average.windows = frameTotal.windows / frameCount;
+        average.pixels = frameTotal.pixels / frameCount;
+        average.bytes = frameTotal.bytes / frameCount;
+        average.time = frameTotal.time / frameCount;
+        printCounters(out, "frame average", frameCount, &average);
+        printCounters(out, "frame max", frameCount, &frameMax);
+    }
+
+    if (listFrames) {
+        uint32_t first = frameCount > SPI_PROFILE_HISTORY ? frameCount - SPI_PROFILE_HISTORY : 0;
+        char name[16];
+
+        for (uint32_t n = first; n < frameCount; n++) {
+            spiProfileFrame_t *frame = &frames[n % SPI_PROFILE_HISTORY];
+            snprintf(name, sizeof(name), "frame %u", (unsigned)frame->number);
+            printCounters(out, name, 1, &frame->total);
+        }
+    }
+}
+
+/**
+ * @brief Read the panel's counters, the host emulator's own or on the ESP32 those counted
+ * by SpiProfiledTFT and SpiProfiledSprite.
+ */
+static void readCounters(spiProfileCounters_t *counters) {
+    memset(counters, 0, sizeof(spiProfileCounters_t));
+    counters->time = esp_timer_get_time();
+
+#ifdef HOST_SIM
+    if (profiledTft != NULL) {
+        const hostSpiStats_t &stats = profiledTft->totalStats();
+        counters->windows = stats.windows;
+        counters->pixels = stats.pixels;
+        counters->bytes = stats.bytes;
+    }
+#else
+    counters->windows = countedWindows;
+    counters->pixels = countedPixels;
+    counters->bytes = (uint64_t)countedWindows * SPI_PROFILE_WINDOW_BYTES + (uint64_t)countedPixels * SPI_PROFILE_PIXEL_BYTES;
+#endif
+}
+
+/**
+ * @brief Index of the innermost site, -1 if there is none or it didn't fit.
+ */
+static int8_t currentSite(void) {
+    if (depth == 0 || depth > SPI_PROFILE_DEPTH)
+        return -1;
+
+    return siteStack[depth - 1];
+}
+
+/**
+ * @brief Charge the counters since the last mark to a site and the current frame. The
+ * frame gets all SPI traffic (e.g. the startWrite() holding the bus for the frame) but
+ * only time spent in sites, not the time the display task was asleep.
+ *
+ * @param site Index into sites[], -1 if no site is current
+ */
+static void charge(int8_t site) {
+    spiProfileCounters_t now;
+    spiProfileCounters_t delta;
+
+    readCounters(&now);
+    delta.windows = now.windows - mark.windows;
+    delta.pixels = now.pixels - mark.pixels;
+    delta.bytes = now.bytes - mark.bytes;
+    delta.time = depth > 0 ? now.time - mark.time : 0;
+    mark = now;
+
+    if (site >= 0)
+        addCounters(&sites[site].total, &delta);
+    addCounters(&frameCurrent, &delta);
+}
+
+static void addCounters(spiProfileCounters_t *total, const spiProfileCounters_t *add) {
+    total->windows += add->windows;
+    total->pixels += add->pixels;
+    total->bytes += add->bytes;
+    total->time += add->time;
+}
+
+static void maxCounters(spiProfileCounters_t *peak, const spiProfileCounters_t *value) {
+    peak->windows = max(peak->windows, value->windows);
+    peak->pixels = max(peak->pixels, value->pixels);
+    peak->bytes = max(peak->bytes, value->bytes);
+    peak->time = max(peak->time, value->time);
+}
+
+/**
+ * @brief Time to clock the bytes out at SPI_FREQUENCY.
+ *
+ * @return uint32_t µs
+ */
+static uint32_t busTime(uint64_t bytes) {
+    return (uint32_t)(bytes * 8 * 1000000 / SPI_FREQUENCY);
+}
+
+static void printCounters(Print &out, const char *name, uint32_t calls, const spiProfileCounters_t *counters) {
+    out.printf("  %-16s %7u %8u %9u %9u %9u\n", name, (unsigned)calls, (unsigned)counters->windows,
+        (unsigned)counters->pixels, (unsigned)busTime(counters->bytes), (unsigned)counters->time);
+}
@@ -0,0 +1,214 @@
+/*
+    FreeRTOS run time statistics, see taskStats.h.
+*/
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "taskStats.h"
+
+#if !configGENERATE_RUN_TIME_STATS
+#include "esp_freertos_hooks.h"
+#endif
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t runTime;               // ulRunTimeCounter at the last report
+} taskRunTime_t;
+
+static TaskStatus_t tasks[TASK_STATS_MAX];
+static uint32_t taskRunTime[TASK_STATS_MAX];    // Run time of tasks[i] since the last report
+static uint8_t order[TASK_STATS_MAX];
+static taskRunTime_t lastRunTime[TASK_STATS_MAX];
+static UBaseType_t lastCount = 0;
+static uint32_t lastTotalRunTime = 0;
+
+#if !configGENERATE_RUN_TIME_STATS
+static int64_t idleLastCall[portNUM_PROCESSORS];
+static uint64_t idleTotal[portNUM_PROCESSORS];    // Time spent in each core's idle task (us)
+static uint64_t lastIdleTotal[portNUM_PROCESSORS];
+static int64_t lastReportTime = 0;
+static bool idleHooked = false;
+static portMUX_TYPE idleLock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool idleHook(int core);
+static bool idleHook0(void);
+static bool idleHook1(void);
+#endif
+
+static uint32_t previousRunTime(TaskHandle_t handle);
+
+
+/**
+ * @brief Start measuring the load on each core when FreeRTOS doesn't keep run time
+ * stats. Call once before the first report.
+ *
+ * @return true Load measured, always with configGENERATE_RUN_TIME_STATS
+ */
+bool taskStatsBegin(void) {
+#if configGENERATE_RUN_TIME_STATS
+    return true;
+#else
+    esp_freertos_idle_cb_t hooks[2] = {idleHook0, idleHook1};
+
+    lastReportTime = esp_timer_get_time();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        idleLastCall[core] = lastReportTime;
+        if (esp_register_freertos_idle_hook_for_cpu(hooks[core], core) != ESP_OK)
+            return false;
+    }
+    idleHooked = true;
+
+    return true;
+#endif
+}
+
+
+/**
+ * @brief Print every task, busiest first, with its core, priority, CPU use since the
+ * last report and the least stack it has had free, then the load on each core. Without
+ * configGENERATE_RUN_TIME_STATS the tasks are in the order FreeRTOS lists them.
+ *
+ * @param out Where to print, e.g. Serial
+ */
+void taskStatsReport(Print &out) {
+    UBaseType_t count;
+    uint32_t totalRunTime = 0;
+    uint32_t elapsed;
+    uint32_t idleTime[portNUM_PROCESSORS];
+    bool idleSeen[portNUM_PROCESSORS];
+
+    count = uxTaskGetSystemState(tasks, TASK_STATS_MAX, &totalRunTime);
+    if (count == 0) {
+        out.printf("Task stats: %u tasks, raise TASK_STATS_MAX\n", (unsigned)uxTaskGetNumberOfTasks());
+        return;
+    }
+
+    elapsed = totalRunTime - lastTotalRunTime;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        idleTime[core] = 0;
+        idleSeen[core] = false;
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        taskRunTime[i] = tasks[i].ulRunTimeCounter - previousRunTime(tasks[i].xHandle);
+        order[i] = i;
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            if (tasks[i].xHandle == xTaskGetIdleTaskHandleForCPU(core)) {
+                idleTime[core] = taskRunTime[i];
+                idleSeen[core] = true;
+            }
+        }
+    }
+
+    // Busiest first
+    for (UBaseType_t i = 1; i < count; i++) {
+        for (UBaseType_t j = i; j > 0 && taskRunTime[order[j - 1]] < taskRunTime[order[j]]; j--) {
+            uint8_t swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+
+    out.printf("Tasks: %u\n", (unsigned)count);
+    out.printf("  %-16s %4s %4s %6s %6s\n", "task", "core", "prio", "cpu %", "stack");
+    for (UBaseType_t n = 0; n < count; n++) {
+        TaskStatus_t *task = &tasks[order[n]];
+        char core[4] = "-";
+
+#if configTASKLIST_INCLUDE_COREID
+        if (task->xCoreID != tskNO_AFFINITY)
+            snprintf(core, sizeof(core), "%d", (int)task->xCoreID);
+#endif
+
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t permille = elapsed ? (uint32_t)((uint64_t)taskRunTime[order[n]] * 1000 / elapsed) : 0;
+        out.printf("  %-16s %4s %4u %4u.%u %6u\n", task->pcTaskName, core, (unsigned)task->uxCurrentPriority,
+            (unsigned)(permille / 10), (unsigned)(permille % 10), (unsigned)task->usStackHighWaterMark);
+#else
+        out.printf("  %-16s %4s %4u %6s %6u\n", task->pcTaskName, core, (unsigned)task->uxCurrentPriority,
+            "-", (unsigned)task->usStackHighWaterMark);
+#endif
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (!idleSeen[core] || elapsed == 0)
+            continue;
+
+        uint32_t idle = (uint32_t)min((uint64_t)idleTime[core] * 1000 / elapsed, (uint64_t)1000);
+        out.printf("  core %d load %u.%u%%\n", core, (unsigned)((1000 - idle) / 10), (unsigned)((1000 - idle) % 10));
+    }
+#else
+    int64_t now = esp_timer_get_time();
+    uint64_t period = now - lastReportTime;
+
+    for (int core = 0; core < portNUM_PROCESSORS && period > 0 && idleHooked; core++) {
+        uint64_t idleNow;
+
+        taskENTER_CRITICAL(&idleLock);
+        idleNow = idleTotal[core];
+        taskEXIT_CRITICAL(&idleLock);
+
+        uint32_t idle = (uint32_t)min((idleNow - lastIdleTotal[core]) * 1000 / period, (uint64_t)1000);
+        out.printf("  core %d load %u.%u%%, from its idle hook\n", core, (unsigned)((1000 - idle) / 10),
+            (unsigned)((1000 - idle) % 10));
+        lastIdleTotal[core] = idleNow;
+    }
+    lastReportTime = now;
+#endif
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        lastRunTime[i].handle = tasks[i].xHandle;
+        lastRunTime[i].runTime = tasks[i].ulRunTimeCounter;
+    }
+    lastCount = count;
+    lastTotalRunTime = totalRunTime;
+}
+
+#if !configGENERATE_RUN_TIME_STATS
+/**
+ * @brief Add the time since the hook's last call on this core to its idle time, unless
+ * the gap was long enough for another task to have run.
+ *
+ * @return false Keep the idle task spinning, waiting for an interrupt would look like
+ * another task running
+ */
+static bool idleHook(int core) {
+    int64_t now = esp_timer_get_time();
+    int64_t gap = now - idleLastCall[core];
+
+    idleLastCall[core] = now;
+    if (gap <= TASK_STATS_IDLE_GAP) {
+        taskENTER_CRITICAL(&idleLock);
+        idleTotal[core] += gap;
+        taskEXIT_CRITICAL(&idleLock);
+    }
+
+    return false;
+}
+
+static bool idleHook0(void) {
+    return idleHook(0);
+}
+
+static bool idleHook1(void) {
+    return idleHook(1);
+}
+#endif
+
+/**
+ * @brief Run time counter of a task at the last report.
+ *
+ * @return uint32_t 0 if the task is new since then
+ */
+static uint32_t previousRunTime(TaskHandle_t handle) {
+    for (UBaseType_t i = 0; i < lastCount; i++) {
+        if (lastRunTime[i].handle == handle)
+            return lastRunTime[i].runTime;
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+    Telemetry channel, see telemetry.h.
+
+    The latest values are kept behind a seqlock.  A writer makes the sequence odd, stores
+    the fields and makes it even again, a reader copies the values and retries if the
+    sequence was odd or moved while it copied.  Readers never hold anything up, so a
+    producer on the other core is never kept waiting by a frame being drawn.  Producers
+    are serialised between themselves by writeLock, held only for the copy.
+
+    The values are stored as relaxed atomic words so the copy racing a writer is defined
+    behaviour, the sequence loads and stores order them.
+*/
+
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "telemetry.h"
+
+#define TELEMETRY_WORDS ((sizeof(telemetry_t) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
+static std::atomic<uint32_t> sequence(0);   // Odd while a writer is storing
+static std::atomic<uint32_t> latest[TELEMETRY_WORDS];  // Latest value of every field, a telemetry_t
+static std::atomic<uint32_t> pending(0);    // Fields published since the last snapshot
+static std::atomic<uint32_t> snapshots(0);  // Snapshots with changes since the last report
+static std::atomic<uint32_t> retries(0);    // Reads repeated because a writer was storing
+static uint32_t published = 0;          // Publishes since the last report, under writeLock
+static uint32_t coalesced = 0;          // Field values overwritten before the display saw them, under writeLock
+static void (*notifyDisplay)(void) = NULL;
+static portMUX_TYPE writeLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void readLatest(telemetry_t *values);
+static void copyFields(telemetry_t *to, const telemetry_t *from, uint32_t fields);
+
+
+/**
+ * @brief Set the function called when there is something new for the display.
+ *
+ * @param notify e.g. wakes the display task, may be NULL to poll telemetryTake()
+ */
+void telemetryBegin(void (*notify)(void)) {
+    notifyDisplay = notify;
+}
+
+/**
+ * @brief Publish readings, safe to call from any task. Never waits for a reader, only for
+ * another producer part way through a publish. Fields not in fields keep their last value.
+ *
+ * @param values New readings
+ * @param fields TELEMETRY_xxx bits of the fields in values
+ */
+void telemetryPublish(const telemetry_t *values, uint32_t fields) {
+    uint32_t words[TELEMETRY_WORDS];
+    uint32_t seq, before;
+    telemetry_t updated;
+
+    fields &= TELEMETRY_ALL;
+    if (fields == 0)
+        return;
+
+    taskENTER_CRITICAL(&writeLock);
+    for (size_t i = 0; i < TELEMETRY_WORDS; i++)
+        words[i] = latest[i].load(std::memory_order_relaxed);   // only writers change latest
+    memcpy(&updated, words, sizeof(updated));
+    copyFields(&updated, values, fields);
+    memcpy(words, &updated, sizeof(updated));
+
+    seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);        // odd before any word
+    for (size_t i = 0; i < TELEMETRY_WORDS; i++)
+        latest[i].store(words[i], std::memory_order_relaxed);
+    sequence.store(seq + 2, std::memory_order_release);         // every word before even
+
+    // After the values, so a snapshot that sees the bit also sees the value or a newer one
+    before = pending.fetch_or(fields, std::memory_order_release);
+    coalesced += __builtin_popcount(before & fields);
+    published++;
+    taskEXIT_CRITICAL(&writeLock);
+
+    if (before == 0 && notifyDisplay != NULL)
+        notifyDisplay();
+}
+
+/**
+ * @brief Take a snapshot of all the fields for the display, at most once a frame. Only
+ * the display task should take snapshots, other readers use telemetryRead().
+ *
+ * @param snapshot Filled in with the latest value of every field
+ * @return uint32_t TELEMETRY_xxx bits of the fields changed since the last snapshot, 0 if none
+ */
+uint32_t telemetryTake(telemetry_t *snapshot) {
+    uint32_t changed = pending.exchange(0, std::memory_order_acquire);
+
+    readLatest(snapshot);
+    if (changed)
+        snapshots++;
+
+    return changed;
+}
+
+/**
+ * @brief Read the latest value of every field without taking them from the display, safe
+ * from any task.
+ *
+ * @param values Filled in with a consistent copy
+ */
+void telemetryRead(telemetry_t *values) {
+    readLatest(values);
+}
+
+/**
+ * @brief Print the publishes and snapshots since the last report, how many field values
+ * were replaced before the display took them and how often a reader had to retry.
+ *
+ * @param out Where to print, e.g. Serial
+ */
+void telemetryReport(Print &out) {
+    uint32_t p, c;
+
+    taskENTER_CRITICAL(&writeLock);
+    p = published;
+    c = coalesced;
+    published = coalesced = 0;
+    taskEXIT_CRITICAL(&writeLock);
+
+    out.printf("Telemetry: %u publishes, %u snapshots, %u values coalesced, %u read retries\n", (unsigned)p,
+        (unsigned)snapshots.exchange(0), (unsigned)c, (unsigned)retries.exchange(0));
+}
+
+/**
+ * @brief Seqlock read of the latest values, retried until no writer was storing.
+ *
+ */
+static void readLatest(telemetry_t *values) {
+    uint32_t words[TELEMETRY_WORDS];
+    uint32_t seq;
+
+    for ( ;; ) {
+        seq = sequence.load(std::memory_order_acquire);
+        if ((seq & 1) == 0) {
+            for (size_t i = 0; i < TELEMETRY_WORDS; i++)
+                words[i] = latest[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);    // every word before the check
+            if (sequence.load(std::memory_order_relaxed) == seq)
+                break;
+        }
+        retries++;
+    }
+
+    memcpy(values, words, sizeof(telemetry_t));
+}
+
+/**
+ * @brief Copy the given fields.
+ *
+ */
+static void copyFields(telemetry_t *to, const telemetry_t *from, uint32_t fields) {
+    if (fields & TELEMETRY_SOLAR_POWER)
+        to->solarPower = from->solarPower;
+    if (fields & TELEMETRY_GRID_POWER)
+        to->gridPower = from->gridPower;
+    if (fields & TELEMETRY_WATER_POWER)
+        to->waterPower = from->waterPower;
+    if (fields & TELEMETRY_SOLAR_ENERGY)
+        to->solarEnergy = from->solarEnergy;
+    if (fields & TELEMETRY_WATER_ENERGY)
+        to->waterEnergy = from->waterEnergy;
+    if (fields & TELEMETRY_LQI)
+        to->lqi = from->lqi;
+    if (fields & TELEMETRY_BATTERY)
+        to->batteryOk = from->batteryOk;
+}
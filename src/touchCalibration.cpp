@@ -0,0 +1,163 @@
+/*
+    Touch screen calibration store, see touchCalibration.h
+*/
+
+#include <Preferences.h>
+#include "crc16.h"
+#include "touchCalibration.h"
+
+#if __has_include("touchCalBaked.h")
+#include "touchCalBaked.h"      // Generated by tools/cal2header.py, defines TOUCH_CAL_BAKED
+#endif
+
+static void drawMarker(TFT_eSPI *gfx, uint8_t corner, uint16_t color);
+
+/**
+ * @brief Load the calibration from NVS.
+ * 
+ * @param data Filled in with the calibration if valid
+ * @return true Valid calibration of the current version found
+ */
+bool touchCalLoad(uint16_t data[TOUCH_CAL_VALUES]) {
+    Preferences prefs;
+    touchCalRecord_t record;
+    size_t length;
+
+    if (!prefs.begin(TOUCH_CAL_NAMESPACE, true))
+        return false;   // namespace doesn't exist yet
+    length = prefs.getBytes(TOUCH_CAL_KEY, &record, sizeof(record));
+    prefs.end();
+
+    if (length != sizeof(record) || record.version != TOUCH_CAL_VERSION || record.crc != crc16(&record, offsetof(touchCalRecord_t, crc)))
+        return false;
+
+    memcpy(data, record.data, sizeof(record.data));
+    return true;
+}
+
+/**
+ * @brief Save the calibration to NVS.
+ * 
+ * @param data Calibration from touchCalRun() or TFT_eSPI::calibrateTouch()
+ * @return true Saved
+ */
+bool touchCalSave(const uint16_t data[TOUCH_CAL_VALUES]) {
+    Preferences prefs;
+    touchCalRecord_t record;
+    size_t length;
+
+    record.version = TOUCH_CAL_VERSION;
+    memcpy(record.data, data, sizeof(record.data));
+    record.crc = crc16(&record, offsetof(touchCalRecord_t, crc));
+
+    if (!prefs.begin(TOUCH_CAL_NAMESPACE, false))
+        return false;
+    length = prefs.putBytes(TOUCH_CAL_KEY, &record, sizeof(record));
+    prefs.end();
+
+    return length == sizeof(record);
+}
+
+/**
+ * @brief Calibration compiled into the firmware with tools/cal2header.py.
+ * 
+ * @param data Filled in with the calibration if there is one
+ * @return true Firmware has baked in calibration
+ */
+bool touchCalBaked(uint16_t data[TOUCH_CAL_VALUES]) {
+#ifdef TOUCH_CAL_BAKED
+    const uint16_t baked[TOUCH_CAL_VALUES] = TOUCH_CAL_BAKED;
+
+    memcpy(data, baked, sizeof(baked));
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Calibrate by asking the user to touch each corner, blocks until done. Produces
+ * the same values as TFT_eSPI::calibrateTouch() but reads the touch controller through
+ * readRaw, so it also works when the touch controller is not on TFT_eSPI's SPI bus.
+ * 
+ * @param gfx Display to draw the corner markers on
+ * @param readRaw Raw touch reader
+ * @param threshold Pressure threshold, corners are less sensitive so half is used
+ * @param data Filled in with the calibration for TFT_eSPI::setTouch()
+ */
+void touchCalRun(TFT_eSPI *gfx, touchCalReadRaw_t readRaw, uint16_t threshold, uint16_t data[TOUCH_CAL_VALUES]) {
+    int32_t values[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    uint16_t x, y;
+    int32_t x0, x1, y0, y1, swap;
+    bool rotate, invertX, invertY;
+
+    // Corners in the order top left, bottom left, top right, bottom right
+    for (uint8_t corner = 0; corner < 4; corner++) {
+        drawMarker(gfx, corner, TFT_MAGENTA);
+
+        for (uint8_t i = 0; i < TOUCH_CAL_SAMPLES; i++) {
+            while (!readRaw(&x, &y, threshold / 2))
+                delay(10);
+            values[corner * 2] += x;
+            values[corner * 2 + 1] += y;
+        }
+        values[corner * 2] /= TOUCH_CAL_SAMPLES;
+        values[corner * 2 + 1] /= TOUCH_CAL_SAMPLES;
+
+        drawMarker(gfx, corner, TFT_BLACK);
+        while (readRaw(&x, &y, threshold / 2))     // wait for the pen to be lifted
+            delay(10);
+        delay(300);
+    }
+
+    // Top left to bottom left changes y, if raw x changed most the panel is rotated
+    rotate = abs(values[0] - values[2]) > abs(values[1] - values[3]);
+    if (rotate) {
+        x0 = (values[1] + values[3]) / 2;
+        x1 = (values[5] + values[7]) / 2;
+        y0 = (values[0] + values[4]) / 2;
+        y1 = (values[2] + values[6]) / 2;
+    } else {
+        x0 = (values[0] + values[2]) / 2;
+        x1 = (values[4] + values[6]) / 2;
+        y0 = (values[1] + values[5]) / 2;
+        y1 = (values[3] + values[7]) / 2;
+    }
+
+    invertX = x0 > x1;
+    if (invertX) {
+        swap = x0;
+        x0 = x1;
+        x1 = swap;
+    }
+    invertY = y0 > y1;
+    if (invertY) {
+        swap = y0;
+        y0 = y1;
+        y1 = swap;
+    }
+
+    x1 -= x0;
+    y1 -= y0;
+
+    data[0] = x0 == 0 ? 1 : x0;
+    data[1] = x1 == 0 ? 1 : x1;
+    data[2] = y0 == 0 ? 1 : y0;
+    data[3] = y1 == 0 ? 1 : y1;
+    data[4] = rotate | (invertX << 1) | (invertY << 2);
+}
+
+/**
+ * @brief Draw (or with the background colour, erase) the arrow pointing into a corner.
+ * 
+ */
+static void drawMarker(TFT_eSPI *gfx, uint8_t corner, uint16_t color) {
+    int32_t x = (corner & 2) ? gfx->width() - 1 : 0;
+    int32_t y = (corner & 1) ? gfx->height() - 1 : 0;
+    int32_t dx = (corner & 2) ? -TOUCH_CAL_MARKER : TOUCH_CAL_MARKER;
+    int32_t dy = (corner & 1) ? -TOUCH_CAL_MARKER : TOUCH_CAL_MARKER;
+
+    gfx->drawLine(x, y, x + dx, y, color);
+    gfx->drawLine(x, y, x, y + dy, color);
+    gfx->drawLine(x, y, x + dx, y + dy, color);
+}
@@ -0,0 +1,146 @@
+/*
+    Touch sample filtering and gesture recognition, see touchGesture.h
+*/
+
+#include <stdlib.h>
+#include "touchGesture.h"
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c);
+
+TouchGestureEngine::TouchGestureEngine() {
+    rawCount = 0;
+    filteredX = filteredY = 0;
+    startX = startY = 0;
+    startTime = lastDownTime = 0;
+    down = longPressSent = moved = false;
+}
+
+/**
+ * @brief Feed in the next touch sample.
+ * 
+ * @param x Screen x, ignored on pen up
+ * @param y Screen y, ignored on pen up
+ * @param time Time the sample was taken (ms)
+ * @param penDown false for the pen up sample ending a touch
+ * @param gesture Filled in when a gesture is recognised
+ * @return true A gesture was recognised
+ */
+bool TouchGestureEngine::update(uint16_t x, uint16_t y, uint32_t time, bool penDown, touchGesture_t *gesture) {
+    uint16_t fx, fy;
+    int dx, dy;
+
+    if (penDown) {
+        if (!down) {
+            down = true;
+            longPressSent = moved = false;
+            rawCount = 0;
+            startTime = time;
+        }
+        lastDownTime = time;
+
+        filter(x, y, &fx, &fy);
+        if (rawCount == 1) {
+            startX = fx;
+            startY = fy;
+        }
+
+        dx = (int)fx - startX;
+        dy = (int)fy - startY;
+        if (abs(dx) > TOUCH_TAP_MOVE || abs(dy) > TOUCH_TAP_MOVE)
+            moved = true;
+
+        if (!moved && !longPressSent && time - startTime >= TOUCH_LONG_PRESS_TIME) {
+            longPressSent = true;
+            gesture->type = TOUCH_LONG_PRESS;
+            gesture->x = startX;
+            gesture->y = startY;
+            gesture->start = startTime;
+            gesture->time = time;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Pen up, the last filtered position is where the touch ended
+    if (!down)
+        return false;
+    down = false;
+
+    // The pen up sample comes TOUCH_RELEASE_SAMPLES missed reads after the pen went up,
+    // so time it by the pen down samples, a one sample glitch is then 0 ms long
+    if (longPressSent || lastDownTime - startTime < TOUCH_DEBOUNCE_TIME)
+        return false;
+
+    dx = (filteredX >> TOUCH_IIR_SHIFT) - startX;
+    dy = (filteredY >> TOUCH_IIR_SHIFT) - startY;
+
+    if (abs(dx) >= TOUCH_SWIPE_DISTANCE || abs(dy) >= TOUCH_SWIPE_DISTANCE) {
+        if (abs(dx) >= abs(dy))
+            gesture->type = dx < 0 ? TOUCH_SWIPE_LEFT : TOUCH_SWIPE_RIGHT;
+        else
+            gesture->type = dy < 0 ? TOUCH_SWIPE_UP : TOUCH_SWIPE_DOWN;
+    } else if (!moved) {
+        gesture->type = TOUCH_TAP;
+    } else {
+        return false;       // wandered, neither a tap nor a swipe
+    }
+
+    gesture->x = startX;
+    gesture->y = startY;
+    gesture->start = startTime;
+    gesture->time = time;
+    return true;
+}
+
+/**
+ * @brief Median of the last three samples followed by an IIR filter. Until there are
+ * three samples the median is skipped so the first sample is used straight away.
+ * 
+ */
+void TouchGestureEngine::filter(uint16_t x, uint16_t y, uint16_t *outX, uint16_t *outY) {
+    uint16_t mx, my;
+
+    if (rawCount < 3) {
+        rawX[rawCount] = x;
+        rawY[rawCount] = y;
+        rawCount++;
+    } else {
+        rawX[0] = rawX[1];
+        rawX[1] = rawX[2];
+        rawX[2] = x;
+        rawY[0] = rawY[1];
+        rawY[1] = rawY[2];
+        rawY[2] = y;
+    }
+
+    if (rawCount < 3) {
+        mx = x;
+        my = y;
+    } else {
+        mx = median3(rawX[0], rawX[1], rawX[2]);
+        my = median3(rawY[0], rawY[1], rawY[2]);
+    }
+
+    if (rawCount == 1) {
+        filteredX = (int32_t)mx << TOUCH_IIR_SHIFT;
+        filteredY = (int32_t)my << TOUCH_IIR_SHIFT;
+    } else {
+        filteredX += mx - (filteredX >> TOUCH_IIR_SHIFT);
+        filteredY += my - (filteredY >> TOUCH_IIR_SHIFT);
+    }
+
+    *outX = filteredX >> TOUCH_IIR_SHIFT;
+    *outY = filteredY >> TOUCH_IIR_SHIFT;
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+    if (a > b) {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b > c)
+        b = c;
+    return a > b ? a : b;
+}
@@ -0,0 +1,161 @@
+/*
+    Touch input pipeline, see touchInput.h
+*/
+
+#include "esp_attr.h"
+#include "touchInput.h"
+
+static const touchSource_t *touchSource = NULL;
+static QueueHandle_t touchQueue = NULL;
+static volatile TaskHandle_t touchTaskHandle = NULL;   // Read by the T_IRQ handler
+static bool touchIrqDriven = false;
+static volatile uint32_t overruns = 0;     // samples dropped because the queue was full
+
+static void touchTask(void *parameter);
+static void queueSample(const touchSample_t *sample, TickType_t wait);
+
+/**
+ * @brief Start the touch reader task.
+ * 
+ * @param source How to read the touch controller
+ * @param irqDriven true if touchInputIrq()/touchInputIrqFromISR() will be called on pen
+ * down, false to poll every TOUCH_POLL_INTERVAL
+ * @return true Reader task running
+ */
+bool touchInputBegin(const touchSource_t *source, bool irqDriven) {
+    TaskHandle_t task = NULL;
+
+    touchSource = source;
+    touchIrqDriven = irqDriven;
+
+    if (touchQueue == NULL)
+        touchQueue = xQueueCreate(TOUCH_QUEUE_LENGTH, sizeof(touchSample_t));
+    else
+        xQueueReset(touchQueue);
+    if (touchQueue == NULL)
+        return false;
+
+    if (xTaskCreatePinnedToCore(touchTask, "touchTask", TOUCH_TASK_STACK, NULL, TOUCH_TASK_PRIORITY, &task, TOUCH_TASK_CORE) != pdPASS)
+        return false;
+    touchTaskHandle = task;
+
+    return true;
+}
+
+/**
+ * @brief Stop the reader task. The queue is kept for the next touchInputBegin().
+ * 
+ */
+void touchInputEnd(void) {
+    TaskHandle_t task = touchTaskHandle;
+
+    touchTaskHandle = NULL;         // before the delete, so the IRQ can't notify a deleted task
+    if (task != NULL)
+        vTaskDelete(task);
+}
+
+/**
+ * @brief Pen down, wake the reader task. Task context, e.g. a simulated IRQ.
+ * 
+ */
+void touchInputIrq(void) {
+    TaskHandle_t task = touchTaskHandle;
+
+    if (task != NULL)
+        xTaskNotifyGive(task);
+}
+
+/**
+ * @brief Pen down, wake the reader task. Call from the T_IRQ interrupt handler. In IRAM
+ * as the GPIO interrupt is, so a pen edge while the flash cache is off (NVS writes) is
+ * safe. It only reads a variable in DRAM and calls the FreeRTOS ISR functions, which
+ * ESP-IDF keeps in IRAM.
+ * 
+ */
+void IRAM_ATTR touchInputIrqFromISR(void) {
+    BaseType_t woken = pdFALSE;
+    TaskHandle_t task = touchTaskHandle;
+
+    if (task != NULL) {
+        vTaskNotifyGiveFromISR(task, &woken);
+        if (woken == pdTRUE)
+            portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * @brief Get the next touch sample, never blocks.
+ * 
+ * @param sample Filled in with the oldest queued sample
+ * @return true A sample was available
+ */
+bool touchInputRead(touchSample_t *sample) {
+    if (touchQueue == NULL)
+        return false;
+
+    return xQueueReceive(touchQueue, sample, 0) == pdTRUE;
+}
+
+/**
+ * @brief Number of samples dropped because the display task did not keep up.
+ * 
+ */
+uint32_t touchInputOverruns(void) {
+    return overruns;
+}
+
+/**
+ * @brief Reader task, sleeps until the pen goes down then samples until it's lifted
+ * and queues a pen up sample to end the touch.
+ * 
+ */
+static void touchTask(void *parameter) {
+    touchSample_t sample;
+    uint8_t missed;
+    bool down;
+
+    for ( ;; ) {
+        if (touchIrqDriven) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(TOUCH_POLL_INTERVAL));
+        }
+
+        down = false;
+        missed = 0;
+        while (missed < TOUCH_RELEASE_SAMPLES) {
+            if (touchSource->read(&sample)) {
+                sample.down = true;
+                queueSample(&sample, 0);
+                down = true;
+                missed = 0;
+            } else if (!down) {
+                break;          // IRQ glitch or nothing touched while polling
+            } else {
+                missed++;
+            }
+            vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_INTERVAL));
+        }
+
+        if (down) {
+            sample.down = false;
+            sample.time = touchSource->now();
+            queueSample(&sample, pdMS_TO_TICKS(TOUCH_POLL_INTERVAL));   // try harder not to lose the end of a touch
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Queue a sample and let the consumer know.
+ * 
+ * @param sample Sample to queue
+ * @param wait Ticks to wait for space before dropping the sample
+ */
+static void queueSample(const touchSample_t *sample, TickType_t wait) {
+    if (xQueueSend(touchQueue, sample, wait) != pdTRUE)
+        overruns++;
+
+    if (touchSource->notify != NULL)
+        touchSource->notify();
+}
@@ -0,0 +1,80 @@
+/*
+    Minimal XPT2046 touch controller driver, see xpt2046.h
+*/
+
+#include "xpt2046.h"
+
+#define XPT2046_CMD_X  0xD0     // Conversion commands, 12 bit differential, power down between
+#define XPT2046_CMD_Y  0x90
+#define XPT2046_CMD_Z1 0xB0
+#define XPT2046_CMD_Z2 0xC0
+
+XPT2046::XPT2046(uint8_t spiHost, int8_t sclk, int8_t miso, int8_t mosi, int8_t cs) : spi(spiHost) {
+    sclkPin = sclk;
+    misoPin = miso;
+    mosiPin = mosi;
+    csPin = cs;
+}
+
+void XPT2046::begin(void) {
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+    spi.begin(sclkPin, misoPin, mosiPin, -1);
+}
+
+/**
+ * @brief Read the touch pressure, same scale as TFT_eSPI::getTouchRawZ().
+ * 
+ * @return uint16_t Pressure, 0 when not touched
+ */
+uint16_t XPT2046::readZ(void) {
+    int16_t z = 0xFFF;
+
+    spi.beginTransaction(SPISettings(XPT2046_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(csPin, LOW);
+    spi.transfer(XPT2046_CMD_Z1);
+    z += spi.transfer16(XPT2046_CMD_Z2) >> 3;
+    z -= spi.transfer16(0x00) >> 3;
+    digitalWrite(csPin, HIGH);
+    spi.endTransaction();
+
+    return z == 0xFFF ? 0 : z;
+}
+
+/**
+ * @brief Read the raw touch position, same as TFT_eSPI::getTouchRaw(). Each axis is
+ * converted several times and the last conversion kept to let the reading settle.
+ * 
+ * @param x Raw x
+ * @param y Raw y
+ */
+void XPT2046::readXY(uint16_t *x, uint16_t *y) {
+    uint16_t tmp;
+
+    spi.beginTransaction(SPISettings(XPT2046_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(csPin, LOW);
+
+    spi.transfer(XPT2046_CMD_X);
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_X);
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_X);
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_X);
+    tmp = spi.transfer(0) << 5;
+    tmp |= 0x1f & (spi.transfer(XPT2046_CMD_Y) >> 3);
+    *x = tmp;
+
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_Y);
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_Y);
+    spi.transfer(0);
+    spi.transfer(XPT2046_CMD_Y);
+    tmp = spi.transfer(0) << 5;
+    tmp |= 0x1f & (spi.transfer(0) >> 3);
+    *y = tmp;
+
+    digitalWrite(csPin, HIGH);
+    spi.endTransaction();
+}
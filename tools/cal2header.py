@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""
+Bake touch screen calibration into the firmware.
+
+Reads a captured Serial log (or any text file) containing the line printed after an
+on-screen calibration, e.g.
+
+    Touch calibration: 367,3293,250,3410,7
+
+and writes include/touchCalBaked.h which touchCalibration.cpp picks up automatically. The
+last matching line in the file is used, a line of just the 5 values also works.
+
+    python tools/cal2header.py serial.log
+    python tools/cal2header.py - < serial.log
+"""
+
+import argparse
+import os
+import re
+import sys
+
+PATTERN = re.compile(r"^(?:.*Touch calibration:)?\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*$")
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(__file__), "..", "include", "touchCalBaked.h")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="file containing the calibration line, - for stdin")
+    parser.add_argument("-o", "--output", default=DEFAULT_OUTPUT, help="header to write")
+    args = parser.parse_args()
+
+    source = sys.stdin if args.input == "-" else open(args.input)
+    values = None
+    with source:
+        for line in source:
+            match = PATTERN.match(line.strip())
+            if match:
+                values = [int(v) for v in match.groups()]
+
+    if values is None:
+        sys.exit("no calibration line found in %s" % args.input)
+    if any(v > 0xFFFF for v in values) or values[4] > 7:
+        sys.exit("calibration values out of range: %s" % values)
+
+    with open(args.output, "w") as f:
+        f.write("// Generated by tools/cal2header.py, do not edit\n")
+        f.write("#define TOUCH_CAL_BAKED {%s}\n" % ", ".join(str(v) for v in values))
+
+    print("%s: %s" % (os.path.normpath(args.output), ",".join(str(v) for v in values)))
+
+
+if __name__ == "__main__":
+    main()
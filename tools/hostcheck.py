@@ -0,0 +1,23 @@
+"""
+PlatformIO post-build script for env:native (see platformio.ini). Runs the host program
+after every build, so a frame that differs from src/host/golden.txt, a scenario over its
+budget or a failed check fails `pio run -e native` instead of waiting for someone to run it.
+
+The program is run from the project directory, where it finds the golden file, and saves
+its images and SPI profile in the build directory.
+"""
+
+import subprocess
+
+Import("env")
+
+
+def run_host_checks(source, target, env):
+    program = target[0].get_abspath()
+    result = subprocess.run([program, env.subst("$BUILD_DIR")], cwd=env.subst("$PROJECT_DIR"))
+    if result.returncode != 0:
+        print("Host checks failed, see the output above")
+    return result.returncode
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}${PROGSUFFIX}", run_host_checks)
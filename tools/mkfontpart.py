@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Build the image for the "fonts" partition (see partitions.csv and include/fontPartition.h)
+from one or more .vlw smooth font files created with the TFT_eSPI Create_font sketch.
+
+    python tools/mkfontpart.py -o fonts.bin value=NotoSans-16.vlw total=NotoSans-26.vlw
+    esptool.py --chip esp32 write_flash 0x290000 fonts.bin
+
+Keep the fonts small by only including the characters that are drawn with them,
+for the live values that is "0123456789.-kWh".
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x50574C56          # "VLWP"
+VERSION = 1
+NAME_LENGTH = 16
+PARTITION_SIZE = 0x40000    # Must match the fonts entry in partitions.csv
+HEADER = struct.Struct("<IHH")
+ENTRY = struct.Struct("<%dsII" % NAME_LENGTH)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", default="fonts.bin", help="partition image to write")
+    parser.add_argument("fonts", nargs="+", metavar="name=file.vlw", help="font name and .vlw file")
+    args = parser.parse_args()
+
+    fonts = []
+    for spec in args.fonts:
+        name, sep, path = spec.partition("=")
+        if not sep or not name or len(name) >= NAME_LENGTH:
+            sys.exit("bad font spec '%s', expected name=file.vlw (name < %d chars)" % (spec, NAME_LENGTH))
+        with open(path, "rb") as f:
+            fonts.append((name, f.read()))
+
+    offset = HEADER.size + ENTRY.size * len(fonts)
+    table = HEADER.pack(MAGIC, VERSION, len(fonts))
+    data = b""
+    for name, vlw in fonts:
+        padding = (-offset) % 4     # keep each font word aligned
+        data += b"\0" * padding + vlw
+        table += ENTRY.pack(name.encode("ascii"), offset + padding, len(vlw))
+        offset += padding + len(vlw)
+
+    image = table + data
+
+    if len(image) > PARTITION_SIZE:
+        sys.exit("fonts are %d bytes, partition is only %d bytes" % (len(image), PARTITION_SIZE))
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print("%s: %d font(s), %d of %d bytes used" % (args.output, len(fonts), len(image), PARTITION_SIZE))
+
+
+if __name__ == "__main__":
+    main()